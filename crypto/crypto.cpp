@@ -31,7 +31,8 @@ namespace
     const std::string PRIV_KEY_SUFFIX{"\n-----END EC PRIVATE KEY-----"};
 }
 
-crypto::crypto(const std::string& private_key)
+crypto::crypto(const std::string& private_key, size_t key_cache_size)
+    : key_cache_size(key_cache_size)
 {
     LOG(info) << "Using " << SSLeay_version(SSLEAY_VERSION);
     this->load_private_key(private_key);
@@ -88,15 +89,82 @@ crypto::deterministic_serialize(const bzn_envelope& msg)
     return result;
 }
 
-bool
-crypto::verify(const bzn_envelope& msg)
+std::shared_ptr<EVP_PKEY>
+crypto::parse_public_key(const std::string& sender)
 {
     BIO_ptr_t bio(BIO_new(BIO_s_mem()), &BIO_free);
     EC_KEY_ptr_t pubkey(nullptr, &EC_KEY_free);
     EVP_PKEY_ptr_t key(EVP_PKEY_new(), &EVP_PKEY_free);
-    EVP_MD_CTX_ptr_t context(EVP_MD_CTX_create(), &EVP_MD_CTX_free);
 
-    if (!bio || !key || !context)
+    if (!bio || !key)
+    {
+        LOG(error) << "failed to allocate memory for public key";
+        return nullptr;
+    }
+
+    bool result =
+            // Reconstruct the PEM file in memory (this is awkward, but it avoids dealing with EC specifics)
+            (0 < BIO_write(bio.get(), PEM_PREFIX.c_str(), PEM_PREFIX.length()))
+            && (0 < BIO_write(bio.get(), sender.c_str(), sender.length()))
+            && (0 < BIO_write(bio.get(), PEM_SUFFIX.c_str(), PEM_SUFFIX.length()))
+
+            // Parse the PEM string to get the public key the message is allegedly from
+            && (pubkey = EC_KEY_ptr_t(PEM_read_bio_EC_PUBKEY(bio.get(), NULL, NULL, NULL), &EC_KEY_free))
+            && (1 == EC_KEY_check_key(pubkey.get()))
+            && (1 == EVP_PKEY_set1_EC_KEY(key.get(), pubkey.get()));
+
+    if (!result)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<EVP_PKEY>(key.release(), &EVP_PKEY_free);
+}
+
+std::shared_ptr<EVP_PKEY>
+crypto::get_public_key(const std::string& sender)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->key_cache_mutex);
+
+        if (auto it = this->key_cache.find(sender); it != this->key_cache.end())
+        {
+            this->key_cache_order.splice(this->key_cache_order.begin(), this->key_cache_order, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    // only keys that parsed and passed EC_KEY_check_key are cached, so a bad sender is rejected every time
+    auto key = this->parse_public_key(sender);
+    if (!key || !this->key_cache_size)
+    {
+        return key;
+    }
+
+    std::lock_guard<std::mutex> lock(this->key_cache_mutex);
+
+    if (this->key_cache.find(sender) == this->key_cache.end())
+    {
+        if (this->key_cache.size() >= this->key_cache_size)
+        {
+            this->key_cache.erase(this->key_cache_order.back());
+            this->key_cache_order.pop_back();
+        }
+
+        this->key_cache_order.push_front(sender);
+        this->key_cache.emplace(sender, key_cache_entry_t{key, this->key_cache_order.begin()});
+    }
+
+    return key;
+}
+
+bool
+crypto::verify(const bzn_envelope& msg)
+{
+    // the digest context is reset and reused rather than allocated for every message
+    static thread_local EVP_MD_CTX_ptr_t context(EVP_MD_CTX_create(), &EVP_MD_CTX_free);
+
+    if (!context)
     {
         LOG(error) << "failed to allocate memory for signature verification";
         return false;
@@ -109,16 +177,11 @@ crypto::verify(const bzn_envelope& msg)
     std::string signature = msg.signature();
     char* sig_ptr = signature.data();
 
-    bool result =
-            // Reconstruct the PEM file in memory (this is awkward, but it avoids dealing with EC specifics)
-            (0 < BIO_write(bio.get(), PEM_PREFIX.c_str(), PEM_PREFIX.length()))
-            && (0 < BIO_write(bio.get(), msg.sender().c_str(), msg.sender().length()))
-            && (0 < BIO_write(bio.get(), PEM_SUFFIX.c_str(), PEM_SUFFIX.length()))
+    auto key = this->get_public_key(msg.sender());
 
-            // Parse the PEM string to get the public key the message is allegedly from
-            && (pubkey = EC_KEY_ptr_t(PEM_read_bio_EC_PUBKEY(bio.get(), NULL, NULL, NULL), &EC_KEY_free))
-            && (1 == EC_KEY_check_key(pubkey.get()))
-            && (1 == EVP_PKEY_set1_EC_KEY(key.get(), pubkey.get()))
+    bool result =
+            (bool) (key)
+            && (1 == EVP_MD_CTX_reset(context.get()))
 
             // Perform the signature validation
             && (1 == EVP_DigestVerifyInit(context.get(), NULL, EVP_sha256(), NULL, key.get()))
@@ -20,6 +20,9 @@
 #include <proto/bluzelle.pb.h>
 #include <openssl/evp.h>
 #include <openssl/ec.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 namespace bzapi
 {
@@ -27,7 +30,10 @@ namespace bzapi
     {
     public:
 
-        crypto(const std::string& private_key);
+        static const size_t DEFAULT_KEY_CACHE_SIZE = 64;
+
+        // parsed public keys are cached by sender, up to key_cache_size entries (0 disables the cache)
+        crypto(const std::string& private_key, size_t key_cache_size = DEFAULT_KEY_CACHE_SIZE);
 
         bool sign(bzn_envelope& msg) override;
 
@@ -48,7 +54,19 @@ namespace bzapi
 
         bool load_private_key(const std::string& key);
 
+        std::shared_ptr<EVP_PKEY> parse_public_key(const std::string& sender);
+
+        std::shared_ptr<EVP_PKEY> get_public_key(const std::string& sender);
+
         EVP_PKEY_ptr_t private_key_EVP = EVP_PKEY_ptr_t(nullptr, &EVP_PKEY_free);
+
+        // validated public keys by sender, least recently used at the back
+        using key_cache_entry_t = std::pair<std::shared_ptr<EVP_PKEY>, std::list<std::string>::iterator>;
+
+        const size_t key_cache_size;
+        std::list<std::string> key_cache_order;
+        std::unordered_map<std::string, key_cache_entry_t> key_cache;
+        std::mutex key_cache_mutex;
     };
 }
 
@@ -0,0 +1,141 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <crypto/crypto.hpp>
+#include <gtest/gtest.h>
+#include <proto/bluzelle.pb.h>
+#include <chrono>
+
+using namespace ::testing;
+using namespace bzapi;
+
+namespace
+{
+    const char* priv_key = "MHQCAQEEIBWDWE/MAwtXaFQp6d2Glm2Uj7ROBlDKFn5RwqQsDEbyoAcGBSuBBAAK\n"
+                           "oUQDQgAEiykQ5A02u+02FR1nftxT5VuUdqLO6lvNoL5aAIyHvn8NS0wgXxbPfpuq\n"
+                           "UPpytiopiS5D+t2cYzXJn19MQmnl/g==";
+
+    const char* pub_key = "MFYwEAYHKoZIzj0CAQYFK4EEAAoDQgAEiykQ5A02u+02FR1nftxT5VuUdqLO6lvN\n"
+                          "oL5aAIyHvn8NS0wgXxbPfpuqUPpytiopiS5D+t2cYzXJn19MQmnl/g==";
+
+    const char* other_priv_key = "MHQCAQEEIL1Un62C5n8eP5fHygYddTCmCm3vd6ZqMiUi/L7b0j1RoAcGBSuBBAAK\n"
+                                 "oUQDQgAEtb34PGps5InV3mv5fSsm72fEUnIoWxV2Z8TWFMBa1Pj6gn2eKYMz64FY\n"
+                                 "g3DatpmdB0dZFM8RouE2Jvqw2oVWSQ==";
+
+    const char* other_pub_key = "MFYwEAYHKoZIzj0CAQYFK4EEAAoDQgAEtb34PGps5InV3mv5fSsm72fEUnIoWxV2\n"
+                                "Z8TWFMBa1Pj6gn2eKYMz64FYg3DatpmdB0dZFM8RouE2Jvqw2oVWSQ==";
+
+    bzn_envelope
+    make_signed_envelope(crypto& signer, const std::string& sender, const std::string& payload)
+    {
+        bzn_envelope env;
+        env.set_sender(sender);
+        env.set_database_response(payload);
+        env.set_timestamp(1234);
+        signer.sign(env);
+
+        return env;
+    }
+}
+
+
+TEST(verify_test, verifies_with_cold_and_warm_key_cache)
+{
+    crypto c(priv_key);
+    auto env = make_signed_envelope(c, pub_key, "payload");
+
+    EXPECT_TRUE(c.verify(env));
+    EXPECT_TRUE(c.verify(env));
+
+    // a cached key must not make a tampered message pass
+    env.set_database_response("tampered");
+    EXPECT_FALSE(c.verify(env));
+}
+
+
+TEST(verify_test, bad_sender_is_rejected_every_time)
+{
+    crypto c(priv_key);
+    auto env = make_signed_envelope(c, pub_key, "payload");
+    env.set_sender("not a public key");
+
+    EXPECT_FALSE(c.verify(env));
+    EXPECT_FALSE(c.verify(env));
+}
+
+
+TEST(verify_test, wrong_sender_fails_with_cached_keys)
+{
+    crypto c(priv_key);
+    crypto other(other_priv_key);
+
+    auto env = make_signed_envelope(c, pub_key, "payload");
+    auto other_env = make_signed_envelope(other, other_pub_key, "payload");
+    EXPECT_TRUE(c.verify(env));
+    EXPECT_TRUE(c.verify(other_env));
+
+    // both keys are now cached; claiming the other sender must still fail
+    env.set_sender(other_pub_key);
+    EXPECT_FALSE(c.verify(env));
+}
+
+
+TEST(verify_test, evicted_keys_still_verify)
+{
+    crypto c(priv_key, 1);
+    crypto other(other_priv_key);
+
+    auto env = make_signed_envelope(c, pub_key, "payload");
+    auto other_env = make_signed_envelope(other, other_pub_key, "payload");
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_TRUE(c.verify(env));
+        EXPECT_TRUE(c.verify(other_env));
+    }
+
+    crypto uncached(priv_key, 0);
+    EXPECT_TRUE(uncached.verify(env));
+    EXPECT_TRUE(uncached.verify(other_env));
+}
+
+
+TEST(verify_test, DISABLED_verify_perf_test)
+{
+    const size_t ITERATIONS = 5000;
+
+    crypto cold(priv_key, 0);
+    crypto warm(priv_key);
+    auto env = make_signed_envelope(warm, pub_key, std::string(256, 'x'));
+
+    auto run = [&](crypto& c)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ITERATIONS; i++)
+        {
+            EXPECT_TRUE(c.verify(env));
+        }
+
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        return (ITERATIONS * 1000000.0) / std::max<int64_t>(us, 1);
+    };
+
+    auto cold_rate = run(cold);
+    auto warm_rate = run(warm);
+
+    std::cout << "cold key cache: " << cold_rate << " verifications/second" << std::endl;
+    std::cout << "warm key cache: " << warm_rate << " verifications/second" << std::endl;
+}
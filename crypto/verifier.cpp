@@ -0,0 +1,55 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <include/bluzelle.hpp>
+#include <crypto/verifier.hpp>
+#include <boost/asio/post.hpp>
+
+using namespace bzapi;
+
+verifier::verifier(std::shared_ptr<crypto_base> crypto, size_t threads)
+    : crypto(std::move(crypto)), pool(threads)
+{
+    LOG(info) << "Verifying signatures on " << threads << " threads";
+}
+
+verifier::~verifier()
+{
+    this->stop();
+}
+
+void
+verifier::verify(std::shared_ptr<const bzn_envelope> msg, verify_handler_t handler)
+{
+    boost::asio::post(this->pool, [crypto = this->crypto, msg = std::move(msg), handler = std::move(handler)]()
+    {
+        bool valid = false;
+        try
+        {
+            valid = crypto->verify(*msg);
+        }
+        CATCHALL();
+
+        handler(valid);
+    });
+}
+
+void
+verifier::stop()
+{
+    this->pool.stop();
+    this->pool.join();
+}
@@ -0,0 +1,46 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <crypto/crypto_base.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <functional>
+#include <memory>
+
+namespace bzapi
+{
+    // verifies message signatures on a pool of worker threads so the io thread(s) aren't
+    // held up by ECDSA. the handler is invoked on a worker thread; callers are responsible
+    // for getting back onto their own strand.
+    class verifier
+    {
+    public:
+        using verify_handler_t = std::function<void(bool valid)>;
+
+        verifier(std::shared_ptr<crypto_base> crypto, size_t threads);
+
+        ~verifier();
+
+        void verify(std::shared_ptr<const bzn_envelope> msg, verify_handler_t handler);
+
+        void stop();
+
+    private:
+        const std::shared_ptr<crypto_base> crypto;
+        boost::asio::thread_pool pool;
+    };
+}
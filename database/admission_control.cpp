@@ -0,0 +1,256 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <database/admission_control.hpp>
+#include <algorithm>
+
+using namespace bzapi;
+
+admission_control::result
+admission_control::admit(group_t group, id_t id, const limits& limits, start_handler_t start)
+{
+    std::vector<start_handler_t> started;
+    std::vector<start_handler_t> expired;
+    result res;
+    {
+        std::scoped_lock<std::mutex> guard(this->lock);
+        this->current_limits = limits;
+
+        // requests already waiting go first, in case the limits have been raised
+        this->promote_waiting(started, expired);
+
+        if (this->has_room(group))
+        {
+            this->take(group);
+            res = result::admitted;
+        }
+        else if (limits.policy == overload_policy::fail_fast)
+        {
+            this->counters.rejected++;
+            res = result::rejected;
+        }
+        else
+        {
+            // blocking here could stall the thread that would make room, so block queues as well
+            this->waiting.push_back(waiter{group, id, std::move(start), std::chrono::steady_clock::now()});
+            this->note_waiting();
+            res = result::queued;
+        }
+    }
+
+    for (auto& e : expired)
+    {
+        e(false);
+    }
+
+    for (auto& s : started)
+    {
+        s(true);
+    }
+
+    return res;
+}
+
+bool
+admission_control::expire(id_t id)
+{
+    start_handler_t start;
+    {
+        std::scoped_lock<std::mutex> guard(this->lock);
+        if (!this->remove_waiter(id, start))
+        {
+            return false;
+        }
+
+        this->counters.rejected++;
+    }
+
+    if (start)
+    {
+        start(false);
+    }
+
+    return true;
+}
+
+bool
+admission_control::withdraw(id_t id)
+{
+    start_handler_t start;
+    std::scoped_lock<std::mutex> guard(this->lock);
+    return this->remove_waiter(id, start);
+}
+
+bool
+admission_control::wait_for_room(const limits& limits)
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->current_limits = limits;
+    if (this->has_room(nullptr))
+    {
+        return true;
+    }
+
+    this->blocked++;
+    this->note_waiting();
+    auto waited_from = std::chrono::steady_clock::now();
+    bool ready = this->room_available.wait_for(guard, limits.max_wait, [this]()
+    {
+        return this->has_room(nullptr);
+    });
+    this->blocked--;
+    this->record_wait(std::chrono::steady_clock::now() - waited_from);
+
+    if (!ready)
+    {
+        this->counters.rejected++;
+    }
+
+    return ready;
+}
+
+void
+admission_control::release(group_t group)
+{
+    std::vector<start_handler_t> started;
+    std::vector<start_handler_t> expired;
+    {
+        std::scoped_lock<std::mutex> guard(this->lock);
+
+        auto it = this->group_requests.find(group);
+        if (it != this->group_requests.end() && --it->second == 0)
+        {
+            this->group_requests.erase(it);
+        }
+
+        if (this->counters.in_flight)
+        {
+            this->counters.in_flight--;
+        }
+
+        this->promote_waiting(started, expired);
+    }
+
+    this->room_available.notify_all();
+
+    for (auto& e : expired)
+    {
+        e(false);
+    }
+
+    for (auto& s : started)
+    {
+        s(true);
+    }
+}
+
+admission_control::stats
+admission_control::get_stats()
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+    auto result = this->counters;
+    result.waiting = this->waiting.size() + this->blocked;
+    return result;
+}
+
+bool
+admission_control::has_room(group_t group) const
+{
+    if (this->current_limits.max_requests && this->counters.in_flight >= this->current_limits.max_requests)
+    {
+        return false;
+    }
+
+    if (!group || !this->current_limits.max_group_requests)
+    {
+        return true;
+    }
+
+    auto it = this->group_requests.find(group);
+    return it == this->group_requests.end() || it->second < this->current_limits.max_group_requests;
+}
+
+void
+admission_control::take(group_t group)
+{
+    this->counters.in_flight++;
+    this->counters.admitted++;
+    this->group_requests[group]++;
+}
+
+void
+admission_control::record_wait(std::chrono::steady_clock::duration wait)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(wait);
+    this->counters.delayed++;
+    this->counters.total_wait += us;
+    this->counters.max_wait = std::max(this->counters.max_wait, us);
+}
+
+void
+admission_control::note_waiting()
+{
+    this->counters.max_waiting = std::max<uint64_t>(this->counters.max_waiting, this->waiting.size() + this->blocked);
+}
+
+void
+admission_control::promote_waiting(std::vector<start_handler_t>& started, std::vector<start_handler_t>& expired)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    // the queue is in arrival order, so only the front can have waited too long
+    while (!this->waiting.empty() && now - this->waiting.front().queued > this->current_limits.max_wait)
+    {
+        this->record_wait(now - this->waiting.front().queued);
+        this->counters.rejected++;
+        expired.push_back(std::move(this->waiting.front().start));
+        this->waiting.pop_front();
+    }
+
+    // start whatever now fits, skipping requests for groups that are still full
+    for (auto w = this->waiting.begin(); w != this->waiting.end() && this->has_room(nullptr);)
+    {
+        if (!this->has_room(w->group))
+        {
+            ++w;
+            continue;
+        }
+
+        this->take(w->group);
+        this->record_wait(now - w->queued);
+        started.push_back(std::move(w->start));
+        w = this->waiting.erase(w);
+    }
+}
+
+bool
+admission_control::remove_waiter(id_t id, start_handler_t& start)
+{
+    auto it = std::find_if(this->waiting.begin(), this->waiting.end(), [id](const waiter& w)
+    {
+        return w.id == id;
+    });
+
+    if (it == this->waiting.end())
+    {
+        return false;
+    }
+
+    this->record_wait(std::chrono::steady_clock::now() - it->queued);
+    start = std::move(it->start);
+    this->waiting.erase(it);
+    return true;
+}
@@ -0,0 +1,108 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <include/bluzelle.hpp>
+#include <include/bzapi.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace bzapi
+{
+    // limits the number of requests in flight, overall and per group (swarm). requests over the limits
+    // are queued or rejected, according to the overload policy. admit never blocks, as it's called from
+    // network threads; the block policy queues there, and callers that may block wait in wait_for_room first
+    class admission_control
+    {
+    public:
+        using group_t = const void*;
+        using id_t = uint64_t;
+
+        // called with true when a queued request may go ahead, or false if it waited too long
+        using start_handler_t = std::function<void(bool admitted)>;
+
+        enum class result { admitted, queued, rejected };
+
+        struct limits
+        {
+            // 0 for no limit
+            size_t max_requests = 0;
+            size_t max_group_requests = 0;
+            overload_policy policy = overload_policy::queue;
+            std::chrono::milliseconds max_wait{0};
+        };
+
+        struct stats
+        {
+            uint64_t in_flight = 0;
+            uint64_t waiting = 0;
+            uint64_t max_waiting = 0;
+            uint64_t admitted = 0;
+            uint64_t delayed = 0;
+            uint64_t rejected = 0;
+            std::chrono::microseconds total_wait{0};
+            std::chrono::microseconds max_wait{0};
+        };
+
+        // ask to start a request. if queued, start is called once there's room (or the wait is too long)
+        result admit(group_t group, id_t id, const limits& limits, start_handler_t start);
+
+        // a request admitted for group has finished, which may let waiting ones go ahead
+        void release(group_t group);
+
+        // give up on a queued request that has waited too long, calling its start handler with false.
+        // returns false if it isn't waiting
+        bool expire(id_t id);
+
+        // forget a queued request without starting it. returns false if it isn't waiting
+        bool withdraw(id_t id);
+
+        // block until the overall limit has room, or max_wait passes. doesn't take the room, so the
+        // request that follows may still be queued. returns false if the wait was too long
+        bool wait_for_room(const limits& limits);
+
+        stats get_stats();
+
+    private:
+        struct waiter
+        {
+            group_t group;
+            id_t id;
+            start_handler_t start;
+            std::chrono::steady_clock::time_point queued;
+        };
+
+        std::mutex lock;
+        std::condition_variable room_available;
+        limits current_limits;
+        std::unordered_map<group_t, size_t> group_requests;
+        std::deque<waiter> waiting;
+        size_t blocked = 0;
+        stats counters;
+
+        bool has_room(group_t group) const;
+        void take(group_t group);
+        void record_wait(std::chrono::steady_clock::duration wait);
+        void note_waiting();
+        void promote_waiting(std::vector<start_handler_t>& started, std::vector<start_handler_t>& expired);
+        bool remove_waiter(id_t id, start_handler_t& start);
+    };
+}
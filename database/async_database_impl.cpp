@@ -24,11 +24,39 @@ namespace bzapi
     std::shared_ptr<mutable_response> make_response();
 }
 
+namespace
+{
+    // number of requests from a single batch allowed in flight at once
+    const size_t BATCH_PIPELINE_DEPTH{128};
+
+    const std::string&
+    read_value(const database_response& response)
+    {
+        return response.has_quick_read() ? response.quick_read().value() : response.read().value();
+    }
+}
+
 async_database_impl::async_database_impl(std::shared_ptr<db_dispatch_base> db_impl, std::shared_ptr<swarm_base> swarm, uuid_t uuid)
 : db_impl(db_impl), swarm(swarm), uuid(uuid)
 {
 }
 
+async_database_impl::~async_database_impl()
+{
+    if (auto old_cache = std::atomic_load(&this->cache))
+    {
+        this->release_cache(old_cache);
+    }
+
+    for (const auto& sub : this->subscriptions)
+    {
+        if (sub.second->nonce)
+        {
+            this->db_impl->unsubscribe(this->swarm, this->uuid, sub.first, sub.second->nonce);
+        }
+    }
+}
+
 void
 async_database_impl::open(completion_handler_t handler)
 {
@@ -52,54 +80,416 @@ async_database_impl::open(completion_handler_t handler)
     });
 }
 
-void
-async_database_impl::translate_swarm_response(const database_response& db_response, const boost::system::error_code& ec
-    , std::shared_ptr<mutable_response> resp
-    , std::function<void(const database_response& response)> handler)
+std::string
+async_database_impl::swarm_status()
 {
-    Json::Value result;
+    return this->swarm->get_status();
+}
+
+db_status
+async_database_impl::make_status(const database_response& db_response, const boost::system::error_code& ec)
+{
+    db_status status;
     if (ec)
     {
-        result["error"] = ec.message();
+        status.error = static_cast<int>(db_error::connection_error);
+        status.message = ec.message();
+    }
+    else if (db_response.has_error())
+    {
+        // TODO: propagate other error codes (e.g. timeout) here
+        status.error = static_cast<int>(db_error::database_error);
+        status.message = db_response.error().message();
+    }
+    else if (db_response.has_quick_read() && !db_response.quick_read().error().empty())
+    {
+        status.error = static_cast<int>(db_error::database_error);
+        status.message = db_response.quick_read().error();
+    }
+
+    return status;
+}
+
+bool
+async_database_impl::set_error_result(const db_status& status, const std::shared_ptr<mutable_response>& resp)
+{
+    if (status.ok())
+    {
+        return false;
+    }
+
+    Json::Value result;
+    result["error"] = status.message;
+    resp->set_result(result.toStyledString());
+    resp->set_error(status.error);
+    return true;
+}
+
+void
+async_database_impl::send_message_with_status(database_msg& msg, send_policy policy
+    , std::function<void(const db_status& status, const database_response& response)> handler)
+{
+    try
+    {
+        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, policy
+            , [handler](const database_response& response, const boost::system::error_code& ec)
+            {
+                handler(make_status(response, ec), response);
+            });
+    }
+    CATCHALL(handler(db_status{static_cast<int>(db_error::database_error), "exception sending request"}, database_response{}));
+}
+
+void
+async_database_impl::send_message_with_basic_response(database_msg& msg, std::shared_ptr<mutable_response> resp)
+{
+    this->send_message_with_status(msg, send_policy::normal, [resp](const auto& status, const auto& /*response*/)
+    {
+        basic_result(status, resp);
+    });
+}
+
+void
+async_database_impl::basic_result(const db_status& status, const std::shared_ptr<mutable_response>& resp)
+{
+    if (!set_error_result(status, resp))
+    {
+        Json::Value result;
+        result["result"] = 1;
         resp->set_result(result.toStyledString());
-        resp->set_error(static_cast<int>(db_error::connection_error));
+        resp->set_ready();
     }
-    else
+}
+
+void
+async_database_impl::send_read(database_msg& msg, const std::string& key, send_policy policy, value_handler_t handler)
+{
+    auto current_cache = std::atomic_load(&this->cache);
+    if (!current_cache)
     {
-        if (db_response.has_error())
+        this->send_message_with_status(msg, policy, [handler](const auto& status, const auto& response)
         {
-            result["error"] = db_response.error().message();
-            resp->set_result(result.toStyledString());
+            handler(status, read_value(response));
+        });
+        return;
+    }
 
-            // TODO: propagate other error codes (e.g. timeout) here
-            resp->set_error(static_cast<int>(db_error::database_error));
-        }
-        else
+    std::string value;
+    if (current_cache->get(key, value))
+    {
+        handler(db_status{}, value);
+        return;
+    }
+
+    read_cache::evicted_list evicted;
+    auto generation = current_cache->begin_read(key, evicted);
+    for (const auto& e : evicted)
+    {
+        this->db_impl->unsubscribe(this->swarm, this->uuid, e.first, e.second);
+    }
+
+    this->send_message_with_status(msg, policy
+        , [weak_this = weak_from_this(), current_cache, key, generation, handler](const auto& status, const auto& response)
+        {
+            if (status.ok())
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    strong_this->cache_value(current_cache, key, read_value(response), generation);
+                }
+            }
+            else
+            {
+                current_cache->abandon_read(key, generation);
+            }
+
+            handler(status, read_value(response));
+        });
+}
+
+void
+async_database_impl::send_write(database_msg& msg, const std::string& key, status_handler_t handler)
+{
+    // a cached copy is stale as soon as the write is sent, and must not be refilled by a read
+    // that raced with it before it was applied
+    this->invalidate_cached(key);
+    this->send_message_with_status(msg, send_policy::normal
+        , [weak_this = weak_from_this(), key, handler](const auto& status, const auto& /*response*/)
+        {
+            if (auto strong_this = weak_this.lock())
+            {
+                strong_this->invalidate_cached(key);
+            }
+
+            handler(status);
+        });
+}
+
+void
+async_database_impl::cache_value(const std::shared_ptr<read_cache>& current_cache, const std::string& key
+    , const std::string& value, uint64_t generation)
+{
+    auto result = current_cache->put(key, value, generation);
+    for (const auto& evicted : result.evicted)
+    {
+        this->db_impl->unsubscribe(this->swarm, this->uuid, evicted.first, evicted.second);
+    }
+
+    if (result.subscribe)
+    {
+        this->subscribe_for_cache(current_cache, key);
+    }
+}
+
+void
+async_database_impl::subscribe_for_cache(const std::shared_ptr<read_cache>& current_cache, const std::string& key)
+{
+    this->db_impl->subscribe(this->swarm, this->uuid, key
+        , [current_cache, key, db_impl = this->db_impl, swarm = this->swarm, uuid = this->uuid]
+            (const database_response& response, const boost::system::error_code& ec)
         {
-            handler(db_response);
+            if (ec || response.has_error())
+            {
+                LOG(debug) << "Unable to subscribe to key, it will not be cached: " << key;
+                current_cache->subscription_failed(key);
+                return;
+            }
+
+            if (!current_cache->subscription_active(key, response.header().nonce()))
+            {
+                // evicted or discarded while we were waiting
+                db_impl->unsubscribe(swarm, uuid, key, response.header().nonce());
+            }
         }
+        , [current_cache](const database_subscription_update& update)
+        {
+            current_cache->update(update.key(), update.seq());
+        });
+}
+
+void
+async_database_impl::invalidate_cached(const std::string& key)
+{
+    if (auto current_cache = std::atomic_load(&this->cache))
+    {
+        current_cache->invalidate(key);
     }
 }
 
-std::string
-async_database_impl::swarm_status()
+void
+async_database_impl::release_cache(const std::shared_ptr<read_cache>& old_cache)
 {
-    return this->swarm->get_status();
+    for (const auto& sub : old_cache->clear())
+    {
+        this->db_impl->unsubscribe(this->swarm, this->uuid, sub.first, sub.second);
+    }
 }
 
 void
-async_database_impl::send_message_with_basic_response(database_msg& msg, std::shared_ptr<mutable_response> resp)
+async_database_impl::set_read_cache(size_t max_keys, uint64_t max_age)
+{
+    auto new_cache = max_keys ? std::make_shared<read_cache>(max_keys, std::chrono::milliseconds(max_age)) : nullptr;
+    if (auto old_cache = std::atomic_exchange(&this->cache, new_cache))
+    {
+        this->release_cache(old_cache);
+    }
+}
+
+db_update
+async_database_impl::make_update(const database_subscription_update& update)
 {
-    this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::normal
-        , [resp](const database_response &response, const boost::system::error_code &error)
+    db_update result;
+    result.key = update.key();
+    result.value = update.value();
+    result.op = update.operation() == database_subscription_update::DELETE
+        ? db_update::operation::remove : db_update::operation::update;
+    result.seq = update.seq();
+    return result;
+}
+
+void
+async_database_impl::subscribe(const std::string& key, update_handler_t updates, status_handler_t handler)
+{
+    auto sub = std::make_shared<subscription_info>();
     {
-        translate_swarm_response(response, error, resp, [resp](const database_response &/*response*/)
+        std::lock_guard<std::mutex> lock(this->subscriptions_lock);
+        if (!this->subscriptions.emplace(key, sub).second)
+        {
+            handler(db_status{static_cast<int>(db_error::database_error), "Already subscribed to key"});
+            return;
+        }
+    }
+
+    // the acknowledgement may be delivered before subscribe() returns, so the lock can't be held here
+    auto nonce = this->db_impl->subscribe(this->swarm, this->uuid, key
+        , [weak_this = weak_from_this(), key, sub, handler](const database_response& response
+            , const boost::system::error_code& ec)
+        {
+            auto status = make_status(response, ec);
+            if (!status.ok())
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    strong_this->subscription_failed(key, sub);
+                }
+            }
+
+            handler(status);
+        }
+        , [updates](const database_subscription_update& update)
         {
-            Json::Value result;
-            result["result"] = 1;
-            resp->set_result(result.toStyledString());
-            resp->set_ready();
+            updates(make_update(update));
         });
+
+    bool cancelled;
+    {
+        std::lock_guard<std::mutex> lock(this->subscriptions_lock);
+        sub->nonce = nonce;
+        auto it = this->subscriptions.find(key);
+        cancelled = !sub->failed && (it == this->subscriptions.end() || it->second != sub);
+    }
+
+    if (cancelled)
+    {
+        // unsubscribed while we were sending the request
+        this->db_impl->unsubscribe(this->swarm, this->uuid, key, nonce);
+    }
+}
+
+void
+async_database_impl::subscription_failed(const std::string& key, const std::shared_ptr<subscription_info>& sub)
+{
+    std::lock_guard<std::mutex> lock(this->subscriptions_lock);
+    sub->failed = true;
+    auto it = this->subscriptions.find(key);
+    if (it != this->subscriptions.end() && it->second == sub)
+    {
+        this->subscriptions.erase(it);
+    }
+}
+
+void
+async_database_impl::unsubscribe(const std::string& key)
+{
+    uint64_t nonce = 0;
+    {
+        std::lock_guard<std::mutex> lock(this->subscriptions_lock);
+        auto it = this->subscriptions.find(key);
+        if (it == this->subscriptions.end())
+        {
+            return;
+        }
+
+        nonce = it->second->nonce;
+        this->subscriptions.erase(it);
+    }
+
+    if (nonce)
+    {
+        this->db_impl->unsubscribe(this->swarm, this->uuid, key, nonce);
+    }
+}
+
+void
+async_database_impl::create(const std::string& key, const std::string& value, uint64_t expiry, status_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_create()->set_key(key);
+    msg.mutable_create()->set_value(value);
+    msg.mutable_create()->set_expire(expiry);
+
+    this->send_write(msg, key, handler);
+}
+
+void
+async_database_impl::read(const std::string& key, value_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_read()->set_key(key);
+
+    this->send_read(msg, key, send_policy::normal, handler);
+}
+
+void
+async_database_impl::update(const std::string& key, const std::string& value, status_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_update()->set_key(key);
+    msg.mutable_update()->set_value(value);
+
+    this->send_write(msg, key, handler);
+}
+
+void
+async_database_impl::remove(const std::string& key, status_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_delete_()->set_key(key);
+
+    this->send_write(msg, key, handler);
+}
+
+void
+async_database_impl::quick_read(const std::string& key, value_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_quick_read()->set_key(key);
+
+    this->send_read(msg, key, send_policy::hedged, handler);
+}
+
+void
+async_database_impl::has(const std::string& key, bool_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_has()->set_key(key);
+
+    this->send_message_with_status(msg, send_policy::normal, [handler](const auto& status, const auto& response)
+    {
+        handler(status, response.has().has());
+    });
+}
+
+void
+async_database_impl::keys(keys_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_keys();
+
+    this->send_message_with_status(msg, send_policy::normal, [handler](const auto& status, const auto& response)
+    {
+        const auto& keys = response.keys().keys();
+        handler(status, std::vector<std::string>(keys.begin(), keys.end()));
+    });
+}
+
+void
+async_database_impl::size(size_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_size();
+
+    this->send_message_with_status(msg, send_policy::normal, [handler](const auto& status, const auto& response)
+    {
+        const database_size_response& size_resp = response.size();
+        db_size size;
+        size.bytes = size_resp.bytes();
+        size.keys = size_resp.keys();
+        size.remaining_bytes = size_resp.remaining_bytes();
+        size.max_size = size_resp.max_size();
+        handler(status, size);
+    });
+}
+
+void
+async_database_impl::ttl(const std::string& key, ttl_handler_t handler)
+{
+    database_msg msg;
+    msg.mutable_ttl()->set_key(key);
+
+    this->send_message_with_status(msg, send_policy::normal, [handler](const auto& status, const auto& response)
+    {
+        handler(status, response.ttl().ttl());
     });
 }
 
@@ -109,12 +499,10 @@ async_database_impl::create(const std::string& key, const std::string& value, ui
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_create()->set_key(key);
-        msg.mutable_create()->set_value(value);
-        msg.mutable_create()->set_expire(expiry);
-
-        send_message_with_basic_response(msg, resp);
+        this->create(key, value, expiry, [resp](const auto& status)
+        {
+            basic_result(status, resp);
+        });
 
         return resp;
     }
@@ -128,23 +516,18 @@ async_database_impl::read(const std::string& key)
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_read()->set_key(key);
-
-        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::normal
-            , [resp](const database_response &response, const boost::system::error_code &error)
+        this->read(key, [resp, key](const auto& status, auto value)
+        {
+            if (!set_error_result(status, resp))
             {
-                translate_swarm_response(response, error, resp, [resp](const database_response &response)
-                {
-                    Json::Value result;
-                    const database_read_response &read_resp = response.read();
-                    result["result"] = 1;
-                    result["key"] = read_resp.key();
-                    result["value"] = read_resp.value();
-                    resp->set_result(result.toStyledString());
-                    resp->set_ready();
-                });
-            });
+                Json::Value result;
+                result["result"] = 1;
+                result["key"] = key;
+                result["value"] = std::string(value);
+                resp->set_result(result.toStyledString());
+                resp->set_ready();
+            }
+        });
 
         return resp;
     }
@@ -158,11 +541,10 @@ async_database_impl::update(const std::string& key, const std::string& value)
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_update()->set_key(key);
-        msg.mutable_update()->set_value(value);
-
-        send_message_with_basic_response(msg, resp);
+        this->update(key, value, [resp](const auto& status)
+        {
+            basic_result(status, resp);
+        });
 
         return resp;
     }
@@ -176,10 +558,10 @@ async_database_impl::remove(const std::string& key)
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_delete_()->set_key(key);
-
-        send_message_with_basic_response(msg, resp);
+        this->remove(key, [resp](const auto& status)
+        {
+            basic_result(status, resp);
+        });
 
         return resp;
     }
@@ -187,44 +569,233 @@ async_database_impl::remove(const std::string& key)
     return nullptr;
 }
 
+std::shared_ptr<response>
+async_database_impl::batch_create(const std::vector<std::pair<std::string, std::string>>& key_values, uint64_t expiry)
+{
+    try
+    {
+        std::vector<std::string> keys;
+        std::vector<database_msg> requests(key_values.size());
+        for (size_t i = 0; i < key_values.size(); i++)
+        {
+            keys.push_back(key_values[i].first);
+            requests[i].mutable_create()->set_key(key_values[i].first);
+            requests[i].mutable_create()->set_value(key_values[i].second);
+            requests[i].mutable_create()->set_expire(expiry);
+        }
+
+        return this->send_batch(std::move(keys), std::move(requests));
+    }
+    CATCHALL();
+    return nullptr;
+}
+
+std::shared_ptr<response>
+async_database_impl::batch_read(const std::vector<std::string>& keys)
+{
+    try
+    {
+        std::vector<database_msg> requests(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            requests[i].mutable_read()->set_key(keys[i]);
+        }
+
+        return this->send_batch(std::vector<std::string>(keys), std::move(requests));
+    }
+    CATCHALL();
+    return nullptr;
+}
+
+std::shared_ptr<response>
+async_database_impl::batch_update(const std::vector<std::pair<std::string, std::string>>& key_values)
+{
+    try
+    {
+        std::vector<std::string> keys;
+        std::vector<database_msg> requests(key_values.size());
+        for (size_t i = 0; i < key_values.size(); i++)
+        {
+            keys.push_back(key_values[i].first);
+            requests[i].mutable_update()->set_key(key_values[i].first);
+            requests[i].mutable_update()->set_value(key_values[i].second);
+        }
+
+        return this->send_batch(std::move(keys), std::move(requests));
+    }
+    CATCHALL();
+    return nullptr;
+}
+
+std::shared_ptr<response>
+async_database_impl::batch_remove(const std::vector<std::string>& keys)
+{
+    try
+    {
+        std::vector<database_msg> requests(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            requests[i].mutable_delete_()->set_key(keys[i]);
+        }
+
+        return this->send_batch(std::vector<std::string>(keys), std::move(requests));
+    }
+    CATCHALL();
+    return nullptr;
+}
+
+std::shared_ptr<response>
+async_database_impl::send_batch(std::vector<std::string>&& keys, std::vector<database_msg>&& requests)
+{
+    auto batch = std::make_shared<batch_info>();
+    batch->db_impl = this->db_impl;
+    batch->swarm = this->swarm;
+    batch->uuid = this->uuid;
+    batch->keys = std::move(keys);
+    batch->requests = std::move(requests);
+    batch->resp = make_response();
+    batch->cache = std::atomic_load(&this->cache);
+    batch->results.resize(static_cast<Json::ArrayIndex>(batch->requests.size()));
+
+    if (batch->requests.empty())
+    {
+        complete_batch(batch);
+        return batch->resp;
+    }
+
+    // prime the pipeline, each completion then sends the next request
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(batch->lock);
+        count = std::min(BATCH_PIPELINE_DEPTH, batch->requests.size());
+        batch->next = count;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        send_batch_request(batch, i);
+    }
+
+    return batch->resp;
+}
+
+void
+async_database_impl::send_batch_request(std::shared_ptr<batch_info> batch, size_t index)
+{
+    invalidate_batch_key(*batch, index);
+    batch->db_impl->send_message_to_swarm(batch->swarm, batch->uuid, batch->requests[index], send_policy::normal
+        , [batch, index](const database_response& response, const boost::system::error_code& ec)
+        {
+            handle_batch_response(batch, index, response, ec);
+        });
+}
+
+void
+async_database_impl::handle_batch_response(std::shared_ptr<batch_info> batch, size_t index
+    , const database_response& response, const boost::system::error_code& ec)
+{
+    invalidate_batch_key(*batch, index);
+
+    Json::Value result;
+    result["key"] = batch->keys[index];
+    if (ec)
+    {
+        result["error"] = ec.message();
+    }
+    else if (response.has_error())
+    {
+        result["error"] = response.error().message();
+    }
+    else
+    {
+        result["result"] = 1;
+        if (response.has_read())
+        {
+            result["value"] = response.read().value();
+        }
+    }
+
+    size_t next = batch->requests.size();
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(batch->lock);
+        if (result.isMember("error"))
+        {
+            batch->failed++;
+        }
+
+        batch->results[static_cast<Json::ArrayIndex>(index)] = std::move(result);
+        done = ++batch->completed == batch->requests.size();
+        if (batch->next < batch->requests.size())
+        {
+            next = batch->next++;
+        }
+    }
+
+    if (done)
+    {
+        complete_batch(batch);
+    }
+    else if (next < batch->requests.size())
+    {
+        send_batch_request(batch, next);
+    }
+}
+
+void
+async_database_impl::invalidate_batch_key(const batch_info& batch, size_t index)
+{
+    // as with single writes, invalidate both when the write is sent and when it completes
+    if (batch.cache && !batch.requests[index].has_read())
+    {
+        batch.cache->invalidate(batch.keys[index]);
+    }
+}
+
+void
+async_database_impl::complete_batch(const std::shared_ptr<batch_info>& batch)
+{
+    Json::Value result;
+    if (batch->failed)
+    {
+        result["error"] = std::to_string(batch->failed) + " of " + std::to_string(batch->requests.size())
+            + " requests failed";
+    }
+    else
+    {
+        result["result"] = 1;
+    }
+
+    result["results"] = std::move(batch->results);
+    batch->resp->set_result(result.toStyledString());
+    if (batch->failed)
+    {
+        batch->resp->set_error(static_cast<int>(db_error::database_error));
+    }
+    else
+    {
+        batch->resp->set_ready();
+    }
+}
+
 std::shared_ptr<response>
 async_database_impl::quick_read(const std::string& key)
 {
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_quick_read()->set_key(key);
-
-        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::fastest
-            , [resp](const database_response &response, const boost::system::error_code &ec)
+        this->quick_read(key, [resp, key](const auto& status, auto value)
+        {
+            if (!set_error_result(status, resp))
             {
                 Json::Value result;
-                if (ec)
-                {
-                    result["error"] = ec.message();
-                    resp->set_result(result.toStyledString());
-                    resp->set_error(static_cast<int>(db_error::connection_error));
-                }
-                else
-                {
-                    const database_quick_read_response &rr = response.quick_read();
-                    if (!rr.error().empty())
-                    {
-                        result["error"] = rr.error();
-                        resp->set_result(result.toStyledString());
-                        resp->set_error(static_cast<int>(db_error::database_error));
-                    }
-                    else
-                    {
-                        result["result"] = 1;
-                        result["key"] = rr.key();
-                        result["value"] = rr.value();
-                        resp->set_result(result.toStyledString());
-                        resp->set_ready();
-                    }
-                }
-            });
+                result["result"] = 1;
+                result["key"] = key;
+                result["value"] = std::string(value);
+                resp->set_result(result.toStyledString());
+                resp->set_ready();
+            }
+        });
 
         return resp;
     }
@@ -238,20 +809,16 @@ async_database_impl::has(const std::string& key)
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_has()->set_key(key);
-
-        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::normal
-            , [resp](const database_response &response, const boost::system::error_code &error)
+        this->has(key, [resp](const auto& status, auto has)
+        {
+            if (!set_error_result(status, resp))
             {
-                translate_swarm_response(response, error, resp, [resp](const database_response &response)
-                {
-                    Json::Value result;
-                    result["result"] = response.has().has();
-                    resp->set_result(result.toStyledString());
-                    resp->set_ready();
-                });
-            });
+                Json::Value result;
+                result["result"] = has;
+                resp->set_result(result.toStyledString());
+                resp->set_ready();
+            }
+        });
 
         return resp;
     }
@@ -265,27 +832,22 @@ async_database_impl::keys()
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_keys();
-
-        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::normal
-            , [resp](const database_response &response, const boost::system::error_code &ec)
+        this->keys([resp](const auto& status, const auto& keys)
+        {
+            if (!set_error_result(status, resp))
             {
-                translate_swarm_response(response, ec, resp, [resp](const database_response &response)
+                Json::Value result;
+                Json::Value keys_json;
+                for (const auto& key : keys)
                 {
-                    Json::Value result;
-                    const database_keys_response &keys_resp = response.keys();
-                    Json::Value keys;
-                    for (int i = 0; i < keys_resp.keys_size(); i++)
-                    {
-                        keys.append(keys_resp.keys(i));
-                    }
-                    result["keys"] = keys;
-
-                    resp->set_result(result.toStyledString());
-                    resp->set_ready();
-                });
-            });
+                    keys_json.append(key);
+                }
+                result["keys"] = keys_json;
+
+                resp->set_result(result.toStyledString());
+                resp->set_ready();
+            }
+        });
 
         return resp;
     }
@@ -299,25 +861,20 @@ async_database_impl::size()
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_size();
-
-        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::normal
-            , [resp](const database_response &response, const boost::system::error_code &ec)
+        this->size([resp](const auto& status, const auto& size)
+        {
+            if (!set_error_result(status, resp))
             {
-                translate_swarm_response(response, ec, resp, [resp](const database_response &response)
-                {
-                    Json::Value result;
-                    const database_size_response &size_resp = response.size();
-                    result["result"] = 1;
-                    result["bytes"] = static_cast<Json::Value::UInt64>(size_resp.bytes());
-                    result["keys"] = size_resp.keys();
-                    result["remaining_bytes"] = static_cast<Json::Value::UInt64>(size_resp.remaining_bytes());
-                    result["max_size"] = static_cast<Json::Value::UInt64>(size_resp.max_size());
-                    resp->set_result(result.toStyledString());
-                    resp->set_ready();
-                });
-            });
+                Json::Value result;
+                result["result"] = 1;
+                result["bytes"] = static_cast<Json::Value::UInt64>(size.bytes);
+                result["keys"] = static_cast<Json::Value::UInt64>(size.keys);
+                result["remaining_bytes"] = static_cast<Json::Value::UInt64>(size.remaining_bytes);
+                result["max_size"] = static_cast<Json::Value::UInt64>(size.max_size);
+                resp->set_result(result.toStyledString());
+                resp->set_ready();
+            }
+        });
 
         return resp;
     }
@@ -366,23 +923,18 @@ async_database_impl::ttl(const std::string& key)
     try
     {
         auto resp = make_response();
-        database_msg msg;
-        msg.mutable_ttl()->set_key(key);
-
-        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::normal
-            , [resp](const database_response &response, const boost::system::error_code &ec)
+        this->ttl(key, [resp, key](const auto& status, auto ttl)
+        {
+            if (!set_error_result(status, resp))
             {
-                translate_swarm_response(response, ec, resp, [resp](const database_response &response)
-                {
-                    Json::Value result;
-                    const database_ttl_response &read_resp = response.ttl();
-                    result["result"] = 1;
-                    result["key"] = read_resp.key();
-                    result["ttl"] = static_cast<Json::Value::UInt64>(read_resp.ttl());
-                    resp->set_result(result.toStyledString());
-                    resp->set_ready();
-                });
-            });
+                Json::Value result;
+                result["result"] = 1;
+                result["key"] = key;
+                result["ttl"] = static_cast<Json::Value::UInt64>(ttl);
+                resp->set_result(result.toStyledString());
+                resp->set_ready();
+            }
+        });
 
         return resp;
     }
@@ -399,29 +951,26 @@ async_database_impl::writers()
         database_msg msg;
         msg.mutable_writers();
 
-        this->db_impl->send_message_to_swarm(this->swarm, this->uuid, msg, send_policy::normal
-            , [resp](const database_response &response, const boost::system::error_code &ec)
+        this->send_message_with_status(msg, send_policy::normal, [resp](const auto& status, const auto& response)
+        {
+            if (!set_error_result(status, resp))
             {
-                translate_swarm_response(response, ec, resp, [resp](const database_response &response)
+                Json::Value result;
+                Json::Value writers;
+                for (const auto& writer : response.writers().writers())
                 {
-                    Json::Value result;
-                    const database_writers_response &writers_resp = response.writers();
-                    Json::Value writers;
-                    for (int i = 0; i < writers_resp.writers_size(); i++)
-                    {
-                        writers.append(writers_resp.writers(i));
-                    }
-
-                    result["result"] = 1;
-                    result["writers"] = writers;
-
-                    resp->set_result(result.toStyledString());
-                    resp->set_ready();
-                });
-            });
+                    writers.append(writer);
+                }
 
-        return resp;
+                result["result"] = 1;
+                result["writers"] = writers;
+
+                resp->set_result(result.toStyledString());
+                resp->set_ready();
+            }
+        });
 
+        return resp;
     }
     CATCHALL();
     return nullptr;
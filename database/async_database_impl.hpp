@@ -19,8 +19,12 @@
 #include <include/bluzelle.hpp>
 #include <include/async_database.hpp>
 #include <database/db_dispatch_base.hpp>
+#include <database/read_cache.hpp>
 #include <library/mutable_response.hpp>
 #include <swarm/swarm_base.hpp>
+#include <json/value.h>
+#include <map>
+#include <mutex>
 
 
 namespace bzapi
@@ -32,6 +36,7 @@ namespace bzapi
     public:
 
         async_database_impl(std::shared_ptr<db_dispatch_base> db_impl, std::shared_ptr<swarm_base> swarm, uuid_t uuid);
+        ~async_database_impl() override;
 
         void open(completion_handler_t handler);
 
@@ -40,6 +45,12 @@ namespace bzapi
         std::shared_ptr<response> update(const std::string& key, const std::string& value) override;
         std::shared_ptr<response> remove(const std::string& key) override;
 
+        std::shared_ptr<response> batch_create(const std::vector<std::pair<std::string, std::string>>& key_values
+            , uint64_t expiry) override;
+        std::shared_ptr<response> batch_read(const std::vector<std::string>& keys) override;
+        std::shared_ptr<response> batch_update(const std::vector<std::pair<std::string, std::string>>& key_values) override;
+        std::shared_ptr<response> batch_remove(const std::vector<std::string>& keys) override;
+
         std::shared_ptr<response> quick_read(const std::string& key) override;
         std::shared_ptr<response> has(const std::string& key) override;
         std::shared_ptr<response> keys() override;
@@ -52,20 +63,85 @@ namespace bzapi
         std::shared_ptr<response> add_writer(const std::string& writer) override;
         std::shared_ptr<response> remove_writer(const std::string& writer) override;
 
+        void create(const std::string& key, const std::string& value, uint64_t expiry, status_handler_t handler) override;
+        void read(const std::string& key, value_handler_t handler) override;
+        void update(const std::string& key, const std::string& value, status_handler_t handler) override;
+        void remove(const std::string& key, status_handler_t handler) override;
+        void quick_read(const std::string& key, value_handler_t handler) override;
+        void has(const std::string& key, bool_handler_t handler) override;
+        void keys(keys_handler_t handler) override;
+        void size(size_handler_t handler) override;
+        void ttl(const std::string& key, ttl_handler_t handler) override;
+
         std::string swarm_status() override;
 
+        void set_read_cache(size_t max_keys, uint64_t max_age) override;
+
+        void subscribe(const std::string& key, update_handler_t updates, status_handler_t handler) override;
+        void unsubscribe(const std::string& key) override;
+
     private:
 
         enum class init_state {none, initializing, initialized} state{init_state::none};
 
+        // a batch keeps a bounded number of its requests in flight and reports once they have all completed
+        struct batch_info
+        {
+            std::shared_ptr<db_dispatch_base> db_impl;
+            std::shared_ptr<swarm_base> swarm;
+            uuid_t uuid;
+            std::vector<std::string> keys;
+            std::vector<database_msg> requests;
+            std::shared_ptr<mutable_response> resp;
+            std::shared_ptr<read_cache> cache;
+
+            std::mutex lock;
+            Json::Value results{Json::arrayValue};
+            size_t next{0};
+            size_t completed{0};
+            size_t failed{0};
+        };
+
         const std::shared_ptr<db_dispatch_base> db_impl;
         const std::shared_ptr<swarm_base> swarm;
         const uuid_t uuid;
 
-        static void translate_swarm_response(const database_response& db_response, const boost::system::error_code& ec
-            , std::shared_ptr<mutable_response> resp
-            , std::function<void(const database_response& response)> handler);
+        // only accessed through std::atomic_load/atomic_store as it can be replaced while requests are in flight
+        std::shared_ptr<read_cache> cache;
+
+        // the nonce is zero until the subscription request has been sent
+        struct subscription_info
+        {
+            uint64_t nonce = 0;
+            bool failed = false;
+        };
+
+        std::mutex subscriptions_lock;
+        std::map<std::string, std::shared_ptr<subscription_info>> subscriptions;
+
+        static db_status make_status(const database_response& db_response, const boost::system::error_code& ec);
+        static bool set_error_result(const db_status& status, const std::shared_ptr<mutable_response>& resp);
+        static void basic_result(const db_status& status, const std::shared_ptr<mutable_response>& resp);
+        static db_update make_update(const database_subscription_update& update);
 
+        void send_message_with_status(database_msg& msg, send_policy policy
+            , std::function<void(const db_status& status, const database_response& response)> handler);
         void send_message_with_basic_response(database_msg& msg, std::shared_ptr<mutable_response> resp);
+        void send_read(database_msg& msg, const std::string& key, send_policy policy, value_handler_t handler);
+        void send_write(database_msg& msg, const std::string& key, status_handler_t handler);
+
+        void cache_value(const std::shared_ptr<read_cache>& cache, const std::string& key, const std::string& value
+            , uint64_t generation);
+        void subscribe_for_cache(const std::shared_ptr<read_cache>& cache, const std::string& key);
+        void invalidate_cached(const std::string& key);
+        void release_cache(const std::shared_ptr<read_cache>& cache);
+        void subscription_failed(const std::string& key, const std::shared_ptr<subscription_info>& sub);
+
+        std::shared_ptr<response> send_batch(std::vector<std::string>&& keys, std::vector<database_msg>&& requests);
+        static void send_batch_request(std::shared_ptr<batch_info> batch, size_t index);
+        static void handle_batch_response(std::shared_ptr<batch_info> batch, size_t index
+            , const database_response& response, const boost::system::error_code& ec);
+        static void complete_batch(const std::shared_ptr<batch_info>& batch);
+        static void invalidate_batch_key(const batch_info& batch, size_t index);
     };
 }
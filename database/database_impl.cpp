@@ -15,9 +15,29 @@
 //
 
 #include <database/database_impl.hpp>
+#include <json/value.h>
 
 using namespace bzapi;
 
+namespace
+{
+    // under the block overload policy, the calling thread waits here for room rather than a network thread
+    // waiting in the dispatcher
+    template <typename Request>
+    std::string
+    blocking_request(Request request)
+    {
+        if (!wait_for_request_room())
+        {
+            Json::Value result;
+            result["error"] = OVERLOAD_ERROR_MSG;
+            return result.toStyledString();
+        }
+
+        return request()->get_result();
+    }
+}
+
 database_impl::database_impl(std::shared_ptr<async_database> db)
 : db(std::move(db))
 {
@@ -26,85 +46,109 @@ database_impl::database_impl(std::shared_ptr<async_database> db)
 std::string
 database_impl::create(const std::string& key, const std::string& value, uint64_t expiry)
 {
-    return db->create(key, value, expiry)->get_result();
+    return blocking_request([&]() { return db->create(key, value, expiry); });
 }
 
 std::string
 database_impl::read(const std::string& key)
 {
-    return db->read(key)->get_result();
+    return blocking_request([&]() { return db->read(key); });
 }
 
 std::string
 database_impl::update(const std::string& key, const std::string& value)
 {
-    return db->update(key, value)->get_result();
+    return blocking_request([&]() { return db->update(key, value); });
 }
 
 std::string
 database_impl::remove(const std::string& key)
 {
-    return db->remove(key)->get_result();
+    return blocking_request([&]() { return db->remove(key); });
+}
+
+std::string
+database_impl::batch_create(const std::vector<std::pair<std::string, std::string>>& key_values, uint64_t expiry)
+{
+    return blocking_request([&]() { return db->batch_create(key_values, expiry); });
+}
+
+std::string
+database_impl::batch_read(const std::vector<std::string>& keys)
+{
+    return blocking_request([&]() { return db->batch_read(keys); });
+}
+
+std::string
+database_impl::batch_update(const std::vector<std::pair<std::string, std::string>>& key_values)
+{
+    return blocking_request([&]() { return db->batch_update(key_values); });
+}
+
+std::string
+database_impl::batch_remove(const std::vector<std::string>& keys)
+{
+    return blocking_request([&]() { return db->batch_remove(keys); });
 }
 
 std::string
 database_impl::quick_read(const std::string& key)
 {
-    return db->quick_read(key)->get_result();
+    return blocking_request([&]() { return db->quick_read(key); });
 }
 
 std::string
 database_impl::has(const std::string& key)
 {
-    return db->has(key)->get_result();
+    return blocking_request([&]() { return db->has(key); });
 }
 
 std::string
 database_impl::keys()
 {
-    return db->keys()->get_result();
+    return blocking_request([&]() { return db->keys(); });
 }
 
 std::string
 database_impl::size()
 {
-    return db->size()->get_result();
+    return blocking_request([&]() { return db->size(); });
 }
 
 std::string
 database_impl::expire(const std::string& key, expiry_t expiry)
 {
-    return db->expire(key, expiry)->get_result();
+    return blocking_request([&]() { return db->expire(key, expiry); });
 }
 
 std::string
 database_impl::persist(const std::string& key)
 {
-    return db->persist(key)->get_result();
+    return blocking_request([&]() { return db->persist(key); });
 }
 
 std::string
 database_impl::ttl(const std::string& key)
 {
-    return db->ttl(key)->get_result();
+    return blocking_request([&]() { return db->ttl(key); });
 }
 
 std::string
 database_impl::writers()
 {
-    return db->writers()->get_result();
+    return blocking_request([&]() { return db->writers(); });
 }
 
 std::string
 database_impl::add_writer(const std::string& writer)
 {
-    return db->add_writer(writer)->get_result();
+    return blocking_request([&]() { return db->add_writer(writer); });
 }
 
 std::string
 database_impl::remove_writer(const std::string& writer)
 {
-    return db->remove_writer(writer)->get_result();
+    return blocking_request([&]() { return db->remove_writer(writer); });
 }
 
 std::string
@@ -113,3 +157,9 @@ database_impl::swarm_status()
     return db->swarm_status();
 }
 
+void
+database_impl::set_read_cache(size_t max_keys, uint64_t max_age)
+{
+    db->set_read_cache(max_keys, max_age);
+}
+
@@ -31,6 +31,11 @@ namespace bzapi
         std::string update(const std::string& key, const std::string& value) override;
         std::string remove(const std::string& key) override;
 
+        std::string batch_create(const std::vector<std::pair<std::string, std::string>>& key_values, uint64_t expiry) override;
+        std::string batch_read(const std::vector<std::string>& keys) override;
+        std::string batch_update(const std::vector<std::pair<std::string, std::string>>& key_values) override;
+        std::string batch_remove(const std::vector<std::string>& keys) override;
+
         std::string quick_read(const std::string& key) override;
         std::string has(const std::string& key) override;
         std::string keys() override;
@@ -45,6 +50,8 @@ namespace bzapi
 
         std::string swarm_status() override;
 
+        void set_read_cache(size_t max_keys, uint64_t max_age) override;
+
     private:
         std::shared_ptr<async_database> db;
     };
@@ -15,46 +15,259 @@
 //
 
 #include <database/db_dispatch.hpp>
+#include <include/bzapi.hpp>
 #include <boost/format.hpp>
+#include <openssl/evp.h>
 
 using namespace bzapi;
 
 namespace
 {
+    // retry times used until we have measured a swarm's latency
     const std::chrono::milliseconds REQUEST_RETRY_TIME{std::chrono::milliseconds(1500)};
     const std::chrono::milliseconds BROADCAST_RETRY_TIME{std::chrono::milliseconds(3000)};
+    const std::chrono::milliseconds HEDGE_TIME{std::chrono::milliseconds(250)};
+
+    // resolution of request deadlines
+    const std::chrono::milliseconds DEADLINE_TICK_TIME{std::chrono::milliseconds(100)};
+
+    const std::string SUBSCRIPTION_LOST_MSG{"Subscription lost"};
+
+    // the client timeout is the longest deadline we schedule, so the wheel gets enough slots for it to expire
+    // in one revolution. a timeout raised later still works, its deadlines just wait out extra rounds
+    size_t
+    deadline_slots()
+    {
+        const std::chrono::milliseconds timeout{std::chrono::seconds(get_timeout())};
+        size_t ticks = (timeout.count() + DEADLINE_TICK_TIME.count() - 1) / DEADLINE_TICK_TIME.count();
+        return std::max(ticks, size_t{256});
+    }
+
+    // responses are compared by digest so each payload is only hashed once, on arrival
+    std::string
+    response_digest(const std::string& payload)
+    {
+        unsigned char md[EVP_MAX_MD_SIZE];
+        unsigned int md_len{0};
+        if (!EVP_Digest(payload.data(), payload.size(), md, &md_len, EVP_sha256(), nullptr))
+        {
+            // fall back to the payload itself so matching still works
+            LOG(error) << "Failed to compute response digest";
+            return payload;
+        }
+
+        return std::string(reinterpret_cast<const char*>(md), md_len);
+    }
 }
 
 db_dispatch::db_dispatch(std::shared_ptr<bzn::asio::io_context_base> io_context)
-    : io_context(std::move(io_context))
+    : io_context(std::move(io_context)), strand(this->io_context->make_unique_strand()), deadlines(deadline_slots())
 {
 }
 
 void
 db_dispatch::send_message_to_swarm(std::shared_ptr<swarm_base> swarm, uuid_t db_uuid, database_msg& msg
     , send_policy policy, db_response_handler_t handler)
+{
+    this->send_request(std::move(swarm), db_uuid, msg, policy, std::move(handler), nullptr);
+}
+
+uint64_t
+db_dispatch::subscribe(std::shared_ptr<swarm_base> swarm, uuid_t db_uuid, const std::string& key
+    , db_response_handler_t handler, subscription_handler_t update_handler)
+{
+    database_msg msg;
+    msg.mutable_subscribe()->set_key(key);
+    return this->send_request(std::move(swarm), db_uuid, msg, send_policy::normal, std::move(handler)
+        , std::move(update_handler));
+}
+
+void
+db_dispatch::cancel_request(uint64_t nonce)
+{
+    // one still waiting for admission is never sent
+    if (this->admission.withdraw(nonce))
+    {
+        return;
+    }
+
+    this->strand->post([weak_this = weak_from_this(), nonce]()
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->finish_request(nonce);
+        }
+    });
+}
+
+void
+db_dispatch::unsubscribe(std::shared_ptr<swarm_base> swarm, uuid_t db_uuid, const std::string& key, uint64_t nonce)
+{
+    // stop delivering updates straight away, the swarm's answer doesn't matter to us
+    this->strand->post([weak_this = weak_from_this(), nonce]()
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            auto info = strong_this->messages.find(nonce);
+            if (info && info->update_handler)
+            {
+                strong_this->finish_request(nonce);
+            }
+        }
+    });
+
+    database_msg msg;
+    msg.mutable_unsubscribe()->set_key(key);
+    msg.mutable_unsubscribe()->set_nonce(nonce);
+    this->send_request(std::move(swarm), db_uuid, msg, send_policy::normal, [key](const auto& response, const auto& ec)
+    {
+        if (ec || response.has_error())
+        {
+            LOG(debug) << "Failed to unsubscribe from key: " << key;
+        }
+    }, nullptr);
+}
+
+db_dispatch::nonce_t
+db_dispatch::send_request(std::shared_ptr<swarm_base> swarm, const uuid_t& db_uuid, database_msg& msg
+    , send_policy policy, db_response_handler_t handler, subscription_handler_t update_handler)
 {
     auto nonce = this->next_nonce++;
 
     msg.mutable_header()->set_db_uuid(db_uuid);
     msg.mutable_header()->set_nonce(nonce);
+    msg.mutable_header()->set_point_of_contact(swarm->get_point_of_contact(policy));
 
     auto env = std::make_shared<bzn_envelope>();
     env->set_database_msg(msg.SerializeAsString());
-    swarm->sign_and_date_request(*env, policy);
+    swarm->sign_and_date_request(*env);
+    this->register_swarm_handler(swarm);
+
+    auto start = [weak_this = weak_from_this(), swarm, env, policy, nonce, handler, update_handler](bool admitted)
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->strand->post([weak_this, swarm, env, policy, nonce, handler, update_handler, admitted]()
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    if (admitted)
+                    {
+                        strong_this->start_request(swarm, env, policy, nonce, handler, update_handler);
+                    }
+                    else
+                    {
+                        strong_this->reject_request(nonce, handler);
+                    }
+                }
+            });
+        }
+    };
+
+    // never blocks, as we may be on a network thread; blocking callers have already waited in wait_for_room
+    auto limits = request_limits();
+    switch (this->admission.admit(swarm.get(), nonce, limits, start))
+    {
+        case admission_control::result::admitted:
+            start(true);
+            break;
+
+        case admission_control::result::rejected:
+            start(false);
+            break;
+
+        case admission_control::result::queued:
+            LOG(debug) << "Too many requests in flight, queueing message " << nonce;
+            this->strand->post([weak_this = weak_from_this(), nonce, max_wait = limits.max_wait]()
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    strong_this->schedule_deadline(max_wait, nonce, deadline_type::admission_timeout);
+                }
+            });
+            break;
+    }
+
+    return nonce;
+}
 
+bool
+db_dispatch::wait_for_room()
+{
+    return this->admission.wait_for_room(request_limits());
+}
+
+admission_control::stats
+db_dispatch::get_request_stats()
+{
+    return this->admission.get_stats();
+}
+
+admission_control::limits
+db_dispatch::request_limits()
+{
+    admission_control::limits limits;
+    limits.max_requests = get_max_requests();
+    limits.max_group_requests = get_max_swarm_requests();
+    limits.policy = get_overload_policy();
+    limits.max_wait = std::chrono::seconds(get_timeout());
+    return limits;
+}
+
+void
+db_dispatch::reject_request(nonce_t nonce, db_response_handler_t handler)
+{
+    LOG(warning) << "Too many requests in flight, failing message " << nonce;
+    database_response response;
+    response.mutable_header()->set_nonce(nonce);
+    response.mutable_error()->set_message(OVERLOAD_ERROR_MSG);
+    handler(response, boost::system::error_code{});
+}
+
+void
+db_dispatch::finish_request(nonce_t nonce)
+{
+    auto info = this->messages.find(nonce);
+    if (!info)
+    {
+        return;
+    }
+
+    auto swarm = info->swarm;
+    bool admitted = info->admitted;
+    this->messages.erase(nonce);
+    this->subscriptions.erase(nonce);
+
+    // after the erase, as this may start queued requests
+    if (admitted)
+    {
+        this->admission.release(swarm.get());
+    }
+}
+
+
+void
+db_dispatch::start_request(std::shared_ptr<swarm_base> swarm, std::shared_ptr<bzn_envelope> env, send_policy policy
+    , nonce_t nonce, db_response_handler_t handler, subscription_handler_t update_handler)
+{
     // store message info
     msg_info info;
     info.swarm = swarm;
     info.request = env;
     info.handler = handler;
-    this->setup_client_timeout(nonce, info);
+    info.update_handler = update_handler;
+    info.sent_time = std::chrono::steady_clock::now();
+    this->schedule_deadline(std::chrono::seconds(get_timeout()), nonce, deadline_type::client_timeout);
     this->setup_request_policy(info, policy, nonce);
+    if (info.update_handler)
+    {
+        // subscriptions are held by the node we're talking to, so its acknowledgement is enough
+        info.responses_required = 1;
+    }
 
-    this->messages[nonce] = info;
+    this->messages.insert(nonce, std::move(info));
 
     LOG(debug) << "Sending database request for message " << nonce;
-    this->register_swarm_handler(swarm);
     swarm->send_request(*env, policy);
 }
 
@@ -64,63 +277,209 @@ db_dispatch::setup_request_policy(msg_info& info, send_policy policy, nonce_t no
     info.policy = policy;
 
     // consider splitting into send_policy and failure_policy
-    if (policy != send_policy::fastest)
+    if (policy == send_policy::fastest)
+    {
+        info.responses_required = 1;
+    }
+    else if (policy == send_policy::hedged)
+    {
+        info.responses_required = 1;
+        this->schedule_deadline(this->hedge_time(info.swarm), nonce, deadline_type::hedge);
+    }
+    else
     {
         info.responses_required = info.swarm->honest_majority_size();
-        info.retry_timer = this->io_context->make_unique_steady_timer();
-        info.retry_timer->expires_from_now(REQUEST_RETRY_TIME);
-        info.retry_timer->async_wait([weak_this = weak_from_this(), nonce](const auto& ec)
+        info.retrying = true;
+        this->schedule_deadline(this->retry_time(info.swarm, 0), nonce, deadline_type::retry);
+    }
+}
+
+void
+db_dispatch::schedule_deadline(std::chrono::milliseconds delay, nonce_t nonce, deadline_type type)
+{
+    this->deadlines.schedule((delay.count() + DEADLINE_TICK_TIME.count() - 1) / DEADLINE_TICK_TIME.count()
+        , deadline{nonce, type});
+
+    if (!this->ticking)
+    {
+        this->last_tick = std::chrono::steady_clock::now();
+        this->start_ticking();
+    }
+}
+
+void
+db_dispatch::start_ticking()
+{
+    if (!this->tick_timer)
+    {
+        this->tick_timer = this->io_context->make_unique_steady_timer();
+    }
+
+    this->ticking = true;
+    this->tick_timer->expires_from_now(DEADLINE_TICK_TIME);
+    this->tick_timer->async_wait(this->strand->wrap([weak_this = weak_from_this()](const auto& ec)
+    {
+        if (auto strong_this = weak_this.lock())
         {
-            if (auto strong_this = weak_this.lock())
-            {
-                strong_this->handle_request_timeout(ec, nonce);
-            }
+            strong_this->handle_tick(ec);
+        }
+    }));
+}
+
+void
+db_dispatch::handle_tick(const boost::system::error_code& ec)
+{
+    this->ticking = false;
+    if (ec)
+    {
+        LOG(error) << "handle_tick error: " << ec.message();
+        return;
+    }
+
+    // catch up if we've been held up, so deadlines don't drift under load
+    auto now = std::chrono::steady_clock::now();
+    auto ticks = std::max<int64_t>(1, (now - this->last_tick) / DEADLINE_TICK_TIME);
+    this->last_tick = now;
+
+    for (int64_t i = 0; i < ticks && !this->deadlines.empty(); i++)
+    {
+        this->deadlines.advance([this](const deadline& d)
+        {
+            this->handle_deadline(d);
         });
     }
-    else
+
+    // the timer only runs while there is something to wait for
+    if (!this->deadlines.empty() && !this->ticking)
     {
-        info.responses_required = 1;
+        this->start_ticking();
+    }
+}
+
+void
+db_dispatch::handle_deadline(const deadline& d)
+{
+    switch (d.type)
+    {
+        case deadline_type::retry:
+            this->handle_request_timeout(d.nonce);
+            break;
+
+        case deadline_type::hedge:
+            this->handle_hedge_timeout(d.nonce);
+            break;
+
+        case deadline_type::client_timeout:
+            this->handle_client_timeout(d.nonce);
+            break;
+
+        case deadline_type::admission_timeout:
+            // does nothing if the request has since been admitted
+            this->admission.expire(d.nonce);
+            break;
     }
 }
 
+std::chrono::milliseconds
+db_dispatch::retry_time(const std::shared_ptr<swarm_base>& swarm, uint32_t retries)
+{
+    const std::chrono::milliseconds min_time(get_min_retry_time());
+    const std::chrono::milliseconds max_time(get_max_retry_time());
+
+    auto it = this->latencies.find(swarm);
+    if (it == this->latencies.end() || it->second.quorum.empty())
+    {
+        return std::clamp(retries ? BROADCAST_RETRY_TIME : REQUEST_RETRY_TIME, min_time, max_time);
+    }
+
+    // back off exponentially while a request goes unanswered
+    auto timeout = std::max(min_time
+        , std::chrono::duration_cast<std::chrono::milliseconds>(it->second.quorum.timeout(DEADLINE_TICK_TIME)));
+    return std::min<std::chrono::milliseconds>(timeout * (1 << std::min(retries, uint32_t{16})), max_time);
+}
+
+std::chrono::milliseconds
+db_dispatch::hedge_time(const std::shared_ptr<swarm_base>& swarm)
+{
+    auto it = this->latencies.find(swarm);
+    if (it == this->latencies.end() || it->second.single.empty())
+    {
+        return HEDGE_TIME;
+    }
+
+    // wait about as long as a slow answer takes, so only the tail is hedged
+    return std::min(std::chrono::milliseconds(get_max_retry_time())
+        , std::chrono::duration_cast<std::chrono::milliseconds>(it->second.single.timeout(DEADLINE_TICK_TIME)));
+}
+
 void
-db_dispatch::handle_request_timeout(const boost::system::error_code& ec, nonce_t nonce)
+db_dispatch::record_latency(const msg_info& info)
 {
-    if (ec == boost::asio::error::operation_aborted)
+    // only requests answered without a resend tell us how long the swarm takes to respond. a hedged request
+    // still counts, timed from the first send, or only answers quicker than the hedge delay would be sampled
+    if (info.update_handler || info.retries)
     {
         return;
     }
 
-    if (ec)
+    auto it = this->latencies.find(info.swarm);
+    if (it == this->latencies.end())
+    {
+        // forget swarms that have gone away
+        for (auto i = this->latencies.begin(); i != this->latencies.end();)
+        {
+            i = i->first.expired() ? this->latencies.erase(i) : std::next(i);
+        }
+
+        it = this->latencies.emplace(info.swarm, swarm_latency{}).first;
+    }
+
+    auto sample = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - info.sent_time);
+    if (info.policy == send_policy::fastest || info.policy == send_policy::hedged)
+    {
+        it->second.single.add_sample(sample);
+    }
+    else
+    {
+        it->second.quorum.add_sample(sample);
+    }
+}
+
+void
+db_dispatch::handle_hedge_timeout(nonce_t nonce)
+{
+    auto info = this->messages.find(nonce);
+    if (!info || info->hedged)
     {
-        LOG(error) << "handle_request_timeout error: " << ec.message();
         return;
     }
 
-    auto i = this->messages.find(nonce);
-    if (i == this->messages.end())
+    // the fastest node is being slow, ask another one as well and take whichever answers first
+    LOG(trace) << "Hedging message " << nonce;
+    info->hedged = true;
+    info->swarm->send_request(*info->request, send_policy::next_fastest);
+}
+
+void
+db_dispatch::handle_request_timeout(nonce_t nonce)
+{
+    auto info = this->messages.find(nonce);
+    if (!info || info->acknowledged || !info->retrying)
     {
         // message has already been processed
         LOG(trace) << "Ignoring timeout for already processed message: " << nonce;
         return;
     }
 
-    auto info = i->second;
     LOG(debug) << boost::format("request timeout for message %1% - %2% of required %3% responses received")
-                  % nonce % info.responses.size() % info.responses_required;
+                  % nonce % info->responses.size() % info->responses_required;
 
-    info.retry_timer->expires_from_now(BROADCAST_RETRY_TIME);
-    info.retry_timer->async_wait([weak_this = weak_from_this(), nonce](const auto& ec2)
-    {
-        if (auto strong_this = weak_this.lock())
-        {
-            strong_this->handle_request_timeout(ec2, nonce);
-        }
-    });
+    info->retries++;
+    this->schedule_deadline(this->retry_time(info->swarm, info->retries), nonce, deadline_type::retry);
 
     // broadcast the retry
     LOG(trace) << "Broadcasting message " << nonce;
-    info.swarm->send_request(*info.request, send_policy::broadcast);
+    info->swarm->send_request(*info->request, send_policy::broadcast);
 }
 
 bool
@@ -133,36 +492,96 @@ db_dispatch::handle_swarm_response(const bzn_envelope& response)
         return true;
     }
 
+    // the rest happens on our strand
+    auto pending = std::make_shared<database_response>(std::move(db_response));
+    this->strand->post([weak_this = weak_from_this(), sender = response.sender(), is_signed = !response.signature().empty()
+        , digest = response_digest(response.database_response()), pending]()
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->handle_database_response(sender, is_signed, digest, std::move(*pending));
+        }
+    });
+
+    return false;
+}
+
+void
+db_dispatch::handle_database_response(const uuid_t& sender, bool is_signed, const std::string& digest
+    , database_response&& db_response)
+{
     auto nonce = db_response.header().nonce();
     LOG(debug) << "Got response for message " << nonce;
 
-    auto i = this->messages.find(nonce);
-    if (i == this->messages.end())
+    auto info = this->messages.find(nonce);
+    if (!info)
     {
         LOG(trace) << "Ignoring db response for unknown or already processed message: " << nonce;
-        return false;
+        return;
+    }
+
+    // updates are only taken from the node that acknowledged the subscription. others may hold a copy from
+    // a broadcast retry, and would repeat them
+    if (db_response.has_subscription_update())
+    {
+        if (!info->update_handler || !info->acknowledged || sender != info->subscribed_node || !is_signed)
+        {
+            LOG(debug) << "Dropping subscription update from " << sender << " for message: " << nonce;
+            return;
+        }
+
+        info->update_handler(db_response.subscription_update());
+        return;
+    }
+
+    if (info->acknowledged)
+    {
+        LOG(trace) << "Ignoring repeated acknowledgement for subscription: " << nonce;
+        return;
     }
 
     // all responses apart from quickreads require a signature
     // TODO: this isn't ideal if we want to enable/disable signatures globally
-    if (!db_response.has_quick_read() && response.signature().empty())
+    if (!db_response.has_quick_read() && !is_signed)
     {
         LOG(debug) << "Dropping unsigned response for message: " << nonce;
-        return false;
+        return;
     }
 
-    auto& info = i->second;
-    info.responses[response.sender()] = std::move(db_response);
-    if (this->qualify_response(info, response.sender()))
+    this->record_response(*info, sender, digest, std::move(db_response));
+    if (this->qualify_response(*info, sender))
     {
-        // TODO: how do subscription responses work here?
-        boost::system::error_code ec;
-        info.handler(info.responses[response.sender()], ec);
-        LOG(debug) << "Done processing db response for message " << nonce;
-        this->messages.erase(nonce);
-    }
+        // finish with the entry before calling the handler, which may issue or cancel requests
+        this->record_latency(*info);
 
-    return false;
+        auto response = std::move(info->responses[sender]);
+        db_response_handler_t handler;
+        if (info->update_handler && !response.has_error())
+        {
+            // keep the subscription registered, but stop retrying and timing it out
+            LOG(debug) << "Subscription acknowledged for message " << nonce;
+            handler = info->handler;
+            info->acknowledged = true;
+            info->subscribed_node = sender;
+            this->subscriptions.insert(nonce);
+            info->retrying = false;
+            info->responses.clear();
+            info->response_digests.clear();
+            info->digest_counts.clear();
+
+            // an established subscription doesn't count as in flight
+            info->admitted = false;
+            this->admission.release(info->swarm.get());
+        }
+        else
+        {
+            LOG(debug) << "Done processing db response for message " << nonce;
+            handler = std::move(info->handler);
+            this->finish_request(nonce);
+        }
+
+        handler(response, boost::system::error_code{});
+    }
 }
 
 bool
@@ -189,18 +608,32 @@ db_dispatch::handle_swarm_error(const bzn_envelope& response)
         return true;
     }
 
-    auto msg_it = this->messages.find(nonce);
-    if (msg_it == this->messages.end())
+    this->strand->post([weak_this = weak_from_this(), nonce, err]()
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->handle_error_response(nonce, err);
+        }
+    });
+
+    return false;
+}
+
+void
+db_dispatch::handle_error_response(nonce_t nonce, const swarm_error& err)
+{
+    auto info = this->messages.find(nonce);
+    if (!info)
     {
         LOG(trace) << "Ignoring error response for unknown or already processed message: " << nonce;
-        return false;
+        return;
     }
 
     if (err.message() == TIMESTAMP_ERROR_MSG)
     {
         // this request can no longer be processed. Stop retrying
         LOG(debug) << "Out of time window for message " << nonce;
-        this->messages.erase(nonce);
+        this->finish_request(nonce);
     }
     else if (err.message() == TOO_LARGE_ERROR_MSG)
     {
@@ -208,7 +641,7 @@ db_dispatch::handle_swarm_error(const bzn_envelope& response)
         // #TODO we should send an error to the client
         // For now, let the request time out
         LOG(debug) << "Request too large for message " << nonce;
-        this->messages.erase(nonce);
+        this->finish_request(nonce);
     }
     else if (err.message() == TOO_BUSY_ERROR_MSG)
     {
@@ -217,88 +650,99 @@ db_dispatch::handle_swarm_error(const bzn_envelope& response)
     else if (err.message() == DUPLICATE_ERROR_MSG)
     {
         // this request has been received. Stop resending to avoid flooding
-        msg_it->second.retry_timer->cancel();
+        info->retrying = false;
     }
-
-    return false;
 }
 
 
-bool
-db_dispatch::qualify_response(bzapi::db_dispatch::msg_info &info, const uuid_t& sender) const
+void
+db_dispatch::record_response(msg_info& info, const uuid_t& sender, const std::string& digest
+    , database_response&& db_response) const
 {
-    auto num_responses = info.responses.size();
-    if (num_responses < info.responses_required)
+    // a node may resend with a different answer, in which case its old vote no longer counts
+    auto it = info.response_digests.find(sender);
+    if (it != info.response_digests.end())
     {
-        LOG(debug) << boost::format("%1% of %2% responses received") % num_responses % info.responses_required;
-        return false;
+        if (it->second == digest)
+        {
+            return;
+        }
+
+        if (--info.digest_counts[it->second] == 0)
+        {
+            info.digest_counts.erase(it->second);
+        }
     }
 
-    if (info.responses_required == 1)
+    if (!info.digest_counts.count(digest) && !info.digest_counts.empty())
     {
-        assert(num_responses == 1);
-        LOG(debug) << boost::format("%1% of %2% responses received") % num_responses % info.responses_required;
-        return true;
+        LOG(warning) << "Non-matching database response received from " << sender;
     }
 
-    if (info.responses_required > 1)
+    info.response_digests[sender] = digest;
+    ++info.digest_counts[digest];
+    info.responses[sender] = std::move(db_response);
+}
+
+bool
+db_dispatch::qualify_response(const msg_info& info, const uuid_t& sender) const
+{
+    auto num_responses = info.responses.size();
+    if (num_responses < info.responses_required)
     {
-        size_t matches = 0;
-        for (const auto& r : info.responses)
-        {
-            if (this->responses_are_equal(r.second, info.responses[sender]))
-            {
-                if (++matches >= info.responses_required)
-                {
-                    LOG(debug) << boost::format("%1% of %2% matching responses received") % matches % info.responses_required;
-                    return true;
-                }
-            }
-            else
-            {
-                LOG(warning) << "Non-matching database responses received from " << sender << " vs. " << r.first;
-            }
-        }
+        LOG(debug) << boost::format("%1% of %2% responses received") % num_responses % info.responses_required;
+        return false;
     }
 
-    return false;
+    auto matches = info.digest_counts.at(info.response_digests.at(sender));
+    LOG(debug) << boost::format("%1% of %2% matching responses received") % matches % info.responses_required;
+    return matches >= info.responses_required;
 }
 
-bool
-db_dispatch::responses_are_equal(const database_response& r1, const database_response& r2) const
+void
+db_dispatch::handle_client_timeout(nonce_t nonce)
 {
-    return r1.response_case() == r2.response_case() &&
-           r1.SerializeAsString() == r2.SerializeAsString();
+    auto info = this->messages.find(nonce);
+    if (info && !info->acknowledged)
+    {
+        LOG(warning) << "Request timeout querying swarm";
+        auto error = new database_error;
+        error->set_message("Request timeout");
+        database_response response;
+        response.set_allocated_error(error);
+        auto handler = std::move(info->handler);
+        this->finish_request(nonce);
+        handler(response, boost::system::error_code{});
+    }
 }
 
 void
-db_dispatch::setup_client_timeout(nonce_t nonce, msg_info& info)
+db_dispatch::handle_node_disconnect(const swarm_base* swarm, const uuid_t& node)
 {
-    info.timeout_timer = this->io_context->make_unique_steady_timer();
-    info.timeout_timer->expires_from_now(std::chrono::milliseconds {std::chrono::seconds(get_timeout())});
-    info.timeout_timer->async_wait([weak_this = weak_from_this(), nonce](const auto& ec)
+    std::vector<nonce_t> lost;
+    for (auto nonce : this->subscriptions)
     {
-        if (!ec)
+        auto info = this->messages.find(nonce);
+        if (info && info->swarm.get() == swarm && info->subscribed_node == node)
         {
-            if (auto strong_this = weak_this.lock())
-            {
-                auto i = strong_this->messages.find(nonce);
-                if (i != strong_this->messages.end())
-                {
-                    LOG(warning) << "Request timeout querying swarm";
-                    auto error = new database_error;
-                    error->set_message("Request timeout");
-                    database_response response;
-                    response.set_allocated_error(error);
-                    i->second.handler(response, boost::system::error_code{});
-                    strong_this->messages.erase(nonce);
-                }
-            }
+            lost.push_back(nonce);
         }
-    });
+    }
+
+    for (auto nonce : lost)
+    {
+        LOG(warning) << "Lost subscription " << nonce << " held by node " << node;
+        auto handler = std::move(this->messages.find(nonce)->handler);
+        this->finish_request(nonce);
+
+        database_response response;
+        response.mutable_header()->set_nonce(nonce);
+        response.mutable_error()->set_message(SUBSCRIPTION_LOST_MSG);
+        handler(response, boost::system::error_code{});
+    }
 }
 
-void
+uint64_t
 db_dispatch::has_uuid(std::shared_ptr<swarm_base> swarm, uuid_t db_uuid, std::function<void(db_error)> callback)
 {
     bzn_envelope env;
@@ -307,7 +751,7 @@ db_dispatch::has_uuid(std::shared_ptr<swarm_base> swarm, uuid_t db_uuid, std::fu
     request.set_allocated_has_db(new database_has_db);
 
     this->register_swarm_handler(swarm);
-    this->send_message_to_swarm(swarm, db_uuid, request, send_policy::normal, [db_uuid, callback](auto response, auto err)
+    return this->send_request(swarm, db_uuid, request, send_policy::normal, [db_uuid, callback](auto response, auto err)
     {
         if (err)
         {
@@ -330,7 +774,7 @@ db_dispatch::has_uuid(std::shared_ptr<swarm_base> swarm, uuid_t db_uuid, std::fu
                 callback(response.has_db().has() ? db_error::success : db_error::no_database);
             }
         }
-    });
+    }, nullptr);
 }
 
 void
@@ -381,6 +825,20 @@ db_dispatch::register_swarm_handler(std::shared_ptr<swarm_base> swarm)
             }
         });
 
+    swarm->register_disconnect_handler([weak_this = weak_from_this(), swarm = swarm.get()](const uuid_t& node)
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->strand->post([weak_this, swarm, node]()
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    strong_this->handle_node_disconnect(swarm, node);
+                }
+            });
+        }
+    });
+
     swarm->register_response_handler(bzn_envelope::kSwarmError
         , [weak_this = weak_from_this()](const uuid_t& /*uuid*/, const bzn_envelope& env)
         {
@@ -17,24 +17,44 @@
 #pragma once
 
 #include <database/db_dispatch_base.hpp>
+#include <database/nonce_table.hpp>
+#include <database/rtt_estimator.hpp>
+#include <database/timer_wheel.hpp>
+#include <chrono>
+#include <atomic>
+#include <set>
+#include <unordered_map>
 
 namespace bzapi
 {
     // fills in header, sends and tracks outgoing database requests
     // handles incoming database responses
     // applies collation policy and forwards acceptable responses
-    // handles response timeout and resend
+    // handles response timeout and resend, using one timer that drives a timing wheel for all requests
+    // request state is only touched on the dispatcher's strand; signing and parsing happen on the caller's thread
+    // limits the requests in flight, admitting each before it's sent and releasing it once answered
     class db_dispatch : public db_dispatch_base, public std::enable_shared_from_this<db_dispatch>
     {
     public:
         db_dispatch(std::shared_ptr<bzn::asio::io_context_base> io_context);
 
-        void has_uuid(std::shared_ptr<swarm_base> swarm, uuid_t uuid, std::function<void(db_error)> callback) override;
+        uint64_t has_uuid(std::shared_ptr<swarm_base> swarm, uuid_t uuid, std::function<void(db_error)> callback) override;
 
         void create_uuid(std::shared_ptr<swarm_base> swarm, uuid_t uuid, uint64_t max_size, bool random_evict, std::function<void(db_error)> callback) override;
 
         void send_message_to_swarm(std::shared_ptr<swarm_base> swarm, uuid_t uuid, database_msg& msg, send_policy policy, db_response_handler_t handler) override;
 
+        uint64_t subscribe(std::shared_ptr<swarm_base> swarm, uuid_t uuid, const std::string& key
+            , db_response_handler_t handler, subscription_handler_t update_handler) override;
+
+        void unsubscribe(std::shared_ptr<swarm_base> swarm, uuid_t uuid, const std::string& key, uint64_t nonce) override;
+
+        void cancel_request(uint64_t nonce) override;
+
+        bool wait_for_room() override;
+
+        admission_control::stats get_request_stats() override;
+
     private:
         using nonce_t = uint64_t;
 
@@ -44,23 +64,94 @@ namespace bzapi
             std::shared_ptr<bzn_envelope> request;
             send_policy policy;
             uint64_t responses_required;
-            std::shared_ptr<bzn::asio::steady_timer_base> retry_timer;
-            std::shared_ptr<bzn::asio::steady_timer_base> timeout_timer;
+            bool retrying = false;
+            std::chrono::steady_clock::time_point sent_time;
+            uint32_t retries = 0;
+
+            // another node has been asked as well, after the first was slow to answer
+            bool hedged = false;
             std::map<uuid_t, database_response> responses;
+            std::map<uuid_t, std::string> response_digests;
+            std::unordered_map<std::string, size_t> digest_counts;
             db_response_handler_t handler;
+
+            // set for subscriptions, which stay registered once acknowledged to receive updates
+            // from the node that acknowledged them
+            subscription_handler_t update_handler;
+            bool acknowledged = false;
+            uuid_t subscribed_node;
+
+            // counts against the limit on requests in flight
+            bool admitted = true;
         };
 
         const std::shared_ptr<bzn::asio::io_context_base> io_context;
-        nonce_t next_nonce = 1;
-        std::map<nonce_t, msg_info> messages;
+        const std::shared_ptr<bzn::asio::strand_base> strand;
+        std::atomic<nonce_t> next_nonce{1};
+        nonce_table<msg_info> messages;
+
+        // acknowledged subscriptions, which are lost if the node holding them drops its connection
+        std::set<nonce_t> subscriptions;
+        admission_control admission;
+
+        enum class deadline_type
+        {
+            retry,
+            hedge,
+            client_timeout,
+            admission_timeout
+        };
+
+        struct deadline
+        {
+            nonce_t nonce;
+            deadline_type type;
+        };
+
+        // response times of each swarm, used to decide when to resend
+        struct swarm_latency
+        {
+            // time for a quorum to answer
+            rtt_estimator quorum;
+
+            // time for the single node asked by fastest and hedged requests to answer
+            rtt_estimator single;
+        };
+
+        std::map<std::weak_ptr<swarm_base>, swarm_latency, std::owner_less<std::weak_ptr<swarm_base>>> latencies;
+
+        timer_wheel<deadline> deadlines;
+        std::unique_ptr<bzn::asio::steady_timer_base> tick_timer;
+        std::chrono::steady_clock::time_point last_tick;
+        bool ticking = false;
 
+        nonce_t send_request(std::shared_ptr<swarm_base> swarm, const uuid_t& uuid, database_msg& msg, send_policy policy
+            , db_response_handler_t handler, subscription_handler_t update_handler);
+        void start_request(std::shared_ptr<swarm_base> swarm, std::shared_ptr<bzn_envelope> env, send_policy policy
+            , nonce_t nonce, db_response_handler_t handler, subscription_handler_t update_handler);
+        void reject_request(nonce_t nonce, db_response_handler_t handler);
+        void finish_request(nonce_t nonce);
+        static admission_control::limits request_limits();
         void setup_request_policy(msg_info& info, send_policy policy, nonce_t nonce);
-        void handle_request_timeout(const boost::system::error_code& ec, nonce_t nonce);
+        void handle_request_timeout(nonce_t nonce);
+        void handle_hedge_timeout(nonce_t nonce);
+        std::chrono::milliseconds retry_time(const std::shared_ptr<swarm_base>& swarm, uint32_t retries);
+        std::chrono::milliseconds hedge_time(const std::shared_ptr<swarm_base>& swarm);
+        void record_latency(const msg_info& info);
+        void schedule_deadline(std::chrono::milliseconds delay, nonce_t nonce, deadline_type type);
+        void start_ticking();
+        void handle_tick(const boost::system::error_code& ec);
+        void handle_deadline(const deadline& d);
         bool handle_swarm_response(const bzn_envelope& response);
+        void handle_database_response(const uuid_t& sender, bool is_signed, const std::string& digest
+            , database_response&& db_response);
         bool handle_swarm_error(const bzn_envelope& response);
-        bool qualify_response(msg_info& info, const uuid_t& sender) const;
-        bool responses_are_equal(const database_response& r1, const database_response& r2) const;
-        void setup_client_timeout(nonce_t nonce, msg_info& info);
+        void handle_error_response(nonce_t nonce, const swarm_error& err);
+        void record_response(msg_info& info, const uuid_t& sender, const std::string& digest
+            , database_response&& db_response) const;
+        bool qualify_response(const msg_info& info, const uuid_t& sender) const;
+        void handle_client_timeout(nonce_t nonce);
+        void handle_node_disconnect(const swarm_base* swarm, const uuid_t& node);
         void register_swarm_handler(std::shared_ptr<swarm_base> swarm);
 
     };
@@ -17,21 +17,42 @@
 #pragma once
 
 #include <include/bluzelle.hpp>
+#include <database/admission_control.hpp>
 #include <proto/database.pb.h>
 #include <swarm/swarm_base.hpp>
 
 namespace bzapi
 {
     using db_response_handler_t = std::function<void(const database_response &response, const boost::system::error_code &error)>;
+    using subscription_handler_t = std::function<void(const database_subscription_update& update)>;
 
     class db_dispatch_base
     {
     public:
         virtual ~db_dispatch_base() = default;
-        virtual void has_uuid(std::shared_ptr<swarm_base> swarm, uuid_t uuid, std::function<void(db_error)> callback) = 0;
+        // returns the request's nonce, which cancel_request takes
+        virtual uint64_t has_uuid(std::shared_ptr<swarm_base> swarm, uuid_t uuid, std::function<void(db_error)> callback) = 0;
         virtual void create_uuid(std::shared_ptr<swarm_base> swarm, uuid_t uuid, uint64_t max_size, bool random_evict, std::function<void(db_error)> callback) = 0;
 
         virtual void send_message_to_swarm(std::shared_ptr<swarm_base> swarm, uuid_t uuid, database_msg& msg, send_policy policy, db_response_handler_t handler) = 0;
+
+        // subscribe to changes to a key. handler receives the swarm's acknowledgement, after which updates
+        // are passed to update_handler until unsubscribe is called with the returned nonce. if the node
+        // holding the subscription drops its connection, handler is called again with an error and no more
+        // updates arrive
+        virtual uint64_t subscribe(std::shared_ptr<swarm_base> swarm, uuid_t uuid, const std::string& key
+            , db_response_handler_t handler, subscription_handler_t update_handler) = 0;
+
+        virtual void unsubscribe(std::shared_ptr<swarm_base> swarm, uuid_t uuid, const std::string& key, uint64_t nonce) = 0;
+
+        // stop waiting on a request; its handler isn't called. one still queued for admission is never sent
+        virtual void cancel_request(uint64_t nonce) = 0;
+
+        // block until there's room for another request in flight, for the block overload policy.
+        // only for callers that may block, never network threads. returns false if the wait timed out
+        virtual bool wait_for_room() = 0;
+
+        virtual admission_control::stats get_request_stats() = 0;
     };
 
 }
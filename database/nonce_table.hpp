@@ -0,0 +1,155 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace bzapi
+{
+    // table of in-flight requests indexed by nonce, with O(1) insert, lookup and erase
+    // nonces are handed out sequentially, so most live entries sit in a ring indexed by the low bits
+    // of the nonce. an entry that lives long enough to be lapped by newer ones (e.g. a subscription)
+    // is moved aside to an overflow map rather than growing the ring.
+    // values are held by pointer, so references stay valid until the entry is erased, even if
+    // handlers called while holding one insert further requests
+    // not thread safe: db_dispatch only touches it on its strand
+    template <typename T>
+    class nonce_table
+    {
+    public:
+        using nonce_t = uint64_t;
+
+        explicit nonce_table(size_t initial_capacity = 1024)
+        : slots(round_up(initial_capacity))
+        {
+        }
+
+        T& insert(nonce_t nonce, T&& value)
+        {
+            this->erase(nonce);
+
+            auto& s = this->slot_for(nonce);
+            if (s.value)
+            {
+                if (this->ring_count > this->slots.size() / 2)
+                {
+                    this->grow();
+                    return this->insert(nonce, std::move(value));
+                }
+
+                // older entry has been lapped
+                this->overflow.emplace(s.nonce, std::move(s.value));
+                this->ring_count--;
+            }
+
+            s.nonce = nonce;
+            s.value = std::make_unique<T>(std::move(value));
+            this->ring_count++;
+            return *s.value;
+        }
+
+        T* find(nonce_t nonce)
+        {
+            auto& s = this->slot_for(nonce);
+            if (s.value && s.nonce == nonce)
+            {
+                return s.value.get();
+            }
+
+            auto it = this->overflow.find(nonce);
+            return it == this->overflow.end() ? nullptr : it->second.get();
+        }
+
+        bool erase(nonce_t nonce)
+        {
+            auto& s = this->slot_for(nonce);
+            if (s.value && s.nonce == nonce)
+            {
+                s.value.reset();
+                this->ring_count--;
+                return true;
+            }
+
+            return this->overflow.erase(nonce) > 0;
+        }
+
+        size_t size() const
+        {
+            return this->ring_count + this->overflow.size();
+        }
+
+    private:
+        struct slot
+        {
+            nonce_t nonce = 0;
+            std::unique_ptr<T> value;
+        };
+
+        std::vector<slot> slots;
+        size_t ring_count = 0;
+        std::unordered_map<nonce_t, std::unique_ptr<T>> overflow;
+
+        static size_t round_up(size_t n)
+        {
+            size_t result = 1;
+            while (result < n)
+            {
+                result <<= 1;
+            }
+
+            return result;
+        }
+
+        slot& slot_for(nonce_t nonce)
+        {
+            return this->slots[nonce & (this->slots.size() - 1)];
+        }
+
+        void grow()
+        {
+            std::vector<slot> old(this->slots.size() * 2);
+            old.swap(this->slots);
+            this->ring_count = 0;
+
+            for (auto& s : old)
+            {
+                if (s.value)
+                {
+                    auto& target = this->slot_for(s.nonce);
+                    if (target.value)
+                    {
+                        // keep the newer of the two in the ring
+                        auto& older = target.nonce < s.nonce ? target : s;
+                        this->overflow.emplace(older.nonce, std::move(older.value));
+                        if (&older == &s)
+                        {
+                            continue;
+                        }
+
+                        this->ring_count--;
+                    }
+
+                    target.nonce = s.nonce;
+                    target.value = std::move(s.value);
+                    this->ring_count++;
+                }
+            }
+        }
+    };
+}
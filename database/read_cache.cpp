@@ -0,0 +1,248 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <database/read_cache.hpp>
+
+using namespace bzapi;
+
+read_cache::read_cache(size_t max_entries, std::chrono::milliseconds max_age)
+: max_entries(std::max(max_entries, size_t{1})), max_age(max_age)
+{
+}
+
+bool
+read_cache::get(const std::string& key, std::string& value)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    auto it = this->entries.find(key);
+    if (it == this->entries.end())
+    {
+        return false;
+    }
+
+    auto& e = it->second;
+    if (!e.valid || e.state != subscription_state::active)
+    {
+        return false;
+    }
+
+    if (std::chrono::steady_clock::now() - e.fetched > this->max_age)
+    {
+        clear_value(e);
+        return false;
+    }
+
+    this->touch(e);
+    value = e.value;
+    return true;
+}
+
+uint64_t
+read_cache::begin_read(const std::string& key, evicted_list& evicted)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    // the entry has to exist while the read is outstanding so an invalidation can be noticed
+    auto& e = this->find_or_create(key);
+    this->touch(e);
+    this->trim(evicted);
+    return e.generation;
+}
+
+read_cache::put_result
+read_cache::put(const std::string& key, const std::string& value, uint64_t generation)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    put_result result;
+    auto it = this->entries.find(key);
+    if (it == this->entries.end() || it->second.generation != generation)
+    {
+        // evicted or changed while the read was outstanding
+        return result;
+    }
+
+    auto& e = it->second;
+    e.value = value;
+    e.valid = true;
+    e.fetched = std::chrono::steady_clock::now();
+    this->touch(e);
+
+    if (e.state == subscription_state::none)
+    {
+        e.state = subscription_state::pending;
+        result.subscribe = true;
+    }
+
+    this->trim(result.evicted);
+    return result;
+}
+
+void
+read_cache::abandon_read(const std::string& key, uint64_t generation)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    auto it = this->entries.find(key);
+    if (it == this->entries.end() || it->second.generation != generation || it->second.valid
+        || it->second.state != subscription_state::none)
+    {
+        return;
+    }
+
+    this->lru_order.erase(it->second.lru);
+    this->entries.erase(it);
+}
+
+void
+read_cache::invalidate(const std::string& key)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    auto it = this->entries.find(key);
+    if (it != this->entries.end())
+    {
+        clear_value(it->second);
+    }
+}
+
+void
+read_cache::update(const std::string& key, uint64_t seq)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    auto it = this->entries.find(key);
+    if (it == this->entries.end())
+    {
+        return;
+    }
+
+    auto& e = it->second;
+    if (seq && seq <= e.last_seq)
+    {
+        LOG(trace) << "Ignoring out of order subscription update for key: " << key;
+        return;
+    }
+
+    e.last_seq = seq;
+    clear_value(e);
+}
+
+bool
+read_cache::subscription_active(const std::string& key, nonce_t nonce)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    auto it = this->entries.find(key);
+    if (it == this->entries.end() || it->second.state != subscription_state::pending)
+    {
+        return false;
+    }
+
+    // changes made before the subscription took effect were not reported to us, so anything read
+    // up to now (including reads still outstanding) can't be trusted
+    it->second.state = subscription_state::active;
+    it->second.nonce = nonce;
+    clear_value(it->second);
+    return true;
+}
+
+void
+read_cache::subscription_failed(const std::string& key)
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    auto it = this->entries.find(key);
+    if (it != this->entries.end())
+    {
+        it->second.state = subscription_state::none;
+        clear_value(it->second);
+    }
+}
+
+std::vector<std::pair<std::string, read_cache::nonce_t>>
+read_cache::clear()
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+
+    std::vector<std::pair<std::string, nonce_t>> result;
+    for (const auto& e : this->entries)
+    {
+        if (e.second.state == subscription_state::active)
+        {
+            result.emplace_back(e.first, e.second.nonce);
+        }
+    }
+
+    // outstanding subscription requests will find their key gone and be cancelled when acknowledged
+    this->entries.clear();
+    this->lru_order.clear();
+    return result;
+}
+
+size_t
+read_cache::size()
+{
+    std::scoped_lock<std::mutex> guard(this->lock);
+    return this->entries.size();
+}
+
+read_cache::entry&
+read_cache::find_or_create(const std::string& key)
+{
+    auto it = this->entries.find(key);
+    if (it != this->entries.end())
+    {
+        return it->second;
+    }
+
+    this->lru_order.push_front(key);
+    auto& e = this->entries[key];
+    e.lru = this->lru_order.begin();
+    return e;
+}
+
+void
+read_cache::touch(entry& e)
+{
+    this->lru_order.splice(this->lru_order.begin(), this->lru_order, e.lru);
+}
+
+void
+read_cache::clear_value(entry& e)
+{
+    e.valid = false;
+    e.value.clear();
+    e.generation++;
+}
+
+void
+read_cache::trim(evicted_list& evicted)
+{
+    // make room, keeping the entry most recently used, which is the one the caller is working on
+    while (this->entries.size() > this->max_entries)
+    {
+        auto victim = this->entries.find(this->lru_order.back());
+        if (victim->second.state == subscription_state::active)
+        {
+            evicted.emplace_back(victim->first, victim->second.nonce);
+        }
+
+        this->lru_order.pop_back();
+        this->entries.erase(victim);
+    }
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <include/bluzelle.hpp>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+namespace bzapi
+{
+    // local copies of recently read values, kept for keys the database is subscribed to
+    // entries are dropped when the swarm reports a change (in seq order), when we write the key
+    // ourselves, or once they reach max_age, which bounds staleness if a subscription is lost
+    class read_cache
+    {
+    public:
+        using nonce_t = uint64_t;
+        using evicted_list = std::vector<std::pair<std::string, nonce_t>>;
+
+        struct put_result
+        {
+            // the key has no subscription yet and the caller should create one
+            bool subscribe = false;
+
+            // subscriptions of keys evicted to make room, which the caller should cancel
+            evicted_list evicted;
+        };
+
+        read_cache(size_t max_entries, std::chrono::milliseconds max_age);
+
+        // fetch a value if we have a fresh copy held up to date by an active subscription
+        bool get(const std::string& key, std::string& value);
+
+        // called before reading a key from the swarm. returns a generation that must be passed to put or
+        // abandon_read. adds subscriptions of keys evicted to make room to evicted, for the caller to cancel
+        uint64_t begin_read(const std::string& key, evicted_list& evicted);
+
+        // store a value read from the swarm, unless the key has changed since begin_read
+        put_result put(const std::string& key, const std::string& value, uint64_t generation);
+
+        // the read failed, so drop the key unless it holds a value or subscription
+        void abandon_read(const std::string& key, uint64_t generation);
+
+        // drop any copy of the key
+        void invalidate(const std::string& key);
+
+        // apply a subscription update. updates older than one already seen are ignored
+        void update(const std::string& key, uint64_t seq);
+
+        // record the outcome of a subscription request. returns false if the key is no longer cached,
+        // in which case the subscription should be cancelled
+        bool subscription_active(const std::string& key, nonce_t nonce);
+        void subscription_failed(const std::string& key);
+
+        // discard everything, returning the subscriptions held so they can be cancelled
+        std::vector<std::pair<std::string, nonce_t>> clear();
+
+        size_t size();
+
+    private:
+        enum class subscription_state { none, pending, active };
+
+        struct entry
+        {
+            std::string value;
+            bool valid = false;
+            std::chrono::steady_clock::time_point fetched;
+            uint64_t generation = 0;
+            uint64_t last_seq = 0;
+            subscription_state state = subscription_state::none;
+            nonce_t nonce = 0;
+            std::list<std::string>::iterator lru;
+        };
+
+        const size_t max_entries;
+        const std::chrono::milliseconds max_age;
+
+        std::mutex lock;
+        std::unordered_map<std::string, entry> entries;
+        std::list<std::string> lru_order;
+
+        entry& find_or_create(const std::string& key);
+        void touch(entry& e);
+        void trim(evicted_list& evicted);
+        static void clear_value(entry& e);
+    };
+}
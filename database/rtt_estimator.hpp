@@ -0,0 +1,70 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace bzapi
+{
+    // smoothed round trip time and its variation, as used for tcp retransmission timeouts (rfc 6298)
+    class rtt_estimator
+    {
+    public:
+        void add_sample(std::chrono::microseconds rtt)
+        {
+            if (!this->samples++)
+            {
+                this->srtt = rtt;
+                this->rttvar = rtt / 2;
+                return;
+            }
+
+            auto err = this->srtt > rtt ? this->srtt - rtt : rtt - this->srtt;
+            this->rttvar = (3 * this->rttvar + err) / 4;
+            this->srtt = (7 * this->srtt + rtt) / 8;
+        }
+
+        bool empty() const
+        {
+            return this->samples == 0;
+        }
+
+        std::chrono::microseconds smoothed() const
+        {
+            return this->srtt;
+        }
+
+        std::chrono::microseconds variation() const
+        {
+            return this->rttvar;
+        }
+
+        // time after which a request can be considered lost. the variation term is at least the
+        // granularity of the timer that will be used to wait for it
+        std::chrono::microseconds timeout(std::chrono::microseconds granularity) const
+        {
+            return this->srtt + std::max(granularity, 4 * this->rttvar);
+        }
+
+    private:
+        uint64_t samples = 0;
+        std::chrono::microseconds srtt{0};
+        std::chrono::microseconds rttvar{0};
+    };
+}
@@ -0,0 +1,236 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <database/admission_control.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace bzapi;
+using namespace std::chrono_literals;
+
+namespace
+{
+    admission_control::limits
+    make_limits(size_t max_requests, size_t max_group_requests, overload_policy policy
+        , std::chrono::milliseconds max_wait = 10s)
+    {
+        admission_control::limits limits;
+        limits.max_requests = max_requests;
+        limits.max_group_requests = max_group_requests;
+        limits.policy = policy;
+        limits.max_wait = max_wait;
+        return limits;
+    }
+
+    const int group1{};
+    const int group2{};
+}
+
+
+TEST(admission_control_test, no_limits)
+{
+    admission_control admission;
+    auto limits = make_limits(0, 0, overload_policy::fail_fast);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        EXPECT_EQ(admission.admit(&group1, i, limits, nullptr), admission_control::result::admitted);
+    }
+
+    EXPECT_EQ(admission.get_stats().in_flight, 1000u);
+    EXPECT_EQ(admission.get_stats().rejected, 0u);
+}
+
+TEST(admission_control_test, queue)
+{
+    admission_control admission;
+    auto limits = make_limits(2, 0, overload_policy::queue);
+
+    std::vector<bool> started;
+    auto start = [&](bool admitted)
+    {
+        started.push_back(admitted);
+    };
+
+    EXPECT_EQ(admission.admit(&group1, 1, limits, start), admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group2, 2, limits, start), admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group1, 3, limits, start), admission_control::result::queued);
+    EXPECT_EQ(admission.admit(&group2, 4, limits, start), admission_control::result::queued);
+    EXPECT_TRUE(started.empty());
+    EXPECT_EQ(admission.get_stats().waiting, 2u);
+
+    // queued requests start in order as others finish
+    admission.release(&group2);
+    EXPECT_EQ(started, std::vector<bool>{true});
+    admission.release(&group1);
+    EXPECT_EQ(started, std::vector<bool>({true, true}));
+
+    auto stats = admission.get_stats();
+    EXPECT_EQ(stats.in_flight, 2u);
+    EXPECT_EQ(stats.waiting, 0u);
+    EXPECT_EQ(stats.max_waiting, 2u);
+    EXPECT_EQ(stats.admitted, 4u);
+    EXPECT_EQ(stats.delayed, 2u);
+    EXPECT_EQ(stats.rejected, 0u);
+}
+
+TEST(admission_control_test, per_group_limit)
+{
+    admission_control admission;
+    auto limits = make_limits(0, 1, overload_policy::queue);
+
+    size_t started = 0;
+    auto start = [&](bool admitted)
+    {
+        EXPECT_TRUE(admitted);
+        started++;
+    };
+
+    EXPECT_EQ(admission.admit(&group1, 1, limits, start), admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group1, 2, limits, start), admission_control::result::queued);
+
+    // a busy group doesn't hold up another
+    EXPECT_EQ(admission.admit(&group2, 3, limits, start), admission_control::result::admitted);
+    admission.release(&group2);
+    EXPECT_EQ(started, 0u);
+
+    admission.release(&group1);
+    EXPECT_EQ(started, 1u);
+}
+
+TEST(admission_control_test, queue_expiry)
+{
+    admission_control admission;
+    auto limits = make_limits(1, 0, overload_policy::queue, 1ms);
+
+    std::vector<bool> started;
+    EXPECT_EQ(admission.admit(&group1, 1, limits, nullptr), admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group1, 2, limits, [&](bool admitted) { started.push_back(admitted); })
+        , admission_control::result::queued);
+
+    std::this_thread::sleep_for(10ms);
+    admission.release(&group1);
+    EXPECT_EQ(started, std::vector<bool>{false});
+    EXPECT_EQ(admission.get_stats().rejected, 1u);
+    EXPECT_EQ(admission.get_stats().in_flight, 0u);
+}
+
+TEST(admission_control_test, raised_limits_start_queued_requests)
+{
+    admission_control admission;
+
+    size_t started = 0;
+    auto start = [&](bool)
+    {
+        started++;
+    };
+
+    EXPECT_EQ(admission.admit(&group1, 1, make_limits(1, 0, overload_policy::queue), start)
+        , admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group1, 2, make_limits(1, 0, overload_policy::queue), start)
+        , admission_control::result::queued);
+    EXPECT_EQ(admission.admit(&group1, 3, make_limits(3, 0, overload_policy::queue), start)
+        , admission_control::result::admitted);
+    EXPECT_EQ(started, 1u);
+    EXPECT_EQ(admission.get_stats().in_flight, 3u);
+}
+
+TEST(admission_control_test, fail_fast)
+{
+    admission_control admission;
+    auto limits = make_limits(1, 0, overload_policy::fail_fast);
+
+    EXPECT_EQ(admission.admit(&group1, 1, limits, nullptr), admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group1, 2, limits, nullptr), admission_control::result::rejected);
+    EXPECT_EQ(admission.get_stats().rejected, 1u);
+
+    admission.release(&group1);
+    EXPECT_EQ(admission.admit(&group1, 3, limits, nullptr), admission_control::result::admitted);
+}
+
+TEST(admission_control_test, block_queues)
+{
+    admission_control admission;
+    auto limits = make_limits(1, 0, overload_policy::block, 5s);
+
+    // admit never blocks, as that could hold up the thread that would make room
+    std::vector<bool> started;
+    EXPECT_EQ(admission.admit(&group1, 1, limits, nullptr), admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group1, 2, limits, [&](bool admitted) { started.push_back(admitted); })
+        , admission_control::result::queued);
+
+    admission.release(&group1);
+    EXPECT_EQ(started, std::vector<bool>{true});
+}
+
+TEST(admission_control_test, wait_for_room)
+{
+    admission_control admission;
+    auto limits = make_limits(1, 0, overload_policy::block, 5s);
+
+    EXPECT_TRUE(admission.wait_for_room(limits));
+    EXPECT_EQ(admission.admit(&group1, 1, limits, nullptr), admission_control::result::admitted);
+
+    std::thread releaser([&]()
+    {
+        std::this_thread::sleep_for(50ms);
+        admission.release(&group1);
+    });
+
+    // waits for the release, without taking the room
+    EXPECT_TRUE(admission.wait_for_room(limits));
+    releaser.join();
+
+    auto stats = admission.get_stats();
+    EXPECT_EQ(stats.in_flight, 0u);
+    EXPECT_EQ(stats.delayed, 1u);
+    EXPECT_GE(stats.max_wait, 40ms);
+
+    // or gives up
+    EXPECT_EQ(admission.admit(&group1, 2, limits, nullptr), admission_control::result::admitted);
+    EXPECT_FALSE(admission.wait_for_room(make_limits(1, 0, overload_policy::block, 10ms)));
+    EXPECT_EQ(admission.get_stats().rejected, 1u);
+}
+
+TEST(admission_control_test, expire_and_withdraw)
+{
+    admission_control admission;
+    auto limits = make_limits(1, 0, overload_policy::queue);
+
+    std::vector<std::pair<int, bool>> started;
+    auto start = [&](int id)
+    {
+        return [&started, id](bool admitted) { started.emplace_back(id, admitted); };
+    };
+
+    EXPECT_EQ(admission.admit(&group1, 1, limits, start(1)), admission_control::result::admitted);
+    EXPECT_EQ(admission.admit(&group1, 2, limits, start(2)), admission_control::result::queued);
+    EXPECT_EQ(admission.admit(&group1, 3, limits, start(3)), admission_control::result::queued);
+    EXPECT_EQ(admission.admit(&group1, 4, limits, start(4)), admission_control::result::queued);
+
+    // an expired request fails without waiting for a release
+    EXPECT_TRUE(admission.expire(2));
+    EXPECT_EQ(started, (std::vector<std::pair<int, bool>>{{2, false}}));
+    EXPECT_EQ(admission.get_stats().rejected, 1u);
+
+    // a withdrawn one is never started
+    EXPECT_TRUE(admission.withdraw(3));
+    EXPECT_FALSE(admission.withdraw(3));
+    EXPECT_FALSE(admission.expire(1));
+
+    admission.release(&group1);
+    EXPECT_EQ(started, (std::vector<std::pair<int, bool>>{{2, false}, {4, true}}));
+    EXPECT_EQ(admission.get_stats().waiting, 0u);
+}
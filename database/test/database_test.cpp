@@ -145,7 +145,7 @@ TEST_F(database_test, test_quick_read)
     {
         EXPECT_TRUE(msg.has_quick_read());
         EXPECT_EQ(msg.quick_read().key(), "key");
-        EXPECT_EQ(policy, send_policy::fastest);
+        EXPECT_EQ(policy, send_policy::hedged);
 
         database_response response;
         database_quick_read_response read_response;
@@ -377,3 +377,286 @@ TEST_F(database_test, test_remove_writer)
     EXPECT_EQ(resp_json["result"].asBool(), false);
     EXPECT_EQ(resp_json["error"].asString(), std::string("Writer not found"));
 }
+
+TEST_F(database_test, test_batch_create)
+{
+    std::vector<std::string> sent;
+    EXPECT_CALL(*dbi, send_message_to_swarm(_, _, _, _, _)).Times(Exactly(3)).WillRepeatedly(Invoke([&](auto& /*sw*/
+        , auto& /*uuid*/, database_msg& msg, auto policy, auto handler)
+    {
+        EXPECT_TRUE(msg.has_create());
+        EXPECT_EQ(msg.create().value(), "value_" + msg.create().key());
+        EXPECT_EQ(msg.create().expire(), 10u);
+        EXPECT_EQ(policy, send_policy::normal);
+        sent.push_back(msg.create().key());
+
+        database_response response;
+        handler(response, boost::system::error_code{});
+    }));
+
+    auto result = db.batch_create({{"key1", "value_key1"}, {"key2", "value_key2"}, {"key3", "value_key3"}}, 10);
+    Json::Value resp_json;
+    Json::Reader reader;
+    EXPECT_TRUE(reader.parse(result, resp_json));
+    EXPECT_EQ(resp_json["result"].asBool(), true);
+    EXPECT_EQ(sent, std::vector<std::string>({"key1", "key2", "key3"}));
+    ASSERT_EQ(resp_json["results"].size(), 3u);
+    for (Json::ArrayIndex i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(resp_json["results"][i]["key"].asString(), sent[i]);
+        EXPECT_EQ(resp_json["results"][i]["result"].asBool(), true);
+    }
+}
+
+TEST_F(database_test, test_batch_read)
+{
+    EXPECT_CALL(*dbi, send_message_to_swarm(_, _, _, _, _)).Times(Exactly(2)).WillRepeatedly(Invoke([](auto& /*sw*/
+        , auto& /*uuid*/, database_msg& msg, auto policy, auto handler)
+    {
+        EXPECT_TRUE(msg.has_read());
+        EXPECT_EQ(policy, send_policy::normal);
+
+        database_response response;
+        if (msg.read().key() == "key1")
+        {
+            response.mutable_read()->set_key("key1");
+            response.mutable_read()->set_value("value1");
+        }
+        else
+        {
+            response.mutable_error()->set_message("RECORD_NOT_FOUND");
+        }
+        handler(response, boost::system::error_code{});
+    }));
+
+    auto result = db.batch_read({"key1", "key2"});
+    Json::Value resp_json;
+    Json::Reader reader;
+    EXPECT_TRUE(reader.parse(result, resp_json));
+    EXPECT_EQ(resp_json["result"].asBool(), false);
+    EXPECT_EQ(resp_json["error"].asString(), "1 of 2 requests failed");
+    ASSERT_EQ(resp_json["results"].size(), 2u);
+    EXPECT_EQ(resp_json["results"][0]["key"].asString(), "key1");
+    EXPECT_EQ(resp_json["results"][0]["value"].asString(), "value1");
+    EXPECT_EQ(resp_json["results"][1]["key"].asString(), "key2");
+    EXPECT_EQ(resp_json["results"][1]["error"].asString(), "RECORD_NOT_FOUND");
+}
+
+TEST_F(database_test, test_batch_empty)
+{
+    EXPECT_CALL(*dbi, send_message_to_swarm(_, _, _, _, _)).Times(Exactly(0));
+
+    auto result = db.batch_remove({});
+    Json::Value resp_json;
+    Json::Reader reader;
+    EXPECT_TRUE(reader.parse(result, resp_json));
+    EXPECT_EQ(resp_json["result"].asBool(), true);
+    EXPECT_EQ(resp_json["results"].size(), 0u);
+}
+
+TEST_F(database_test, test_typed_read)
+{
+    EXPECT_CALL(*dbi, send_message_to_swarm(_, _, _, _, _)).WillOnce(Invoke([](auto& /*sw*/, auto& /*uuid*/
+        , database_msg& msg, auto policy, auto handler)
+    {
+        EXPECT_TRUE(msg.has_read());
+        EXPECT_EQ(msg.read().key(), "key");
+        EXPECT_EQ(policy, send_policy::normal);
+
+        database_response response;
+        response.mutable_read()->set_key("key");
+        response.mutable_read()->set_value("value");
+        handler(response, boost::system::error_code{});
+    }));
+
+    bool called = false;
+    adb->read("key", [&](const db_status& status, std::string_view value)
+    {
+        EXPECT_TRUE(status.ok());
+        EXPECT_EQ(value, "value");
+        called = true;
+    });
+    EXPECT_TRUE(called);
+}
+
+TEST_F(database_test, test_typed_futures)
+{
+    EXPECT_CALL(*dbi, send_message_to_swarm(_, _, _, _, _)).Times(Exactly(3)).WillRepeatedly(Invoke([](auto& /*sw*/
+        , auto& /*uuid*/, database_msg& msg, auto /*policy*/, auto handler)
+    {
+        database_response response;
+        if (msg.has_size())
+        {
+            response.mutable_size()->set_bytes(123);
+            response.mutable_size()->set_keys(12);
+            handler(response, boost::system::error_code{});
+        }
+        else if (msg.has_has())
+        {
+            response.mutable_has()->set_has(true);
+            handler(response, boost::system::error_code{});
+        }
+        else
+        {
+            handler(response, boost::asio::error::connection_reset);
+        }
+    }));
+
+    auto size = adb->size_future().get();
+    EXPECT_TRUE(size.status.ok());
+    EXPECT_EQ(size.value.bytes, 123u);
+    EXPECT_EQ(size.value.keys, 12u);
+
+    auto has = adb->has_future("key").get();
+    EXPECT_TRUE(has.status.ok());
+    EXPECT_TRUE(has.value);
+
+    auto ttl = adb->ttl_future("key").get();
+    EXPECT_FALSE(ttl.status.ok());
+    EXPECT_EQ(ttl.status.error, static_cast<int>(db_error::connection_error));
+    EXPECT_FALSE(ttl.status.message.empty());
+}
+
+TEST_F(database_test, test_read_cache)
+{
+    adb->set_read_cache(16, 60000);
+
+    size_t reads = 0;
+    EXPECT_CALL(*dbi, send_message_to_swarm(_, _, _, _, _)).WillRepeatedly(Invoke([&](auto& /*sw*/, auto& /*uuid*/
+        , database_msg& msg, auto /*policy*/, auto handler)
+    {
+        database_response response;
+        if (msg.has_read())
+        {
+            reads++;
+            response.mutable_read()->set_key(msg.read().key());
+            response.mutable_read()->set_value("value" + std::to_string(reads));
+        }
+        handler(response, boost::system::error_code{});
+    }));
+
+    db_response_handler_t ack_handler;
+    subscription_handler_t update_handler;
+    EXPECT_CALL(*dbi, subscribe(_, _, "key", _, _)).Times(Exactly(1)).WillOnce(Invoke([&](auto, auto, auto&
+        , auto handler, auto update)
+    {
+        ack_handler = handler;
+        update_handler = update;
+        return 7;
+    }));
+
+    auto read = [&]()
+    {
+        std::string result;
+        adb->read("key", [&](const db_status& status, std::string_view value)
+        {
+            EXPECT_TRUE(status.ok());
+            result = value;
+        });
+        return result;
+    };
+
+    // not cached until the subscription is acknowledged
+    EXPECT_EQ(read(), "value1");
+    EXPECT_EQ(read(), "value2");
+
+    database_response ack;
+    ack.mutable_header()->set_nonce(7);
+    ack_handler(ack, boost::system::error_code{});
+
+    EXPECT_EQ(read(), "value3");
+    EXPECT_EQ(read(), "value3");
+    EXPECT_EQ(reads, 3u);
+
+    // a change made elsewhere invalidates the key
+    database_subscription_update update;
+    update.set_key("key");
+    update.set_seq(1);
+    update_handler(update);
+
+    EXPECT_EQ(read(), "value4");
+    EXPECT_EQ(read(), "value4");
+
+    // as does our own write
+    adb->update("key", "new", [](const db_status& status)
+    {
+        EXPECT_TRUE(status.ok());
+    });
+
+    EXPECT_EQ(read(), "value5");
+    EXPECT_EQ(reads, 5u);
+
+    EXPECT_CALL(*dbi, unsubscribe(_, _, "key", 7)).Times(Exactly(1));
+    adb->set_read_cache(0, 0);
+}
+
+TEST_F(database_test, test_subscribe)
+{
+    db_response_handler_t ack_handler;
+    subscription_handler_t update_handler;
+    EXPECT_CALL(*dbi, subscribe(_, _, "key", _, _)).Times(Exactly(2))
+        .WillOnce(Invoke([&](auto, auto, auto&, auto handler, auto /*update*/)
+        {
+            database_response response;
+            response.mutable_error()->set_message("failed");
+            handler(response, boost::system::error_code{});
+            return 6;
+        }))
+        .WillOnce(Invoke([&](auto, auto, auto&, auto handler, auto update)
+        {
+            ack_handler = handler;
+            update_handler = update;
+            return 7;
+        }));
+
+    std::vector<db_status> statuses;
+    std::vector<db_update> updates;
+    auto subscribe = [&]()
+    {
+        adb->subscribe("key", [&](const db_update& update)
+        {
+            updates.push_back(update);
+        }
+        , [&](const db_status& status)
+        {
+            statuses.push_back(status);
+        });
+    };
+
+    // a failed subscription doesn't prevent another attempt
+    subscribe();
+    ASSERT_EQ(statuses.size(), 1u);
+    EXPECT_FALSE(statuses[0].ok());
+
+    subscribe();
+    ack_handler(database_response{}, boost::system::error_code{});
+    ASSERT_EQ(statuses.size(), 2u);
+    EXPECT_TRUE(statuses[1].ok());
+
+    subscribe();
+    ASSERT_EQ(statuses.size(), 3u);
+    EXPECT_FALSE(statuses[2].ok());
+
+    database_subscription_update update;
+    update.set_key("key");
+    update.set_value("value");
+    update.set_seq(1);
+    update_handler(update);
+
+    update.set_value("");
+    update.set_operation(database_subscription_update::DELETE);
+    update.set_seq(2);
+    update_handler(update);
+
+    ASSERT_EQ(updates.size(), 2u);
+    EXPECT_EQ(updates[0].value, "value");
+    EXPECT_EQ(updates[0].op, db_update::operation::update);
+    EXPECT_EQ(updates[0].seq, 1u);
+    EXPECT_EQ(updates[1].key, "key");
+    EXPECT_EQ(updates[1].op, db_update::operation::remove);
+    EXPECT_EQ(updates[1].seq, 2u);
+
+    EXPECT_CALL(*dbi, unsubscribe(_, _, "key", 7)).Times(Exactly(1));
+    adb->unsubscribe("key");
+    adb->unsubscribe("key");
+}
@@ -33,11 +33,45 @@ namespace
 class db_dispatch_test : public Test
 {
 public:
+    db_dispatch_test()
+    {
+        EXPECT_CALL(*mock_io_context, make_unique_strand()).WillRepeatedly(Invoke([]()
+        {
+            auto strand = std::make_unique<bzn::asio::mock_strand_base>();
+            EXPECT_CALL(*strand, wrap(A<bzn::asio::close_handler>())).WillRepeatedly(ReturnArg<0>());
+            EXPECT_CALL(*strand, post(_)).WillRepeatedly(Invoke([](auto func)
+            {
+                func();
+            }));
+            return strand;
+        }));
+
+        EXPECT_CALL(*swarm, get_point_of_contact(_)).WillRepeatedly(Invoke([](auto policy)
+        {
+            return policy == send_policy::fastest || policy == send_policy::hedged ? "fastest_node" : "primary_node";
+        }));
+
+        EXPECT_CALL(*swarm, register_disconnect_handler(_)).WillRepeatedly(SaveArg<0>(&this->disconnect_handler));
+
+        db = std::make_shared<db_dispatch>(mock_io_context);
+    }
 
 protected:
+    // run the dispatcher's deadline timer for a number of ticks
+    void tick(completion_handler_t& timer_callback, size_t ticks)
+    {
+        for (size_t i = 0; i < ticks; i++)
+        {
+            // the callback is replaced when the timer is re-armed, so call a copy
+            auto callback = timer_callback;
+            callback(boost::system::error_code{});
+        }
+    }
+
     std::shared_ptr<bzn::asio::mock_io_context_base> mock_io_context  = std::make_shared<bzn::asio::mock_io_context_base>();
     std::shared_ptr<mock_swarm> swarm = std::make_shared<mock_swarm>();
-    std::shared_ptr<db_dispatch> db = std::make_shared<db_dispatch>(mock_io_context);
+    std::shared_ptr<db_dispatch> db;
+    swarm_disconnect_handler_t disconnect_handler;
 
 };
 
@@ -62,13 +96,14 @@ TEST_F(db_dispatch_test, basic_test)
             return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
         }));
 
-    EXPECT_CALL(*swarm, sign_and_date_request(_, _)).Times(Exactly(1));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(1));
 
     EXPECT_CALL(*swarm, send_request(_, _)).Times(Exactly(1)).WillOnce(Invoke([&](auto e, auto)
     {
         bzn_envelope env;
         database_msg request;
         EXPECT_TRUE(request.ParseFromString(e.database_msg()));
+        EXPECT_EQ(request.header().point_of_contact(), "fastest_node");
         database_response response;
         *response.mutable_header() = request.header();
         env.set_database_response(response.SerializeAsString());
@@ -102,15 +137,12 @@ TEST_F(db_dispatch_test, collation_and_timeout_test)
         }))
         .WillOnce(Return(true));
 
-    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(AtLeast(2))
+    // one timer handles the deadlines of every request
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1))
     .WillOnce(Invoke([&]
-    {
-        return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
-    }))
-    .WillRepeatedly(Invoke([&]
     {
         auto timer = std::make_unique<bzn::asio::mock_steady_timer_base>();
-        EXPECT_CALL(*timer, expires_from_now(_)).Times(AtLeast(1));
+        EXPECT_CALL(*timer, expires_from_now(std::chrono::milliseconds(100))).Times(AtLeast(1));
         EXPECT_CALL(*timer, async_wait(_)).WillRepeatedly(Invoke([&](auto handler)
         {
             timer_callback = handler;
@@ -120,7 +152,7 @@ TEST_F(db_dispatch_test, collation_and_timeout_test)
 
     EXPECT_CALL(*swarm, honest_majority_size()).Times(Exactly(1)).WillOnce(Return(3));
 
-    EXPECT_CALL(*swarm, sign_and_date_request(_, _)).Times(Exactly(1));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(1));
 
     bool broadcasted = false;
     bzn_envelope envelope;
@@ -133,7 +165,10 @@ TEST_F(db_dispatch_test, collation_and_timeout_test)
             return 0;
         }));
 
-        timer_callback(boost::system::error_code{});
+        // retry is due after 1.5 seconds
+        this->tick(timer_callback, 14);
+        EXPECT_FALSE(broadcasted);
+        this->tick(timer_callback, 1);
         return 0;
     }));
 
@@ -190,6 +225,73 @@ TEST_F(db_dispatch_test, collation_and_timeout_test)
     swarm_response_handler("node3", env);
 }
 
+TEST_F(db_dispatch_test, changed_response_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _))
+        .Times(Exactly(2))
+        .WillOnce(Invoke([&](auto, auto handler)
+        {
+            swarm_response_handler = handler;
+            return true;
+        }))
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1))
+        .WillRepeatedly(Invoke([&]
+        {
+            return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+        }));
+
+    EXPECT_CALL(*swarm, honest_majority_size()).Times(Exactly(1)).WillOnce(Return(3));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(1));
+
+    bzn_envelope envelope;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::normal)).Times(Exactly(1)).WillOnce(Invoke([&](auto e, auto)
+    {
+        envelope = e;
+        return 0;
+    }));
+
+    database_msg request;
+    bool called = false;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request, send_policy::normal, [&](const auto& response, const auto& /*ec*/)
+    {
+        ASSERT_EQ(called, false);
+        EXPECT_FALSE(response.has_error());
+        called = true;
+    });
+
+    ASSERT_TRUE(request.ParseFromString(envelope.database_msg()));
+    database_response response;
+    *response.mutable_header() = request.header();
+    bzn_envelope env;
+    env.set_database_response(response.SerializeAsString());
+    env.set_signature("xxx");
+
+    response.mutable_error()->set_message("error");
+    bzn_envelope env2{env};
+    env2.set_database_response(response.SerializeAsString());
+
+    env.set_sender("node1");
+    swarm_response_handler("node1", env);
+    env.set_sender("node2");
+    swarm_response_handler("node2", env);
+    EXPECT_FALSE(called);
+
+    // node2 changes its answer, so its earlier vote no longer counts
+    env2.set_sender("node2");
+    swarm_response_handler("node2", env2);
+    env.set_sender("node3");
+    swarm_response_handler("node3", env);
+    EXPECT_FALSE(called);
+
+    env.set_sender("node4");
+    swarm_response_handler("node4", env);
+    EXPECT_TRUE(called);
+}
+
 TEST_F(db_dispatch_test, client_timeout_test)
 {
     completion_handler_t timer_callback;
@@ -204,11 +306,7 @@ TEST_F(db_dispatch_test, client_timeout_test)
         .WillOnce(Invoke([&]
         {
             auto timer = std::make_unique<bzn::asio::mock_steady_timer_base>();
-            EXPECT_CALL(*timer, expires_from_now(_)).Times(AtLeast(1)).WillOnce(Invoke([](auto time)
-            {
-                EXPECT_EQ(time, std::chrono::seconds(1));
-                return 0;
-            }));
+            EXPECT_CALL(*timer, expires_from_now(std::chrono::milliseconds(100))).Times(AtLeast(1));
 
             EXPECT_CALL(*timer, async_wait(_)).WillRepeatedly(Invoke([&](auto handler)
             {
@@ -217,13 +315,9 @@ TEST_F(db_dispatch_test, client_timeout_test)
             return timer;
         }));
 
-    EXPECT_CALL(*swarm, sign_and_date_request(_, _)).Times(Exactly(1));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(1));
 
-    EXPECT_CALL(*swarm, send_request(_, _)).Times(Exactly(1)).WillOnce(Invoke([&](auto /*e*/, auto)
-    {
-        timer_callback(boost::system::error_code{});
-        return 0;
-    }));
+    EXPECT_CALL(*swarm, send_request(_, _)).Times(Exactly(1)).WillOnce(Return(0));
 
     database_msg request;
     bool called = false;
@@ -235,6 +329,609 @@ TEST_F(db_dispatch_test, client_timeout_test)
         EXPECT_EQ(response.error().message(), std::string("Request timeout"));
     });
 
+    // times out after one second
+    this->tick(timer_callback, 9);
+    EXPECT_FALSE(called);
+    this->tick(timer_callback, 1);
     EXPECT_TRUE(called);
 }
 
+TEST_F(db_dispatch_test, cancel_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+    completion_handler_t timer_callback;
+
+    bzapi::set_timeout(1);
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _)).WillRepeatedly(Invoke([&](auto type, auto handler)
+    {
+        if (type == bzn_envelope::kDatabaseResponse)
+        {
+            swarm_response_handler = handler;
+        }
+        return true;
+    }));
+    EXPECT_CALL(*swarm, honest_majority_size()).WillRepeatedly(Return(1));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1))
+        .WillOnce(Invoke([&]
+        {
+            auto timer = std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+            EXPECT_CALL(*timer, async_wait(_)).WillRepeatedly(Invoke([&](auto handler)
+            {
+                timer_callback = handler;
+            }));
+            return timer;
+        }));
+
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(1));
+
+    database_msg sent;
+    EXPECT_CALL(*swarm, send_request(_, _)).Times(Exactly(1)).WillOnce(Invoke([&](auto e, auto)
+    {
+        EXPECT_TRUE(sent.ParseFromString(e.database_msg()));
+        return 0;
+    }));
+
+    bool called = false;
+    auto nonce = db->has_uuid(this->swarm, "db_uuid", [&called](auto)
+    {
+        called = true;
+    });
+    EXPECT_EQ(sent.header().nonce(), nonce);
+
+    // a cancelled request is forgotten: neither its answer nor its timeout reach the caller
+    db->cancel_request(nonce);
+
+    database_response response;
+    *response.mutable_header() = sent.header();
+    response.mutable_has_db()->set_uuid("db_uuid");
+    response.mutable_has_db()->set_has(true);
+    bzn_envelope env;
+    env.set_database_response(response.SerializeAsString());
+    env.set_sender("node1");
+    env.set_signature("xxx");
+    ASSERT_NE(swarm_response_handler, nullptr);
+    swarm_response_handler("node1", env);
+
+    this->tick(timer_callback, 20);
+    EXPECT_FALSE(called);
+    EXPECT_EQ(db->get_request_stats().in_flight, 0u);
+}
+
+TEST_F(db_dispatch_test, subscription_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _))
+        .WillOnce(Invoke([&](auto, auto handler)
+        {
+            swarm_response_handler = handler;
+            return true;
+        }))
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).WillRepeatedly(Invoke([&]
+    {
+        return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+    }));
+
+    EXPECT_CALL(*swarm, honest_majority_size()).WillRepeatedly(Return(3));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(2));
+
+    std::vector<database_msg> requests;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::normal)).Times(Exactly(2)).WillRepeatedly(Invoke([&](auto e, auto)
+    {
+        database_msg request;
+        EXPECT_TRUE(request.ParseFromString(e.database_msg()));
+        requests.push_back(request);
+        return 0;
+    }));
+
+    size_t acks = 0;
+    std::vector<uint64_t> updates;
+    auto nonce = db->subscribe(this->swarm, "db_uuid", "key", [&](const auto& response, const auto& ec)
+    {
+        EXPECT_FALSE(ec);
+        EXPECT_FALSE(response.has_error());
+        acks++;
+    }
+    , [&](const database_subscription_update& update)
+    {
+        EXPECT_EQ(update.key(), "key");
+        updates.push_back(update.seq());
+    });
+
+    ASSERT_EQ(requests.size(), 1u);
+    EXPECT_TRUE(requests[0].has_subscribe());
+    EXPECT_EQ(requests[0].header().nonce(), nonce);
+
+    auto respond = [&](const database_response& response, const std::string& sender = "node1"
+        , const std::string& signature = "xxx")
+    {
+        bzn_envelope env;
+        env.set_database_response(response.SerializeAsString());
+        env.set_sender(sender);
+        env.set_signature(signature);
+        swarm_response_handler(sender, env);
+    };
+
+    // updates sent before the acknowledgement aren't trusted
+    database_response early;
+    *early.mutable_header() = requests[0].header();
+    early.mutable_subscription_update()->set_key("key");
+    respond(early);
+    EXPECT_TRUE(updates.empty());
+
+    // a single acknowledgement is enough, and repeats are ignored
+    database_response ack;
+    *ack.mutable_header() = requests[0].header();
+    respond(ack);
+    respond(ack);
+    EXPECT_EQ(acks, 1u);
+
+    database_response update;
+    *update.mutable_header() = requests[0].header();
+    update.mutable_subscription_update()->set_key("key");
+    update.mutable_subscription_update()->set_seq(1);
+    respond(update);
+    update.mutable_subscription_update()->set_seq(2);
+    respond(update);
+    EXPECT_EQ(updates, std::vector<uint64_t>({1, 2}));
+
+    // only the node that acknowledged the subscription, and only with a signature
+    update.mutable_subscription_update()->set_seq(3);
+    respond(update, "node2");
+    respond(update, "node1", "");
+    EXPECT_EQ(updates, std::vector<uint64_t>({1, 2}));
+
+    db->unsubscribe(this->swarm, "db_uuid", "key", nonce);
+    ASSERT_EQ(requests.size(), 2u);
+    EXPECT_TRUE(requests[1].has_unsubscribe());
+    EXPECT_EQ(requests[1].unsubscribe().nonce(), nonce);
+
+    update.mutable_subscription_update()->set_seq(4);
+    respond(update);
+    EXPECT_EQ(updates.size(), 2u);
+}
+
+TEST_F(db_dispatch_test, adaptive_retry_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+    completion_handler_t timer_callback;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _))
+        .WillOnce(Invoke([&](auto, auto handler)
+        {
+            swarm_response_handler = handler;
+            return true;
+        }))
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1)).WillOnce(Invoke([&]
+    {
+        auto timer = std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+        EXPECT_CALL(*timer, async_wait(_)).WillRepeatedly(Invoke([&](auto handler)
+        {
+            timer_callback = handler;
+        }));
+        return timer;
+    }));
+
+    EXPECT_CALL(*swarm, honest_majority_size()).WillRepeatedly(Return(1));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(2));
+
+    // the first request is answered straight away
+    EXPECT_CALL(*swarm, send_request(_, send_policy::normal)).Times(Exactly(2))
+        .WillOnce(Invoke([&](auto e, auto)
+        {
+            database_msg request;
+            EXPECT_TRUE(request.ParseFromString(e.database_msg()));
+            database_response response;
+            *response.mutable_header() = request.header();
+            bzn_envelope env;
+            env.set_database_response(response.SerializeAsString());
+            env.set_sender("node1");
+            env.set_signature("xxx");
+            swarm_response_handler("node1", env);
+            return 0;
+        }))
+        .WillOnce(Return(0));
+
+    size_t broadcasts = 0;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::broadcast)).WillRepeatedly(Invoke([&](auto, auto)
+    {
+        broadcasts++;
+        return 0;
+    }));
+
+    database_msg request;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request, send_policy::normal, [](const auto&, const auto&) {});
+
+    // so the second is resent after the minimum retry time rather than the initial 1.5 seconds
+    database_msg request2;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request2, send_policy::normal, [](const auto&, const auto&) {});
+    this->tick(timer_callback, 1);
+    EXPECT_EQ(broadcasts, 0u);
+    this->tick(timer_callback, 1);
+    EXPECT_EQ(broadcasts, 1u);
+
+    // and backs off after that
+    this->tick(timer_callback, 3);
+    EXPECT_EQ(broadcasts, 1u);
+    this->tick(timer_callback, 1);
+    EXPECT_EQ(broadcasts, 2u);
+}
+
+
+TEST_F(db_dispatch_test, hedged_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+    completion_handler_t timer_callback;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _))
+        .WillOnce(Invoke([&](auto, auto handler)
+        {
+            swarm_response_handler = handler;
+            return true;
+        }))
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1)).WillOnce(Invoke([&]
+    {
+        auto timer = std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+        EXPECT_CALL(*timer, async_wait(_)).WillRepeatedly(Invoke([&](auto handler)
+        {
+            timer_callback = handler;
+        }));
+        return timer;
+    }));
+
+    EXPECT_CALL(*swarm, honest_majority_size()).Times(Exactly(0));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(1));
+
+    bzn_envelope sent;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::hedged)).Times(Exactly(1)).WillOnce(Invoke([&](auto e, auto)
+    {
+        sent = e;
+        return 0;
+    }));
+
+    size_t hedges = 0;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::next_fastest)).WillRepeatedly(Invoke([&](auto, auto)
+    {
+        hedges++;
+        return 0;
+    }));
+
+    size_t responses = 0;
+    database_msg request;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request, send_policy::hedged, [&](const auto&, const auto&)
+    {
+        responses++;
+    });
+
+    // the next fastest node is asked as well once the fastest has taken too long
+    this->tick(timer_callback, 2);
+    EXPECT_EQ(hedges, 0u);
+    this->tick(timer_callback, 1);
+    EXPECT_EQ(hedges, 1u);
+    EXPECT_EQ(responses, 0u);
+
+    // and the first answer from either completes the request
+    database_msg msg;
+    EXPECT_TRUE(msg.ParseFromString(sent.database_msg()));
+    EXPECT_EQ(msg.header().point_of_contact(), "fastest_node");
+    database_response response;
+    *response.mutable_header() = msg.header();
+    bzn_envelope env;
+    env.set_database_response(response.SerializeAsString());
+    env.set_signature("xxx");
+
+    env.set_sender("node2");
+    swarm_response_handler("node2", env);
+    EXPECT_EQ(responses, 1u);
+
+    env.set_sender("node1");
+    swarm_response_handler("node1", env);
+    EXPECT_EQ(responses, 1u);
+
+    // nothing more is sent
+    this->tick(timer_callback, 50);
+    EXPECT_EQ(hedges, 1u);
+}
+
+TEST_F(db_dispatch_test, slow_hedged_reads_are_sampled_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+    completion_handler_t timer_callback;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _))
+        .WillOnce(Invoke([&](auto, auto handler)
+        {
+            swarm_response_handler = handler;
+            return true;
+        }))
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1)).WillOnce(Invoke([&]
+    {
+        auto timer = std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+        EXPECT_CALL(*timer, async_wait(_)).WillRepeatedly(Invoke([&](auto handler)
+        {
+            timer_callback = handler;
+        }));
+        return timer;
+    }));
+
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(AnyNumber());
+
+    bzn_envelope sent;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::hedged)).WillRepeatedly(Invoke([&](auto e, auto)
+    {
+        sent = e;
+        return 0;
+    }));
+
+    size_t hedges = 0;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::next_fastest)).WillRepeatedly(Invoke([&](auto, auto)
+    {
+        hedges++;
+        return 0;
+    }));
+
+    auto read = [&]()
+    {
+        database_msg request;
+        db->send_message_to_swarm(this->swarm, "db_uuid", request, send_policy::hedged, [](const auto&, const auto&) {});
+    };
+
+    auto answer = [&]()
+    {
+        database_msg msg;
+        EXPECT_TRUE(msg.ParseFromString(sent.database_msg()));
+        database_response response;
+        *response.mutable_header() = msg.header();
+        bzn_envelope env;
+        env.set_database_response(response.SerializeAsString());
+        env.set_signature("xxx");
+        env.set_sender("node1");
+        swarm_response_handler("node1", env);
+    };
+
+    // how many ticks a read waits before it's hedged
+    auto hedge_ticks = [&]()
+    {
+        // catch up with the time that's passed, so each tick below is a single one
+        this->tick(timer_callback, 1);
+        auto before = hedges;
+        read();
+        size_t ticks = 0;
+        while (hedges == before && ticks < 50)
+        {
+            this->tick(timer_callback, 1);
+            ticks++;
+        }
+        return ticks;
+    };
+
+    // one quick answer brings the hedge delay down to about a tick
+    read();
+    answer();
+    std::vector<size_t> delays{hedge_ticks()};
+    EXPECT_LE(delays[0], 2u);
+
+    // reads answered after they've been hedged are still sampled, so the delay grows to cover them rather
+    // than falling until everything is hedged
+    for (size_t i = 0; i < 4; i++)
+    {
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(150));
+        answer();
+        delays.push_back(hedge_ticks());
+    }
+
+    EXPECT_TRUE(std::is_sorted(delays.begin(), delays.end()));
+    EXPECT_GT(delays.back(), delays.front());
+}
+
+TEST_F(db_dispatch_test, admission_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _))
+        .WillOnce(Invoke([&](auto, auto handler)
+        {
+            swarm_response_handler = handler;
+            return true;
+        }))
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1)).WillOnce(Invoke([&]
+    {
+        return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+    }));
+
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(4));
+
+    std::vector<database_msg> sent;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::fastest)).Times(Exactly(3)).WillRepeatedly(Invoke([&](auto e, auto)
+    {
+        database_msg request;
+        EXPECT_TRUE(request.ParseFromString(e.database_msg()));
+        sent.push_back(request);
+        return 0;
+    }));
+
+    auto respond = [&](const database_msg& request)
+    {
+        database_response response;
+        *response.mutable_header() = request.header();
+        bzn_envelope env;
+        env.set_database_response(response.SerializeAsString());
+        env.set_sender("node1");
+        env.set_signature("xxx");
+        swarm_response_handler("node1", env);
+    };
+
+    std::vector<std::string> results;
+    auto handler = [&](const database_response& response, const auto&)
+    {
+        results.push_back(response.has_error() ? response.error().message() : "ok");
+    };
+
+    // one request at a time, failing any more
+    bzapi::set_request_limits(1, 0, overload_policy::fail_fast);
+    database_msg request1;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request1, send_policy::fastest, handler);
+    database_msg request2;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request2, send_policy::fastest, handler);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(results, std::vector<std::string>{"Too many requests in flight"});
+
+    // or queueing them until there's room
+    bzapi::set_request_limits(1, 0, overload_policy::queue);
+    database_msg request3;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request3, send_policy::fastest, handler);
+    database_msg request4;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request4, send_policy::fastest, handler);
+    EXPECT_EQ(sent.size(), 1u);
+    EXPECT_EQ(db->get_request_stats().waiting, 2u);
+
+    respond(sent[0]);
+    ASSERT_EQ(sent.size(), 2u);
+    respond(sent[1]);
+    ASSERT_EQ(sent.size(), 3u);
+    respond(sent[2]);
+    EXPECT_EQ(results, std::vector<std::string>({"Too many requests in flight", "ok", "ok", "ok"}));
+
+    auto stats = db->get_request_stats();
+    EXPECT_EQ(stats.in_flight, 0u);
+    EXPECT_EQ(stats.waiting, 0u);
+    EXPECT_EQ(stats.admitted, 3u);
+    EXPECT_EQ(stats.delayed, 2u);
+    EXPECT_EQ(stats.rejected, 1u);
+
+    bzapi::set_request_limits(0, 0, overload_policy::queue);
+}
+
+TEST_F(db_dispatch_test, queued_expiry_and_cancel_test)
+{
+    completion_handler_t timer_callback;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _)).WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(1)).WillOnce(Invoke([&]
+    {
+        auto timer = std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+        EXPECT_CALL(*timer, async_wait(_)).WillRepeatedly(Invoke([&](auto handler)
+        {
+            timer_callback = handler;
+        }));
+        return timer;
+    }));
+
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(3));
+    EXPECT_CALL(*swarm, send_request(_, send_policy::fastest)).Times(Exactly(1)).WillOnce(Return(0));
+
+    std::vector<std::string> results;
+    auto handler = [&](const database_response& response, const auto&)
+    {
+        results.push_back(response.has_error() ? response.error().message() : "ok");
+    };
+
+    // the first request holds the only slot for two seconds
+    bzapi::set_timeout(2);
+    bzapi::set_request_limits(1, 0, overload_policy::block);
+    database_msg request1;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request1, send_policy::fastest, handler);
+
+    // the block policy queues here, and queued requests give up after their own timeout
+    bzapi::set_timeout(1);
+    database_msg request2;
+    db->send_message_to_swarm(this->swarm, "db_uuid", request2, send_policy::fastest, handler);
+    auto cancelled = db->has_uuid(this->swarm, "db_uuid", [&](auto)
+    {
+        results.push_back("cancelled");
+    });
+    EXPECT_EQ(db->get_request_stats().waiting, 2u);
+
+    // a cancelled request is taken out of the queue
+    db->cancel_request(cancelled);
+    EXPECT_EQ(db->get_request_stats().waiting, 1u);
+
+    this->tick(timer_callback, 9);
+    EXPECT_TRUE(results.empty());
+    this->tick(timer_callback, 1);
+    EXPECT_EQ(results, std::vector<std::string>{"Too many requests in flight"});
+    EXPECT_EQ(db->get_request_stats().waiting, 0u);
+
+    // and isn't sent once there's room
+    this->tick(timer_callback, 10);
+    EXPECT_EQ(results, std::vector<std::string>({"Too many requests in flight", "Request timeout"}));
+    EXPECT_EQ(db->get_request_stats().in_flight, 0u);
+
+    bzapi::set_request_limits(0, 0, overload_policy::queue);
+    bzapi::set_timeout(30);
+}
+
+TEST_F(db_dispatch_test, subscription_lost_test)
+{
+    swarm_response_handler_t swarm_response_handler;
+
+    EXPECT_CALL(*swarm, register_response_handler(_, _))
+        .WillOnce(Invoke([&](auto, auto handler)
+        {
+            swarm_response_handler = handler;
+            return true;
+        }))
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).WillRepeatedly(Invoke([&]
+    {
+        return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+    }));
+
+    EXPECT_CALL(*swarm, honest_majority_size()).WillRepeatedly(Return(3));
+    EXPECT_CALL(*swarm, sign_and_date_request(_)).Times(Exactly(1));
+
+    database_msg request;
+    EXPECT_CALL(*swarm, send_request(_, send_policy::normal)).Times(Exactly(1)).WillOnce(Invoke([&](auto e, auto)
+    {
+        EXPECT_TRUE(request.ParseFromString(e.database_msg()));
+        return 0;
+    }));
+
+    std::vector<std::string> results;
+    size_t updates = 0;
+    db->subscribe(this->swarm, "db_uuid", "key", [&](const auto& response, const auto&)
+    {
+        results.push_back(response.has_error() ? response.error().message() : "ok");
+    }
+    , [&](const database_subscription_update&)
+    {
+        updates++;
+    });
+
+    database_response response;
+    *response.mutable_header() = request.header();
+    bzn_envelope env;
+    env.set_database_response(response.SerializeAsString());
+    env.set_sender("node1");
+    env.set_signature("xxx");
+    swarm_response_handler("node1", env);
+    EXPECT_EQ(results, std::vector<std::string>{"ok"});
+
+    // another node going away makes no difference
+    ASSERT_NE(this->disconnect_handler, nullptr);
+    this->disconnect_handler("node2");
+    EXPECT_EQ(results.size(), 1u);
+
+    // but losing the node holding the subscription is reported, and its updates stop
+    this->disconnect_handler("node1");
+    EXPECT_EQ(results, std::vector<std::string>({"ok", "Subscription lost"}));
+
+    response.mutable_subscription_update()->set_key("key");
+    env.set_database_response(response.SerializeAsString());
+    swarm_response_handler("node1", env);
+    EXPECT_EQ(updates, 0u);
+}
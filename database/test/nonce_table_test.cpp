@@ -0,0 +1,90 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <database/nonce_table.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace bzapi;
+
+
+TEST(nonce_table_test, insert_find_erase)
+{
+    nonce_table<std::string> table(4);
+
+    table.insert(1, "one");
+    table.insert(2, "two");
+    EXPECT_EQ(table.size(), 2u);
+
+    ASSERT_NE(table.find(1), nullptr);
+    EXPECT_EQ(*table.find(1), "one");
+    EXPECT_EQ(table.find(3), nullptr);
+
+    // same slot, different nonce
+    EXPECT_EQ(table.find(5), nullptr);
+
+    EXPECT_TRUE(table.erase(1));
+    EXPECT_FALSE(table.erase(1));
+    EXPECT_EQ(table.find(1), nullptr);
+    EXPECT_EQ(table.size(), 1u);
+}
+
+TEST(nonce_table_test, long_lived_entries)
+{
+    nonce_table<std::string> table(4);
+
+    // nonce 1 outlives a series of short requests that lap it
+    auto& kept = table.insert(1, "kept");
+    for (uint64_t nonce = 2; nonce < 1000; nonce++)
+    {
+        table.insert(nonce, std::to_string(nonce));
+        EXPECT_TRUE(table.erase(nonce));
+    }
+
+    ASSERT_EQ(table.find(1), &kept);
+    EXPECT_EQ(kept, "kept");
+    EXPECT_EQ(table.size(), 1u);
+
+    EXPECT_TRUE(table.erase(1));
+    EXPECT_EQ(table.size(), 0u);
+}
+
+TEST(nonce_table_test, growth_keeps_entries)
+{
+    nonce_table<std::string> table(4);
+
+    std::vector<std::string*> refs;
+    for (uint64_t nonce = 1; nonce <= 100; nonce++)
+    {
+        refs.push_back(&table.insert(nonce, std::to_string(nonce)));
+    }
+
+    EXPECT_EQ(table.size(), 100u);
+    for (uint64_t nonce = 1; nonce <= 100; nonce++)
+    {
+        ASSERT_EQ(table.find(nonce), refs[nonce - 1]);
+        EXPECT_EQ(*table.find(nonce), std::to_string(nonce));
+    }
+
+    for (uint64_t nonce = 1; nonce <= 100; nonce += 2)
+    {
+        EXPECT_TRUE(table.erase(nonce));
+    }
+
+    EXPECT_EQ(table.size(), 50u);
+    EXPECT_EQ(table.find(1), nullptr);
+    EXPECT_EQ(*table.find(2), "2");
+}
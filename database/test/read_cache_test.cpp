@@ -0,0 +1,66 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <database/read_cache.hpp>
+#include <gtest/gtest.h>
+
+using namespace bzapi;
+using namespace std::chrono_literals;
+
+
+TEST(read_cache_test, reads_that_fill_nothing_stay_bounded)
+{
+    read_cache cache(4, 60s);
+
+    // reads of absent keys never reach put, so begin_read has to keep to the limit itself
+    read_cache::evicted_list evicted;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        cache.begin_read("missing" + std::to_string(i), evicted);
+        EXPECT_LE(cache.size(), 4u);
+    }
+    EXPECT_TRUE(evicted.empty());
+
+    // and a failed read leaves nothing behind
+    read_cache cache2(4, 60s);
+    auto generation = cache2.begin_read("key", evicted);
+    cache2.abandon_read("key", generation);
+    EXPECT_EQ(cache2.size(), 0u);
+}
+
+TEST(read_cache_test, eviction_returns_subscriptions)
+{
+    read_cache cache(2, 60s);
+    read_cache::evicted_list evicted;
+
+    for (uint64_t i = 0; i < 2; i++)
+    {
+        auto key = "key" + std::to_string(i);
+        auto generation = cache.begin_read(key, evicted);
+        EXPECT_TRUE(cache.put(key, "value", generation).subscribe);
+        EXPECT_TRUE(cache.subscription_active(key, i + 1));
+    }
+
+    // a key with a subscription isn't dropped when a read of it fails
+    auto generation = cache.begin_read("key1", evicted);
+    cache.abandon_read("key1", generation);
+    EXPECT_EQ(cache.size(), 2u);
+
+    // the least recently used key makes way, and its subscription is handed back to be cancelled
+    cache.begin_read("key2", evicted);
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(evicted, (read_cache::evicted_list{{"key0", 1}}));
+}
@@ -0,0 +1,56 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <database/rtt_estimator.hpp>
+#include <gtest/gtest.h>
+
+using namespace bzapi;
+using namespace std::chrono_literals;
+
+
+TEST(rtt_estimator_test, first_sample)
+{
+    rtt_estimator est;
+    EXPECT_TRUE(est.empty());
+
+    est.add_sample(40ms);
+    EXPECT_FALSE(est.empty());
+    EXPECT_EQ(est.smoothed(), 40ms);
+    EXPECT_EQ(est.variation(), 20ms);
+    EXPECT_EQ(est.timeout(1ms), 120ms);
+
+    // granularity is a lower bound on the variation term
+    EXPECT_EQ(est.timeout(100ms), 140ms);
+}
+
+TEST(rtt_estimator_test, converges)
+{
+    rtt_estimator est;
+    est.add_sample(1000ms);
+    for (size_t i = 0; i < 100; i++)
+    {
+        est.add_sample(40ms);
+    }
+
+    EXPECT_EQ(est.smoothed(), 40ms);
+    EXPECT_LT(est.variation(), 1ms);
+
+    // a spike raises the timeout more through the variation than the mean
+    est.add_sample(200ms);
+    EXPECT_EQ(est.smoothed(), 60ms);
+    EXPECT_GE(est.variation(), 40ms);
+    EXPECT_GE(est.timeout(1ms), 220ms);
+}
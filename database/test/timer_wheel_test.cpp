@@ -0,0 +1,78 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <database/timer_wheel.hpp>
+#include <gtest/gtest.h>
+
+using namespace bzapi;
+
+
+TEST(timer_wheel_test, items_expire_in_order)
+{
+    timer_wheel<int> wheel(8);
+    std::vector<int> expired;
+    auto advance = [&](size_t ticks)
+    {
+        for (size_t i = 0; i < ticks; i++)
+        {
+            wheel.advance([&](int item)
+            {
+                expired.push_back(item);
+            });
+        }
+    };
+
+    wheel.schedule(3, 3);
+    wheel.schedule(1, 1);
+    wheel.schedule(0, 0);
+
+    // longer than a revolution
+    wheel.schedule(20, 20);
+    EXPECT_EQ(wheel.size(), 4u);
+
+    advance(1);
+    EXPECT_EQ(expired, std::vector<int>({1, 0}));
+
+    advance(2);
+    EXPECT_EQ(expired, std::vector<int>({1, 0, 3}));
+
+    advance(16);
+    EXPECT_EQ(expired.size(), 3u);
+    EXPECT_FALSE(wheel.empty());
+
+    advance(1);
+    EXPECT_EQ(expired, std::vector<int>({1, 0, 3, 20}));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(timer_wheel_test, reschedule_from_handler)
+{
+    timer_wheel<int> wheel(4);
+    size_t count = 0;
+
+    wheel.schedule(4, 0);
+    for (size_t i = 0; i < 16; i++)
+    {
+        wheel.advance([&](int item)
+        {
+            count++;
+            wheel.schedule(4, item);
+        });
+    }
+
+    EXPECT_EQ(count, 4u);
+    EXPECT_EQ(wheel.size(), 1u);
+}
@@ -0,0 +1,109 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace bzapi
+{
+    // hashed timing wheel: items are scheduled a whole number of ticks ahead and handed back by
+    // advance() once that many ticks have passed. scheduling is O(1) with no allocation once the
+    // buckets have grown to their working size. a delay of up to one tick per slot expires in a single
+    // revolution; longer ones wait out the extra rounds in their bucket, so size the wheel for the usual delays.
+    // items can't be cancelled, the owner should ignore items it no longer cares about when they expire
+    // not thread safe: db_dispatch only touches it on its strand
+    template <typename T>
+    class timer_wheel
+    {
+    public:
+        explicit timer_wheel(size_t slots = 256)
+        : buckets(std::max(slots, size_t{1}))
+        {
+        }
+
+        // schedule an item to expire after the given number of ticks (at least one)
+        void schedule(uint64_t ticks, T item)
+        {
+            ticks = std::max(ticks, uint64_t{1});
+            auto& bucket = this->buckets[(this->current + ticks) % this->buckets.size()];
+            bucket.push_back(entry{(ticks - 1) / this->buckets.size(), std::move(item)});
+            this->count++;
+        }
+
+        // move forward one tick, passing each item that has expired to the handler. the handler may
+        // schedule further items
+        template <typename F>
+        void advance(F&& expired)
+        {
+            this->current = (this->current + 1) % this->buckets.size();
+
+            auto& bucket = this->buckets[this->current];
+            this->due.clear();
+            for (size_t i = 0; i < bucket.size();)
+            {
+                if (bucket[i].rounds == 0)
+                {
+                    this->due.push_back(std::move(bucket[i].item));
+                    bucket[i] = std::move(bucket.back());
+                    bucket.pop_back();
+                }
+                else
+                {
+                    bucket[i].rounds--;
+                    i++;
+                }
+            }
+
+            this->count -= this->due.size();
+
+            // the handler may schedule into this bucket, so expired items are moved out first
+            auto expiring = std::move(this->due);
+            for (auto& item : expiring)
+            {
+                expired(item);
+            }
+
+            // keep the storage for next time
+            expiring.clear();
+            this->due = std::move(expiring);
+        }
+
+        size_t size() const
+        {
+            return this->count;
+        }
+
+        bool empty() const
+        {
+            return this->count == 0;
+        }
+
+    private:
+        struct entry
+        {
+            uint64_t rounds;
+            T item;
+        };
+
+        std::vector<std::vector<entry>> buckets;
+        std::vector<T> due;
+        size_t current = 0;
+        size_t count = 0;
+    };
+}
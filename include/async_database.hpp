@@ -17,15 +17,83 @@
 #pragma once
 
 #include "response.hpp"
+#include <functional>
+#include <future>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 
 namespace bzapi
 {
+    /// outcome of a typed database operation
+    struct db_status
+    {
+        /// error number (as returned by response::get_error), or zero if successful
+        int error = 0;
+
+        /// description of the error, if any
+        std::string message;
+
+        bool ok() const { return this->error == 0; }
+    };
+
+    /// utilization of a database, as reported by size()
+    struct db_size
+    {
+        uint64_t bytes = 0;
+        uint64_t keys = 0;
+        uint64_t remaining_bytes = 0;
+        uint64_t max_size = 0;
+    };
+
+    /// a change made to a subscribed key
+    struct db_update
+    {
+        enum class operation
+        {
+            update,
+            remove
+        };
+
+        std::string key;
+
+        /// new value of the key (empty if it was removed)
+        std::string value;
+
+        operation op = operation::update;
+
+        /// sequence number assigned by the swarm, which can be used to order updates
+        uint64_t seq = 0;
+    };
+
+    /// outcome and value of a typed database operation, as delivered by the future based methods
+    template <typename T>
+    struct db_result
+    {
+        db_status status;
+        T value{};
+    };
+
+    /// completion handlers for the typed methods. Handlers are invoked on a bzapi thread, or on the calling
+    /// thread if the result is available immediately, and must not block.
+    /// The string_view passed to a value handler is only valid for the duration of the call.
+    using status_handler_t = std::function<void(const db_status& status)>;
+    using value_handler_t = std::function<void(const db_status& status, std::string_view value)>;
+    using bool_handler_t = std::function<void(const db_status& status, bool value)>;
+    using keys_handler_t = std::function<void(const db_status& status, const std::vector<std::string>& keys)>;
+    using size_handler_t = std::function<void(const db_status& status, const db_size& size)>;
+    using ttl_handler_t = std::function<void(const db_status& status, uint64_t ttl)>;
+    using update_handler_t = std::function<void(const db_update& update)>;
+
     /// The async_database class provides access to a swarmDB database for CRUD and maintenance
     /// operations. The methods of this class execute asynchronously and return a response object
     /// which can be used to fetch the result of the operation, which is expressed in a
     /// JSON structure detailed below.
+    /// The most common operations are also available in a typed form which delivers results directly,
+    /// either to a completion handler or through a std::future, without going through JSON.
     class async_database
     {
     public:
@@ -66,6 +134,37 @@ namespace bzapi
         /// error - set to error message
         virtual std::shared_ptr<response> remove(const std::string& key) = 0;
 
+        /// create a number of key/values in the database. The requests are pipelined to the swarm
+        /// and a single response is returned once all of them have completed.
+        /// @param key_values - list of keys and the values to set them to
+        /// @param expiry - lifetime of the key/values in seconds (0 = forever)
+        /// @return - response containing JSON structure with the following members:
+        /// result - set to 1 if every key was created, or
+        /// error - set to error message
+        /// results - array with an entry per key, in request order, containing:
+        ///     key - name of the key
+        ///     result - set to 1 on success, or
+        ///     error - set to error message
+        virtual std::shared_ptr<response> batch_create(const std::vector<std::pair<std::string, std::string>>& key_values
+            , uint64_t expiry) = 0;
+
+        /// get the values of a number of keys in the database.
+        /// @param keys - names of the keys to read
+        /// @return - response containing JSON structure as for batch_create, with each entry in
+        /// results also containing:
+        ///     value - set to the value of the key
+        virtual std::shared_ptr<response> batch_read(const std::vector<std::string>& keys) = 0;
+
+        /// update the values of a number of keys in the database.
+        /// @param key_values - list of keys and the values to set them to
+        /// @return - response containing JSON structure as for batch_create
+        virtual std::shared_ptr<response> batch_update(const std::vector<std::pair<std::string, std::string>>& key_values) = 0;
+
+        /// remove a number of keys and their values from the database.
+        /// @param keys - names of the keys to remove
+        /// @return - response containing JSON structure as for batch_create
+        virtual std::shared_ptr<response> batch_remove(const std::vector<std::string>& keys) = 0;
+
         /// get the value of a key in the database without enforcing consensus
         /// @param key - name of the key to read
         /// @return - response containing JSON structure with the following members:
@@ -142,6 +241,117 @@ namespace bzapi
         /// error - set to error message
         virtual std::shared_ptr<response> remove_writer(const std::string& writer) = 0;
 
+        /// keep local copies of values read from the database. Cached keys are subscribed to so that changes
+        /// made elsewhere invalidate them, allowing repeated read() and quick_read() calls to be answered
+        /// without a round trip to the swarm. Writes made through this object invalidate keys immediately.
+        /// @param max_keys - maximum number of keys to cache (0 disables the cache)
+        /// @param max_age - time in milliseconds after which a cached value is read again from the swarm
+        virtual void set_read_cache(size_t max_keys, uint64_t max_age) = 0;
+
+        /// receive changes made to a key as they happen, rather than polling it with read()
+        /// @param key - key to watch
+        /// @param updates - invoked for each change to the key until unsubscribe() is called
+        /// @param handler - invoked once the subscription has been accepted or has failed (not invoked if
+        /// unsubscribe() is called first), and again with an error if an accepted subscription is lost because
+        /// the node holding it disconnected, after which no more updates arrive and the key may be subscribed
+        /// to again. Only one subscription per key may be held at a time.
+        virtual void subscribe(const std::string& key, update_handler_t updates, status_handler_t handler) = 0;
+
+        /// stop receiving changes to a key
+        /// @param key - key passed to subscribe()
+        virtual void unsubscribe(const std::string& key) = 0;
+
+        /// typed form of create()
+        virtual void create(const std::string& key, const std::string& value, uint64_t expiry, status_handler_t handler) = 0;
+
+        /// typed form of read()
+        virtual void read(const std::string& key, value_handler_t handler) = 0;
+
+        /// typed form of update()
+        virtual void update(const std::string& key, const std::string& value, status_handler_t handler) = 0;
+
+        /// typed form of remove()
+        virtual void remove(const std::string& key, status_handler_t handler) = 0;
+
+        /// typed form of quick_read()
+        virtual void quick_read(const std::string& key, value_handler_t handler) = 0;
+
+        /// typed form of has()
+        virtual void has(const std::string& key, bool_handler_t handler) = 0;
+
+        /// typed form of keys()
+        virtual void keys(keys_handler_t handler) = 0;
+
+        /// typed form of size()
+        virtual void size(size_handler_t handler) = 0;
+
+        /// typed form of ttl()
+        virtual void ttl(const std::string& key, ttl_handler_t handler) = 0;
+
+        /// future based forms of the typed methods
+        std::future<db_status> create_future(const std::string& key, const std::string& value, uint64_t expiry)
+        {
+            auto prom = std::make_shared<std::promise<db_status>>();
+            this->create(key, value, expiry, [prom](const auto& status) { prom->set_value(status); });
+            return prom->get_future();
+        }
+
+        std::future<db_result<std::string>> read_future(const std::string& key)
+        {
+            auto prom = std::make_shared<std::promise<db_result<std::string>>>();
+            this->read(key, [prom](const auto& status, auto value) { prom->set_value({status, std::string(value)}); });
+            return prom->get_future();
+        }
+
+        std::future<db_status> update_future(const std::string& key, const std::string& value)
+        {
+            auto prom = std::make_shared<std::promise<db_status>>();
+            this->update(key, value, [prom](const auto& status) { prom->set_value(status); });
+            return prom->get_future();
+        }
+
+        std::future<db_status> remove_future(const std::string& key)
+        {
+            auto prom = std::make_shared<std::promise<db_status>>();
+            this->remove(key, [prom](const auto& status) { prom->set_value(status); });
+            return prom->get_future();
+        }
+
+        std::future<db_result<std::string>> quick_read_future(const std::string& key)
+        {
+            auto prom = std::make_shared<std::promise<db_result<std::string>>>();
+            this->quick_read(key, [prom](const auto& status, auto value) { prom->set_value({status, std::string(value)}); });
+            return prom->get_future();
+        }
+
+        std::future<db_result<bool>> has_future(const std::string& key)
+        {
+            auto prom = std::make_shared<std::promise<db_result<bool>>>();
+            this->has(key, [prom](const auto& status, auto value) { prom->set_value({status, value}); });
+            return prom->get_future();
+        }
+
+        std::future<db_result<std::vector<std::string>>> keys_future()
+        {
+            auto prom = std::make_shared<std::promise<db_result<std::vector<std::string>>>>();
+            this->keys([prom](const auto& status, const auto& keys) { prom->set_value({status, keys}); });
+            return prom->get_future();
+        }
+
+        std::future<db_result<db_size>> size_future()
+        {
+            auto prom = std::make_shared<std::promise<db_result<db_size>>>();
+            this->size([prom](const auto& status, const auto& size) { prom->set_value({status, size}); });
+            return prom->get_future();
+        }
+
+        std::future<db_result<uint64_t>> ttl_future(const std::string& key)
+        {
+            auto prom = std::make_shared<std::promise<db_result<uint64_t>>>();
+            this->ttl(key, [prom](const auto& status, auto ttl) { prom->set_value({status, ttl}); });
+            return prom->get_future();
+        }
+
         virtual ~async_database() = default;
     };
 }
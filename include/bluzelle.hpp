@@ -73,6 +73,10 @@ namespace bzapi
     const std::string TOO_LARGE_ERROR_MSG{"REQUEST TOO LARGE"};
     const std::string TOO_BUSY_ERROR_MSG{"SERVER TOO BUSY"};
     const std::string DUPLICATE_ERROR_MSG{"DUPLICATE REQUEST"};
+    const std::string OVERLOAD_ERROR_MSG{"Too many requests in flight"};
+
+    // defined in bzapi.hpp
+    enum class overload_policy;
 
     enum class db_error
     {
@@ -87,6 +91,15 @@ namespace bzapi
     };
 
     uint64_t get_timeout();
+    uint64_t get_min_retry_time();
+    uint64_t get_max_retry_time();
+    size_t get_max_requests();
+    size_t get_max_swarm_requests();
+    overload_policy get_overload_policy();
+
+    // for the block overload policy, wait until there's room for another request. call only from
+    // threads that may block. returns false if the wait timed out
+    bool wait_for_request_room();
     std::string get_error_str(db_error err);
 }
 
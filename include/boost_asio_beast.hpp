@@ -17,6 +17,7 @@
 #pragma once
 
 #include <include/bluzelle.hpp>
+#include <include/coalescing_stream.hpp>
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/ssl.hpp>
@@ -415,7 +416,7 @@ namespace bzn::beast
 
         virtual void async_accept(bzn::asio::accept_handler handler) = 0;
 
-        virtual void async_read(boost::beast::multi_buffer& buffer, bzn::asio::read_handler handler) = 0;
+        virtual void async_read(boost::beast::flat_buffer& buffer, bzn::asio::read_handler handler) = 0;
 
         virtual void async_write(const boost::asio::mutable_buffers_1& buffer, bzn::asio::write_handler handler) = 0;
 
@@ -445,7 +446,7 @@ namespace bzn::beast
             this->websocket.async_accept(handler);
         }
 
-        void async_read(boost::beast::multi_buffer& buffer, bzn::asio::read_handler handler) override
+        void async_read(boost::beast::flat_buffer& buffer, bzn::asio::read_handler handler) override
         {
             this->websocket.async_read(buffer, handler);
         }
@@ -481,7 +482,8 @@ namespace bzn::beast
         }
 
     private:
-        boost::beast::websocket::stream<boost::asio::ip::tcp::socket> websocket;
+        // writes queued back to back share socket writes
+        boost::beast::websocket::stream<bzn::beast::coalescing_stream<boost::asio::ip::tcp::socket>> websocket;
     };
 
 
@@ -499,7 +501,7 @@ namespace bzn::beast
         {
             boost::beast::get_lowest_layer(this->websocket).expires_after(std::chrono::seconds(30));
 
-            this->websocket.next_layer().async_handshake(
+            this->websocket.next_layer().next_layer().async_handshake(
                 boost::asio::ssl::stream_base::server,
                 [self = shared_from_this(), handler](auto ec)
                 {
@@ -515,7 +517,7 @@ namespace bzn::beast
                 });
         }
 
-        void async_read(boost::beast::multi_buffer& buffer, bzn::asio::read_handler handler) override
+        void async_read(boost::beast::flat_buffer& buffer, bzn::asio::read_handler handler) override
         {
             this->websocket.async_read(buffer, handler);
         }
@@ -539,7 +541,7 @@ namespace bzn::beast
         {
             boost::beast::get_lowest_layer(this->websocket).expires_after(std::chrono::seconds(30));
 
-            this->websocket.next_layer().async_handshake(
+            this->websocket.next_layer().next_layer().async_handshake(
                 boost::asio::ssl::stream_base::client,
                 [self = shared_from_this(), host, target, handler](auto ec)
                 {
@@ -566,7 +568,8 @@ namespace bzn::beast
         }
 
     private:
-        boost::beast::websocket::stream<boost::beast::ssl_stream<boost::beast::tcp_stream>> websocket;
+        // coalesced above ssl, so back to back writes share records as well as socket writes
+        boost::beast::websocket::stream<bzn::beast::coalescing_stream<boost::beast::ssl_stream<boost::beast::tcp_stream>>> websocket;
     };
     //
 
@@ -23,14 +23,23 @@
 ///
 namespace bzapi
 {
+    /// What to do with a request when the limit on requests in flight has been reached
+    enum class overload_policy
+    {
+        queue,      ///< hold the request until there is room, failing it if that takes longer than the timeout
+        fail_fast,  ///< fail the request straight away
+        block       ///< as queue, but the blocking methods first block the caller until there is room
+    };
+
     /// Initialize the bzapi library for use with the public Bluzelle network - call prior to any other method.
     /// @param public_key - client elliptic curve key / user id
     /// @param private_key - client private key used for signing
     /// @param esr_address - Ethereum swarm registry address, e.g. D5B3d7C061F817ab05aF9Fab3b61EEe036e4f4fc
     /// @param url - URL of ethereum network, e.g. https://ropsten.infura.io
+    /// @param thread_count - number of threads servicing network i/o
     /// @return - true if successful, otherwise false
     bool initialize(const std::string& public_key, const std::string& private_key
-        , const std::string& esr_address, const std::string& url);
+        , const std::string& esr_address, const std::string& url, size_t thread_count = 1);
 
     /// Initialize the bzapi library for use with a local swarm - call prior to any other method.
     /// @param public_key - client elliptic curve key / user id
@@ -38,14 +47,43 @@ namespace bzapi
     /// @param endpoint - initial swarm endpoint (deprecated)
     /// @param node_id - id of initial swarm endpoint (deprecated)
     /// @param swarm_id - id of initial swarm (deprecated)
+    /// @param thread_count - number of threads servicing network i/o
     /// @return - true if successful, otherwise false
     bool initialize(const std::string& public_key, const std::string& private_key
-        , const std::string& endpoint, const std::string& node_id, const std::string& swarm_id);
+        , const std::string& endpoint, const std::string& node_id, const std::string& swarm_id
+        , size_t thread_count = 1);
 
     /// Set the number of seconds after which a request wil time out
     /// @param seconds - length of time to wait for a response
     void set_timeout(uint64_t seconds);
 
+    /// Set the bounds of the time waited before a request is resent. Within these, the time is
+    /// adapted to the latency measured for each swarm.
+    /// @param min_ms - shortest time in milliseconds to wait before resending a request
+    /// @param max_ms - longest time in milliseconds to wait before resending a request
+    void set_retry_bounds(uint64_t min_ms, uint64_t max_ms);
+
+    /// Limit the number of requests waiting for a response from the swarm, so load spikes are shed
+    /// rather than building up.
+    /// @param max_requests - most requests in flight across all swarms (0 for no limit)
+    /// @param max_swarm_requests - most requests in flight to any one swarm (0 for no limit)
+    /// @param policy - what to do with a request that would exceed a limit
+    void set_request_limits(size_t max_requests, size_t max_swarm_requests, overload_policy policy);
+
+    /// Get counters for requests in flight, waiting to be admitted and rejected, and the time spent waiting.
+    /// @return - JSON string of the counters
+    std::string get_request_stats();
+
+    /// Set the number of worker threads used to verify response signatures.
+    /// Call prior to initialize. The default of 0 verifies on the network thread.
+    /// @param threads - number of verification threads
+    void set_verifier_threads(size_t threads);
+
+    /// Keep the swarms found in the ESR, and which swarm each database is in, in a file. Later runs start
+    /// from the file at once and check the ESR again in the background. Call prior to initialize.
+    /// @param path - file to keep the topology in (empty to not keep one)
+    void set_topology_cache(const std::string& path);
+
     /// Close down the bzapi library. Should be called prior to exit to allow
     /// cleanup of library state.
     void terminate();
@@ -0,0 +1,311 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket/teardown.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+namespace bzn::beast
+{
+    // write buffering layer to put under a websocket::stream, so the frames of messages written back to back
+    // go out in one socket write instead of one write (and segment) each. every message is still its own frame.
+    //
+    // a write is copied into the pending buffer and completes straight away. a flush to the next layer starts
+    // as soon as there's something to send, and whatever is written while it's in flight goes out together in
+    // the next one, so nothing waits longer than one socket write. once max_pending bytes are waiting, writes
+    // stop completing until the next flush takes them.
+    //
+    // flushes are started from the completion of the previous one, so every operation on the next layer runs
+    // on one strand. the synchronous operations go straight to the next layer and mustn't be mixed with
+    // asynchronous writes
+    template <typename NextLayer>
+    class coalescing_stream
+    {
+    public:
+        using next_layer_type = typename std::remove_reference<NextLayer>::type;
+        using executor_type = typename next_layer_type::executor_type;
+
+        static constexpr size_t DEFAULT_MAX_PENDING{64 * 1024};
+
+        template <typename... Args>
+        explicit coalescing_stream(Args&&... args)
+            : state(std::make_shared<shared_state>(std::forward<Args>(args)...))
+        {
+        }
+
+        executor_type get_executor()
+        {
+            return this->state->next.get_executor();
+        }
+
+        next_layer_type& next_layer()
+        {
+            return this->state->next;
+        }
+
+        const next_layer_type& next_layer() const
+        {
+            return this->state->next;
+        }
+
+        void set_max_pending(size_t bytes)
+        {
+            std::lock_guard<std::mutex> lock(this->state->mutex);
+            this->state->max_pending = bytes;
+        }
+
+        template <typename MutableBufferSequence, typename ReadHandler>
+        auto async_read_some(const MutableBufferSequence& buffers, ReadHandler&& handler)
+        {
+            return boost::asio::async_initiate<ReadHandler, void(boost::system::error_code, std::size_t)>(
+                [state = this->state](auto handler, const MutableBufferSequence& buffers)
+                {
+                    boost::asio::post(state->strand, [state, buffers, handler = std::move(handler)]() mutable
+                    {
+                        state->next.async_read_some(buffers, std::move(handler));
+                    });
+                }, handler, buffers);
+        }
+
+        template <typename ConstBufferSequence, typename WriteHandler>
+        auto async_write_some(const ConstBufferSequence& buffers, WriteHandler&& handler)
+        {
+            return boost::asio::async_initiate<WriteHandler, void(boost::system::error_code, std::size_t)>(
+                [state = this->state](auto handler, const ConstBufferSequence& buffers)
+                {
+                    state->write(buffers, std::move(handler));
+                }, handler, buffers);
+        }
+
+        template <typename MutableBufferSequence>
+        size_t read_some(const MutableBufferSequence& buffers, boost::system::error_code& ec)
+        {
+            return this->state->next.read_some(buffers, ec);
+        }
+
+        template <typename MutableBufferSequence>
+        size_t read_some(const MutableBufferSequence& buffers)
+        {
+            return this->state->next.read_some(buffers);
+        }
+
+        template <typename ConstBufferSequence>
+        size_t write_some(const ConstBufferSequence& buffers, boost::system::error_code& ec)
+        {
+            return this->state->next.write_some(buffers, ec);
+        }
+
+        template <typename ConstBufferSequence>
+        size_t write_some(const ConstBufferSequence& buffers)
+        {
+            return this->state->next.write_some(buffers);
+        }
+
+        friend void teardown(boost::beast::role_type role, coalescing_stream& stream, boost::system::error_code& ec)
+        {
+            using boost::beast::websocket::teardown;
+            teardown(role, stream.state->next, ec);
+        }
+
+        // the close frame is likely still pending, so the next layer is only torn down once it's been flushed
+        template <typename TeardownHandler>
+        friend void async_teardown(boost::beast::role_type role, coalescing_stream& stream, TeardownHandler&& handler)
+        {
+            auto state = stream.state;
+            auto shared_handler = std::make_shared<std::decay_t<TeardownHandler>>(std::forward<TeardownHandler>(handler));
+            state->when_flushed([state, role, shared_handler]()
+            {
+                using boost::beast::websocket::async_teardown;
+                async_teardown(role, state->next, std::move(*shared_handler));
+            });
+        }
+
+    private:
+        // outlives the stream while a flush is in flight
+        struct shared_state : public std::enable_shared_from_this<shared_state>
+        {
+            template <typename... Args>
+            explicit shared_state(Args&&... args)
+                : next(std::forward<Args>(args)...), strand(next.get_executor())
+            {
+            }
+
+            template <typename ConstBufferSequence, typename Handler>
+            void write(const ConstBufferSequence& buffers, Handler handler)
+            {
+                // the handler is only completed here, on its own executor
+                auto complete = [executor = this->next.get_executor()
+                    , handler = std::make_shared<Handler>(std::move(handler))]
+                    (const boost::system::error_code& ec, size_t bytes)
+                {
+                    boost::asio::post(executor, boost::beast::bind_handler(std::move(*handler), ec, bytes));
+                };
+
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (this->error)
+                {
+                    complete(this->error, 0);
+                    return;
+                }
+
+                auto size = boost::asio::buffer_size(buffers);
+                auto offset = this->pending.size();
+                this->pending.resize(offset + size);
+                boost::asio::buffer_copy(boost::asio::buffer(&this->pending[offset], size), buffers);
+
+                if (this->pending.size() > this->max_pending)
+                {
+                    this->waiting_writer = [complete, size](const boost::system::error_code& ec)
+                    {
+                        complete(ec, ec ? 0 : size);
+                    };
+                }
+                else
+                {
+                    complete(boost::system::error_code{}, size);
+                }
+
+                if (!this->flushing)
+                {
+                    this->flushing = true;
+                    boost::asio::post(this->strand, [self = this->shared_from_this()]()
+                    {
+                        self->flush();
+                    });
+                }
+            }
+
+            void flush()
+            {
+                std::function<void(const boost::system::error_code&)> writer;
+                std::function<void()> idle;
+                bool done = false;
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (this->pending.empty())
+                    {
+                        this->flushing = false;
+                        idle = std::move(this->on_idle);
+                        this->on_idle = nullptr;
+                        done = true;
+                    }
+                    else
+                    {
+                        this->sending.swap(this->pending);
+                        this->pending.clear();
+                        writer = std::move(this->waiting_writer);
+                        this->waiting_writer = nullptr;
+                    }
+                }
+
+                if (done)
+                {
+                    if (idle)
+                    {
+                        idle();
+                    }
+
+                    return;
+                }
+
+                if (writer)
+                {
+                    writer(boost::system::error_code{});
+                }
+
+                boost::asio::async_write(this->next, boost::asio::buffer(this->sending)
+                    , boost::asio::bind_executor(this->strand
+                        , [self = this->shared_from_this()](const boost::system::error_code& ec, size_t /*bytes*/)
+                        {
+                            self->flushed(ec);
+                        }));
+            }
+
+            void flushed(const boost::system::error_code& ec)
+            {
+                if (ec)
+                {
+                    std::function<void(const boost::system::error_code&)> writer;
+                    std::function<void()> idle;
+                    {
+                        std::lock_guard<std::mutex> lock(this->mutex);
+                        this->error = ec;
+                        this->pending.clear();
+                        this->flushing = false;
+                        writer = std::move(this->waiting_writer);
+                        this->waiting_writer = nullptr;
+                        idle = std::move(this->on_idle);
+                        this->on_idle = nullptr;
+                    }
+
+                    if (writer)
+                    {
+                        writer(ec);
+                    }
+
+                    if (idle)
+                    {
+                        idle();
+                    }
+
+                    return;
+                }
+
+                this->flush();
+            }
+
+            void when_flushed(std::function<void()> func)
+            {
+                boost::asio::post(this->strand, [self = this->shared_from_this(), func = std::move(func)]()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(self->mutex);
+                        if (self->flushing)
+                        {
+                            self->on_idle = func;
+                            return;
+                        }
+                    }
+
+                    func();
+                });
+            }
+
+            next_layer_type next;
+            boost::asio::strand<executor_type> strand;
+
+            std::mutex mutex;
+            std::string pending;
+            std::string sending;
+            size_t max_pending = DEFAULT_MAX_PENDING;
+            bool flushing = false;
+            boost::system::error_code error;
+
+            // a write held back because too much is pending, and a teardown waiting for the flushes to finish
+            std::function<void(const boost::system::error_code&)> waiting_writer;
+            std::function<void()> on_idle;
+        };
+
+        std::shared_ptr<shared_state> state;
+    };
+}
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <vector>
 
 
 namespace bzapi
@@ -63,6 +65,35 @@ namespace bzapi
         /// error - set to error message
         virtual std::string remove(const std::string& key) = 0;
 
+        /// create a number of key/values in the database.
+        /// @param key_values - list of keys and the values to set them to
+        /// @param expiry - lifetime of the key/values in seconds (0 = forever)
+        /// @return - JSON structure with the following members:
+        /// result - set to 1 if every key was created, or
+        /// error - set to error message
+        /// results - array with an entry per key, in request order, containing:
+        ///     key - name of the key
+        ///     result - set to 1 on success, or
+        ///     error - set to error message
+        virtual std::string batch_create(const std::vector<std::pair<std::string, std::string>>& key_values
+            , uint64_t expiry) = 0;
+
+        /// get the values of a number of keys in the database.
+        /// @param keys - names of the keys to read
+        /// @return - JSON structure as for batch_create, with each entry in results also containing:
+        ///     value - set to the value of the key
+        virtual std::string batch_read(const std::vector<std::string>& keys) = 0;
+
+        /// update the values of a number of keys in the database.
+        /// @param key_values - list of keys and the values to set them to
+        /// @return - JSON structure as for batch_create
+        virtual std::string batch_update(const std::vector<std::pair<std::string, std::string>>& key_values) = 0;
+
+        /// remove a number of keys and their values from the database.
+        /// @param keys - names of the keys to remove
+        /// @return - JSON structure as for batch_create
+        virtual std::string batch_remove(const std::vector<std::string>& keys) = 0;
+
         /// get the value of a key in the database without enforcing consensus
         /// @param key - name of the key to read
         /// @return - JSON structure with the following members:
@@ -139,6 +170,11 @@ namespace bzapi
         /// error - set to error message
         virtual std::string remove_writer(const std::string& writer) = 0;
 
+        /// keep local copies of values read from the database (see async_database::set_read_cache)
+        /// @param max_keys - maximum number of keys to cache (0 disables the cache)
+        /// @param max_age - time in milliseconds after which a cached value is read again from the swarm
+        virtual void set_read_cache(size_t max_keys, uint64_t max_age) = 0;
+
         virtual ~database() = default;
     };
 }
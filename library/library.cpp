@@ -17,6 +17,7 @@
 #include <include/bluzelle.hpp>
 #include <include/boost_asio_beast.hpp>
 #include <crypto/crypto.hpp>
+#include <crypto/verifier.hpp>
 #include <database/database_impl.hpp>
 #include <database/db_dispatch.hpp>
 #include <include/bzapi.hpp>
@@ -33,14 +34,24 @@
 namespace
 {
     std::shared_ptr<bzn::asio::io_context_base> io_context;
-    std::shared_ptr<std::thread> io_thread;
+    std::vector<std::thread> io_threads;
     std::shared_ptr<bzapi::swarm_factory> the_swarm_factory;
     std::shared_ptr<bzapi::crypto_base> the_crypto;
+    std::shared_ptr<bzapi::verifier> the_verifier;
     std::shared_ptr<bzn::beast::websocket_base> ws_factory;
     std::string error_str = "Not Initialized";
     int error_val = -1;
     const uint64_t DEFAULT_TIMEOUT = 30;
     uint64_t api_timeout = DEFAULT_TIMEOUT;
+    const uint64_t DEFAULT_MIN_RETRY_TIME = 200;
+    const uint64_t DEFAULT_MAX_RETRY_TIME = 5000;
+    uint64_t min_retry_time = DEFAULT_MIN_RETRY_TIME;
+    uint64_t max_retry_time = DEFAULT_MAX_RETRY_TIME;
+    size_t max_requests = 0;
+    size_t max_swarm_requests = 0;
+    bzapi::overload_policy request_overload_policy = bzapi::overload_policy::queue;
+    size_t verifier_threads = 0;
+    std::string topology_cache;
 }
 
 namespace bzapi
@@ -51,13 +62,14 @@ namespace bzapi
     std::shared_ptr<bzapi::crypto_base> the_crypto;
     std::shared_ptr<bzn::beast::websocket_base> ws_factory;
     std::shared_ptr<bzapi::db_dispatch_base> db_dispatcher;
-    std::shared_ptr<bzapi::esr_base> the_esr{new bzapi::esr};
+    std::shared_ptr<bzapi::esr_base> the_esr; // replaces the ESR lookups when set
+    std::shared_ptr<bzapi::udp_socket_pool> signal_sockets{std::make_shared<bzapi::udp_socket_pool>()};
     bool initialized = false;
 
     std::shared_ptr<mutable_response>
     make_response()
     {
-        return std::make_shared<udp_response>();
+        return std::make_shared<udp_response>(signal_sockets);
     }
 
     std::shared_ptr<bzapi::db_dispatch_base>
@@ -99,22 +111,37 @@ namespace bzapi
     }
 
     static void
-    common_init(const std::string& public_key, const std::string& private_key)
+    join_io_threads()
+    {
+        for (auto& t : io_threads)
+        {
+            t.join();
+        }
+        io_threads.clear();
+    }
+
+    static void
+    common_init(const std::string& public_key, const std::string& private_key, size_t thread_count)
     {
         init_logging();
         io_context = std::make_shared<bzn::asio::io_context>();
-        io_thread = std::make_shared<std::thread>([]()
+        for (size_t i = 0; i < std::max<size_t>(thread_count, 1); i++)
         {
-            auto& io = io_context->get_io_context();
-            boost::asio::executor_work_guard<decltype(io.get_executor())> work{io.get_executor()};
-            auto res = io_context->run();
-            LOG(debug) << "Events run: " << res << std::endl;
-        });
+            io_threads.emplace_back([]()
+            {
+                auto& io = io_context->get_io_context();
+                boost::asio::executor_work_guard<decltype(io.get_executor())> work{io.get_executor()};
+                auto res = io_context->run();
+                LOG(debug) << "Events run: " << res << std::endl;
+            });
+        }
 
         db_dispatcher = std::make_shared<db_dispatch>(io_context);
         the_crypto = std::make_shared<crypto>(private_key);
+        the_verifier = verifier_threads ? std::make_shared<verifier>(the_crypto, verifier_threads) : nullptr;
         ws_factory = std::make_shared<bzn::beast::websocket>();
-        the_swarm_factory = std::make_shared<swarm_factory>(io_context, ws_factory, the_crypto, the_esr, public_key);
+        the_swarm_factory = std::make_shared<swarm_factory>(io_context, ws_factory, the_crypto
+            , the_esr ? the_esr : std::make_shared<bzapi::esr>(io_context), public_key, the_verifier, topology_cache);
 
         error_val = 0;
         error_str = "";
@@ -122,13 +149,14 @@ namespace bzapi
 
     bool
     initialize(const std::string& public_key, const std::string& private_key
-        , const std::string& endpoint, const std::string& node_id, const std::string& swarm_id)
+        , const std::string& endpoint, const std::string& node_id, const std::string& swarm_id
+        , size_t thread_count)
     {
         if (!initialized)
         {
             try
             {
-                common_init(public_key, private_key);
+                common_init(public_key, private_key, thread_count);
                 auto ep = parse_endpoint(endpoint);
                 std::vector<std::pair<node_id_t, bzn::peer_address_t>> addrs;
                 addrs.push_back(std::make_pair(node_id, bzn::peer_address_t{ep.first, ep.second, 0, "", ""}));
@@ -138,10 +166,7 @@ namespace bzapi
                 if (io_context)
                 {
                     io_context->stop();
-                    if (io_thread)
-                    {
-                        io_thread->join();
-                    }
+                    join_io_threads();
                 }
                 return false;
             );
@@ -154,13 +179,13 @@ namespace bzapi
 
     bool
     initialize(const std::string& public_key, const std::string& private_key
-        , const std::string& esr_address, const std::string& url)
+        , const std::string& esr_address, const std::string& url, size_t thread_count)
     {
         if (!initialized)
         {
             try
             {
-                common_init(public_key, private_key);
+                common_init(public_key, private_key, thread_count);
                 the_swarm_factory->initialize(esr_address, url);
             }
             CATCHALL(return false);
@@ -179,7 +204,13 @@ namespace bzapi
             if (initialized)
             {
                 io_context->stop();
-                io_thread->join();
+                join_io_threads();
+
+                if (the_verifier)
+                {
+                    the_verifier->stop();
+                    the_verifier = nullptr;
+                }
 
                 initialized = false;
                 error_str = "Not Initialized";
@@ -343,6 +374,13 @@ namespace bzapi
         {
             if (initialized)
             {
+                if (!wait_for_request_room())
+                {
+                    error_val = static_cast<int>(db_error::database_error);
+                    error_str = OVERLOAD_ERROR_MSG;
+                    return false;
+                }
+
                 auto resp = async_has_db(uuid);
                 auto result = resp->get_result();
 
@@ -371,6 +409,13 @@ namespace bzapi
         {
             if (initialized)
             {
+                if (!wait_for_request_room())
+                {
+                    error_val = static_cast<int>(db_error::database_error);
+                    error_str = OVERLOAD_ERROR_MSG;
+                    return nullptr;
+                }
+
                 auto resp = async_create_db(uuid, max_size, random_evict);
                 auto result = resp->get_result();
 
@@ -400,6 +445,13 @@ namespace bzapi
         {
             if (initialized)
             {
+                if (!wait_for_request_room())
+                {
+                    error_val = static_cast<int>(db_error::database_error);
+                    error_str = OVERLOAD_ERROR_MSG;
+                    return nullptr;
+                }
+
                 auto resp = async_open_db(uuid);
                 auto result = resp->get_result();
 
@@ -466,9 +518,94 @@ namespace bzapi
         api_timeout = seconds;
     }
 
+    void
+    set_retry_bounds(uint64_t min_ms, uint64_t max_ms)
+    {
+        min_retry_time = min_ms;
+        max_retry_time = std::max(min_ms, max_ms);
+    }
+
+    void
+    set_request_limits(size_t max, size_t max_swarm, overload_policy policy)
+    {
+        max_requests = max;
+        max_swarm_requests = max_swarm;
+        request_overload_policy = policy;
+    }
+
+    std::string
+    get_request_stats()
+    {
+        Json::Value result;
+        if (auto dispatcher = get_db_dispatcher())
+        {
+            auto stats = dispatcher->get_request_stats();
+            result["in_flight"] = static_cast<Json::Value::UInt64>(stats.in_flight);
+            result["waiting"] = static_cast<Json::Value::UInt64>(stats.waiting);
+            result["max_waiting"] = static_cast<Json::Value::UInt64>(stats.max_waiting);
+            result["admitted"] = static_cast<Json::Value::UInt64>(stats.admitted);
+            result["delayed"] = static_cast<Json::Value::UInt64>(stats.delayed);
+            result["rejected"] = static_cast<Json::Value::UInt64>(stats.rejected);
+            result["average_wait_us"] = static_cast<Json::Value::UInt64>(
+                stats.delayed ? stats.total_wait.count() / stats.delayed : 0);
+            result["max_wait_us"] = static_cast<Json::Value::UInt64>(stats.max_wait.count());
+        }
+
+        return result.toStyledString();
+    }
+
+    void
+    set_verifier_threads(size_t threads)
+    {
+        verifier_threads = threads;
+    }
+
+    void
+    set_topology_cache(const std::string& path)
+    {
+        topology_cache = path;
+    }
+
     uint64_t
     get_timeout()
     {
         return api_timeout;
     }
+
+    uint64_t
+    get_min_retry_time()
+    {
+        return min_retry_time;
+    }
+
+    uint64_t
+    get_max_retry_time()
+    {
+        return max_retry_time;
+    }
+
+    size_t
+    get_max_requests()
+    {
+        return max_requests;
+    }
+
+    size_t
+    get_max_swarm_requests()
+    {
+        return max_swarm_requests;
+    }
+
+    overload_policy
+    get_overload_policy()
+    {
+        return request_overload_policy;
+    }
+
+    bool
+    wait_for_request_room()
+    {
+        auto dispatcher = get_db_dispatcher();
+        return request_overload_policy != overload_policy::block || !dispatcher || dispatcher->wait_for_room();
+    }
 }
@@ -28,6 +28,7 @@
 #include <gtest/gtest.h>
 #include <json/reader.h>
 #include <json/value.h>
+#include <future>
 #include <random>
 
 using namespace testing;
@@ -120,7 +121,7 @@ struct mock_websocket
         EXPECT_CALL(*websocket, binary(_)).Times(AtLeast(1));
 
         EXPECT_CALL(*websocket, async_read(_, _)).Times(AtLeast(1))
-            .WillRepeatedly(Invoke([&](boost::beast::multi_buffer& buffer, auto cb)
+            .WillRepeatedly(Invoke([&](boost::beast::flat_buffer& buffer, auto cb)
             {
                 read_handler = cb;
                 read_buffer = &buffer;
@@ -165,9 +166,9 @@ struct mock_websocket
 
 
     std::function<void(const boost::asio::mutable_buffers_1& buffer)> write_func;
-    std::function<void(boost::beast::multi_buffer& buffer)> read_func;
+    std::function<void(boost::beast::flat_buffer& buffer)> read_func;
     bzn::asio::read_handler read_handler;
-    boost::beast::multi_buffer *read_buffer = nullptr;
+    boost::beast::flat_buffer *read_buffer = nullptr;
     uint16_t id{};
     std::shared_ptr<bzn::asio::steady_timer_base> response_timer;
     completion_handler_t timer_callback;
@@ -274,8 +275,8 @@ public:
 
     void expect_has_db(bool value = true)
     {
-        // status and backoff timer for each node, plus client timeout, plus request timeout
-        EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly((swarm_size * 2) + 2))
+        // status and backoff timer for each node, plus the dispatcher's deadline timer
+        EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly((swarm_size * 2) + 1))
         .WillRepeatedly(Invoke([]()
         {
             return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
@@ -299,9 +300,9 @@ public:
         })).RetiresOnSaturation();
 
         EXPECT_CALL(*mock_ws_factory, make_websocket_stream(_)).Times(Exactly(1)).WillOnce(
-            Invoke([uuid = this->uuid, value, num_nodes = swarm_size, &ws = this->node_websocks[0]](auto&)
+            Invoke([this, uuid = this->uuid, value, num_nodes = swarm_size, &ws = this->node_websocks[0]](auto&)
         {
-            ws.write_func = [uuid](const boost::asio::mutable_buffers_1& buffer)
+            ws.write_func = [this, uuid](const boost::asio::mutable_buffers_1& buffer)
             {
                 bzn_envelope env;
                 EXPECT_TRUE(env.ParseFromString(std::string(static_cast<const char *>(buffer.data()), buffer.size())));
@@ -311,6 +312,12 @@ public:
 
                 EXPECT_TRUE(db_msg.has_has_db());
                 EXPECT_TRUE(db_msg.header().db_uuid() == uuid);
+
+                if (auto next = std::move(this->after_has_db))
+                {
+                    this->after_has_db = nullptr;
+                    next();
+                }
             };
 
             ws.read_func = [uuid, value, num_nodes, &ws](const auto& /*buffer*/)
@@ -344,17 +351,15 @@ public:
 
     void expect_create_db(bool succeed = true)
     {
-        EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(2)).WillOnce(Invoke([]()
-        {
-            return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
-        })).WillOnce(Invoke([this, succeed]()
+        // the create_db request follows the has_db request, so be ready for it once that has gone out
+        this->after_has_db = [this, succeed]()
         {
             static int nonce  = 0;
             static int node_id = -1;
 
             for (size_t i = 0; i < 4; i++)
             {
-                this->node_websocks[i].write_func = [this, i](const boost::asio::mutable_buffers_1& buffer)
+                this->node_websocks[i].write_func = [this, i, succeed](const boost::asio::mutable_buffers_1& buffer)
                 {
                     try
                     {
@@ -371,44 +376,41 @@ public:
                         EXPECT_TRUE(msg.has_create_db());
                     }
                     CATCHALL();
-                };
 
-                this->node_websocks[i].read_func = [this, succeed](const auto& /*buffer*/)
-                {
-                    try
+                    this->node_websocks[i].read_func = [this, succeed](const auto& /*buffer*/)
                     {
-                        for (size_t j = 0; j < 4; j++)
+                        try
                         {
-                            database_header header;
-                            header.set_nonce(nonce);
-                            database_response dr;
-                            dr.set_allocated_header(new database_header(header));
-
-                            bzn_envelope env2;
-                            if (!succeed)
+                            for (size_t j = 0; j < 4; j++)
                             {
-                                dr.mutable_error()->set_message("ACCESS_DENIED");
+                                database_header header;
+                                header.set_nonce(nonce);
+                                database_response dr;
+                                dr.set_allocated_header(new database_header(header));
+
+                                bzn_envelope env2;
+                                if (!succeed)
+                                {
+                                    dr.mutable_error()->set_message("ACCESS_DENIED");
+                                }
+
+                                env2.set_database_response(dr.SerializeAsString());
+                                env2.set_sender("node_" + std::to_string(j));
+                                env2.set_signature("xxx");
+                                auto message = env2.SerializeAsString();
+                                this->node_websocks[node_id].simulate_read(message);
                             }
-
-                            env2.set_database_response(dr.SerializeAsString());
-                            env2.set_sender("node_" + std::to_string(j));
-                            env2.set_signature("xxx");
-                            auto message = env2.SerializeAsString();
-                            this->node_websocks[node_id].simulate_read(message);
                         }
-                    }
-                    CATCHALL();
+                        CATCHALL();
+                    };
                 };
             }
-
-            return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
-        }))
-        .RetiresOnSaturation();;
+        };
     }
 
     void expect_swarm_initialize()
     {
-        uint16_t node_count = 0;
+        this->node_count = 0;
 
         EXPECT_CALL(*mock_io_context, make_unique_tcp_socket()).Times(Exactly(swarm_size - 1))
             .WillRepeatedly(Invoke([]()
@@ -429,9 +431,9 @@ public:
         }));
 
         EXPECT_CALL(*mock_ws_factory, make_websocket_stream(_))
-            .WillRepeatedly(Invoke([&node_count, uuid = this->uuid, this](auto &/*sock*/)
+            .WillRepeatedly(Invoke([uuid = this->uuid, this](auto &/*sock*/)
         {
-            auto node_id = node_count++;
+            auto node_id = this->node_count++;
             mock_websocket &ws = this->node_websocks[node_id];
 
             ws.write_func = [uuid](const boost::asio::mutable_buffers_1 &buffer)
@@ -510,6 +512,11 @@ protected:
     bzapi::uuid_t uuid;
     bzapi::uuid_t primary_node;
     std::vector<mock_websocket> node_websocks;
+
+    // run once the has_db request has been sent
+    std::function<void()> after_has_db;
+
+    uint16_t node_count = 0;
     std::set<my_mock_tcp_socket*> sockets;
     std::shared_ptr<bzn::asio::mock_io_context_base> mock_io_context;
     std::shared_ptr<bzn::beast::mock_websocket_base> mock_ws_factory;
@@ -573,27 +580,34 @@ TEST_F(integration_test, test_initialize_esr)
 {
     auto esr = std::make_shared<mock_esr>();
     bzapi::the_esr = esr;
-    EXPECT_CALL(*esr, get_swarm_ids(_, _)).WillOnce(Invoke([](auto, auto)
+    EXPECT_CALL(*esr, get_swarm_ids(_, _, _)).WillOnce(Invoke([](auto, auto, auto handler)
     {
-        return std::vector<std::string>{"swarm_1", "swarm_2"};
+        handler(std::vector<std::string>{"swarm_1", "swarm_2"});
     }));
-    EXPECT_CALL(*esr, get_peer_ids(_, _, _)).Times(Exactly(2))
-        .WillRepeatedly(Invoke([](auto, auto, auto)
+    EXPECT_CALL(*esr, get_peer_ids(_, _, _, _)).Times(Exactly(2))
+        .WillRepeatedly(Invoke([](auto, auto, auto, auto handler)
     {
-        return std::vector<std::string>{"node_1", "node_2"};
+        handler(std::vector<std::string>{"node_1", "node_2"});
     }));
-    EXPECT_CALL(*esr, get_peer_info(_, _, _, _)).Times(Exactly(4))
-        .WillRepeatedly(Invoke([](auto, auto, auto, auto)
+
+    // discovery runs on the io threads, so wait for it before shutting down
+    std::promise<void> discovered;
+    uint16_t id = 1;
+    EXPECT_CALL(*esr, get_peer_info(_, _, _, _, _)).Times(Exactly(4))
+        .WillRepeatedly(Invoke([&discovered, &id](auto, auto, auto, auto, auto handler)
         {
-            static uint16_t id = 1;
-            return bzn::peer_address_t{"127.0.0.1", id, 0, "", std::string{"node_"} + std::to_string(id)};
-            id++;
+            handler(bzn::peer_address_t{"127.0.0.1", id, 0, "", std::string{"node_"} + std::to_string(id)});
+            if (++id == 5)
+            {
+                discovered.set_value();
+            }
         }));
 
     bool result = bzapi::initialize(pub_key, priv_key, "address", "url");
     EXPECT_TRUE(result);
     EXPECT_EQ(bzapi::get_error(), 0);
     EXPECT_EQ(bzapi::get_error_str(), std::string{""});
+    EXPECT_EQ(discovered.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
 
     bzapi::terminate();
     EXPECT_EQ(bzapi::get_error(), -1);
@@ -735,12 +749,6 @@ TEST_F(integration_test, test_create)
         };
     }
 
-    // once for client timeout, once for request timeout
-    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(2)).WillRepeatedly(Invoke([]()
-    {
-        return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
-    })).RetiresOnSaturation();;
-
     auto create_response = db->create("test_key", "test_value", 0);
     create_response->set_signal_id(100);
 
@@ -813,12 +821,6 @@ TEST_F(integration_test, test_read)
         };
     }
 
-    // once for client timeout, once for request timeout
-    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).Times(Exactly(2)).WillRepeatedly(Invoke([]()
-    {
-        return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
-    })).RetiresOnSaturation();;
-
     auto create_response = db->read("test_key");
     create_response->set_signal_id(100);
 
@@ -887,7 +889,7 @@ TEST_F(integration_test, response_test)
     uint16_t my_id = 0;
     int sock = create_socket(my_id);
 
-    udp_response resp;
+    udp_response resp(std::make_shared<udp_socket_pool>());
     int their_id = resp.set_signal_id(my_id);
     (void) their_id;
     resp.set_ready();
@@ -897,9 +899,42 @@ TEST_F(integration_test, response_test)
     std::cout << "received: " << res << " bytes" << std::endl;
 }
 
+TEST_F(integration_test, response_signal_test)
+{
+    uint16_t my_id = 0;
+    int sock = create_socket(my_id);
+    auto pool = std::make_shared<udp_socket_pool>();
+
+    // a response that is already complete signals as soon as it is asked to
+    int first_id;
+    {
+        udp_response resp(pool);
+        resp.set_error(3);
+        first_id = resp.set_signal_id(my_id);
+        EXPECT_NE(first_id, 0);
+
+        int err = 0;
+        sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        EXPECT_EQ(recvfrom(sock, &err, sizeof(err), 0, (sockaddr*)&from, &from_len), static_cast<ssize_t>(sizeof(err)));
+        EXPECT_EQ(err, 3);
+        EXPECT_EQ(ntohs(from.sin_port), first_id);
+    }
+
+    // the socket goes back to the pool and is reused by the next response
+    udp_response resp(pool);
+    EXPECT_EQ(resp.set_signal_id(my_id), first_id);
+    resp.set_ready();
+
+    int err = -1;
+    EXPECT_EQ(recvfrom(sock, &err, sizeof(err), 0, NULL, 0), static_cast<ssize_t>(sizeof(err)));
+    EXPECT_EQ(err, 0);
+    close(sock);
+}
+
 TEST_F(integration_test, blocking_response_test)
 {
-    udp_response resp;
+    udp_response resp(std::make_shared<udp_socket_pool>());
 
     std::thread thr([&resp]()
     {
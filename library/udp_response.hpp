@@ -19,90 +19,158 @@
 #include <library/mutable_response.hpp>
 #include <sys/socket.h>
 #include <netinet/in.h>
-#include <sys/socket.h>
+#include <unistd.h>
+#include <condition_variable>
 #include <stdexcept>
 #include <string.h>
 #include <functional>
+#include <mutex>
+#include <vector>
 
 namespace
 {
     std::string ERROR_RESULT{"{ error: \"An exception occurred getting result\""};
+
+    // idle notification sockets kept open for reuse
+    const size_t MAX_POOLED_SOCKETS{256};
 }
 
 namespace bzapi
 {
-    class udp_response : public mutable_response
+    // bound loopback udp sockets handed out to responses that are asked to signal completion.
+    // sockets are returned on release so each notification doesn't pay for socket/bind/getsockname
+    class udp_socket_pool
     {
     public:
-        udp_response()
+        struct udp_socket
+        {
+            int sock = -1;
+            int port = 0;
+        };
+
+        ~udp_socket_pool()
+        {
+            for (const auto& s : this->sockets)
+            {
+                close(s.sock);
+            }
+        }
+
+        udp_socket acquire()
         {
-            sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-            if (!sock)
+            {
+                std::scoped_lock<std::mutex> lock(this->mutex);
+                if (!this->sockets.empty())
+                {
+                    auto s = this->sockets.back();
+                    this->sockets.pop_back();
+                    return s;
+                }
+            }
+
+            return open_socket();
+        }
+
+        void release(const udp_socket& s)
+        {
+            {
+                std::scoped_lock<std::mutex> lock(this->mutex);
+                if (this->sockets.size() < MAX_POOLED_SOCKETS)
+                {
+                    this->sockets.push_back(s);
+                    return;
+                }
+            }
+
+            close(s.sock);
+        }
+
+        static sockaddr_in make_addr(uint16_t port)
+        {
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(sockaddr_in));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return addr;
+        }
+
+    private:
+        std::vector<udp_socket> sockets;
+        std::mutex mutex;
+
+        static udp_socket open_socket()
+        {
+            udp_socket s;
+            s.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (s.sock < 0)
             {
                 throw std::runtime_error("unable to create udp socket");
             }
 
-            sockaddr_in local = this->make_addr(0);
-            if (bind(sock, (sockaddr*)&local, sizeof(local)) == -1)
+            sockaddr_in local = make_addr(0);
+            if (bind(s.sock, (sockaddr*)&local, sizeof(local)) == -1)
             {
+                close(s.sock);
                 throw std::runtime_error("unable to bind udp socket");
             }
 
             struct sockaddr_in my_addr;
             socklen_t addrlen = sizeof(my_addr);
-            if (getsockname(sock, (struct sockaddr *)&my_addr, &addrlen) == 0
+            if (getsockname(s.sock, (struct sockaddr *)&my_addr, &addrlen) == 0
                 && my_addr.sin_family == AF_INET && addrlen == sizeof(my_addr))
             {
-                this->my_id = ntohs(my_addr.sin_port);
+                s.port = ntohs(my_addr.sin_port);
             }
             else
             {
+                close(s.sock);
                 throw std::runtime_error("error determining local port");
             }
+
+            return s;
         }
+    };
 
-        int set_signal_id(int signal_id) override
+    // completion is tracked with a condition variable. A socket is only taken from the pool
+    // if the caller asks to be signalled, so responses consumed through get_result() need none
+    class udp_response : public mutable_response
+    {
+    public:
+        udp_response(std::shared_ptr<udp_socket_pool> pool)
+        : pool(std::move(pool))
         {
-            std::scoped_lock<std::mutex> lock(this->mutex);
+        }
 
-            this->their_id = signal_id;
-            if (this->deferred_signal)
+        ~udp_response()
+        {
+            if (this->sock.sock >= 0)
             {
-                this->send_signal();
-                this->deferred_signal = false;
+                this->pool->release(this->sock);
             }
-
-            return this->my_id;
         }
 
-        void signal(int error)
+        int set_signal_id(int signal_id) override
         {
             std::scoped_lock<std::mutex> lock(this->mutex);
 
-            this->error_val = error;
-            if (this->their_id)
-            {
-                this->send_signal();
-            }
-            else
+            if (this->sock.sock < 0)
             {
-                this->deferred_signal = true;
+                this->sock = this->pool->acquire();
             }
 
-        }
-
-        void send_signal()
-        {
-            assert(this->their_id);
-            struct sockaddr_in their_addr = this->make_addr(this->their_id);
-            if (!sendto(this->sock, &this->error_val, sizeof(this->error_val), 0, (sockaddr*)&their_addr, sizeof(their_addr)))
+            this->their_id = signal_id;
+            if (this->ready)
             {
-                LOG(error) << "Error: " << errno << " sending data to socket";
+                this->send_signal();
             }
+
+            return this->sock.port;
         }
 
         void set_result(const std::string& result) override
         {
+            std::scoped_lock<std::mutex> lock(this->mutex);
             this->result_str = result;
         }
 
@@ -113,12 +181,28 @@ namespace bzapi
 
         void set_error(int error) override
         {
-            this->prom.set_value(error);
-            this->signal(error);
+            {
+                std::scoped_lock<std::mutex> lock(this->mutex);
+                if (this->ready)
+                {
+                    LOG(warning) << "response completed more than once";
+                    return;
+                }
+
+                this->error_val = error;
+                this->ready = true;
+                if (this->their_id)
+                {
+                    this->send_signal();
+                }
+            }
+
+            this->cond.notify_all();
         }
 
         int get_error() override
         {
+            std::scoped_lock<std::mutex> lock(this->mutex);
             return this->error_val;
         }
 
@@ -126,7 +210,8 @@ namespace bzapi
         {
             try
             {
-                this->prom.get_future().get();
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cond.wait(lock, [this]{ return this->ready; });
                 return this->result_str;
             }
             CATCHALL();
@@ -144,24 +229,25 @@ namespace bzapi
         }
 
     private:
-        int my_id = 0;
+        const std::shared_ptr<udp_socket_pool> pool;
+        udp_socket_pool::udp_socket sock;
         int their_id = 0;
         std::string result_str;
         std::shared_ptr<async_database> db;
-        int sock;
         int error_val = 0;
-        bool deferred_signal = false;
-        std::promise<int> prom;
+        bool ready = false;
         std::mutex mutex;
+        std::condition_variable cond;
 
-        static sockaddr_in make_addr(uint16_t port)
+        void send_signal()
         {
-            struct sockaddr_in addr;
-            memset(&addr, 0, sizeof(sockaddr_in));
-            addr.sin_family = AF_INET;
-            addr.sin_port = htons(port);
-            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-            return addr;
+            assert(this->their_id);
+            struct sockaddr_in their_addr = udp_socket_pool::make_addr(this->their_id);
+            if (sendto(this->sock.sock, &this->error_val, sizeof(this->error_val), 0, (sockaddr*)&their_addr
+                , sizeof(their_addr)) < 0)
+            {
+                LOG(error) << "Error: " << errno << " sending data to socket";
+            }
         }
     };
 }
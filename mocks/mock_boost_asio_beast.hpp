@@ -153,7 +153,7 @@ namespace bzn::beast {
         MOCK_METHOD1(async_accept,
             void(bzn::asio::accept_handler handler));
         MOCK_METHOD2(async_read,
-            void(boost::beast::multi_buffer& buffer, bzn::asio::read_handler handler));
+            void(boost::beast::flat_buffer& buffer, bzn::asio::read_handler handler));
         MOCK_METHOD2(async_write,
             void(const boost::asio::mutable_buffers_1& buffer, bzn::asio::write_handler handler));
         MOCK_METHOD2(write,
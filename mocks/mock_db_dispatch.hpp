@@ -24,9 +24,14 @@ namespace bzapi
     class mock_db_dispatch : public db_dispatch_base
     {
     public:
-        MOCK_METHOD3(has_uuid, void(std::shared_ptr<swarm_base>, uuid_t, std::function<void(db_error)>));
+        MOCK_METHOD3(has_uuid, uint64_t(std::shared_ptr<swarm_base>, uuid_t, std::function<void(db_error)>));
         MOCK_METHOD5(create_uuid, void(std::shared_ptr<swarm_base>, uuid_t, uint64_t, bool, std::function<void(db_error)>));
         MOCK_METHOD5(send_message_to_swarm, void(std::shared_ptr<swarm_base>, uuid_t, database_msg&, send_policy, db_response_handler_t));
+        MOCK_METHOD5(subscribe, uint64_t(std::shared_ptr<swarm_base>, uuid_t, const std::string&, db_response_handler_t, subscription_handler_t));
+        MOCK_METHOD4(unsubscribe, void(std::shared_ptr<swarm_base>, uuid_t, const std::string&, uint64_t));
+        MOCK_METHOD1(cancel_request, void(uint64_t));
+        MOCK_METHOD0(wait_for_room, bool(void));
         MOCK_METHOD0(swarm_status, std::string(void));
+        MOCK_METHOD0(get_request_stats, admission_control::stats(void));
     };
 }
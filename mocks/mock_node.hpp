@@ -26,7 +26,8 @@ namespace bzapi
     public:
 
         MOCK_METHOD1(register_message_handler, void(node_message_handler handler));
-        MOCK_METHOD2(send_message, void(const std::string& msg, completion_handler_t callback));
-        MOCK_METHOD1(back_off, void(bool value));
+        MOCK_METHOD1(register_disconnect_handler, void(node_disconnect_handler handler));
+        MOCK_METHOD2(send_message, void(std::shared_ptr<const std::string> msg, completion_handler_t callback));
+        MOCK_METHOD2(back_off, void(bool value, uint32_t answered));
     };
 }
@@ -25,7 +25,8 @@ namespace bzapi
     {
     public:
 
-        MOCK_METHOD4(create_node, std::shared_ptr<node_base>(std::shared_ptr<bzn::asio::io_context_base> io_context
-            , std::shared_ptr<bzn::beast::websocket_base> ws_factory , const std::string &host, uint16_t port));
+        MOCK_METHOD5(create_node, std::shared_ptr<node_base>(std::shared_ptr<bzn::asio::io_context_base> io_context
+            , std::shared_ptr<bzn::beast::websocket_base> ws_factory , const std::string &host, uint16_t port
+            , std::shared_ptr<bzn::asio::strand_base> strand));
    };
 }
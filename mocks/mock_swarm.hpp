@@ -27,10 +27,13 @@ namespace bzapi
         MOCK_METHOD2(has_uuid, void(const uuid_t& uuid, std::function<void(db_error)> callback));
         MOCK_METHOD4(create_uuid, void(const uuid_t& uuid, uint64_t max_size, bool random_evict, std::function<void(db_error)> callback));
         MOCK_METHOD1(initialize, void(completion_handler_t));
-        MOCK_METHOD2(sign_and_date_request, void(bzn_envelope&, send_policy));
+        MOCK_METHOD1(get_point_of_contact, uuid_t(send_policy));
+        MOCK_METHOD1(sign_and_date_request, void(bzn_envelope&));
         MOCK_METHOD2(send_request, int(const bzn_envelope&, send_policy));
         MOCK_METHOD2(register_response_handler, bool(payload_t, swarm_response_handler_t));
+        MOCK_METHOD1(register_disconnect_handler, void(swarm_disconnect_handler_t));
         MOCK_METHOD0(get_status, std::string(void));
         MOCK_METHOD0(honest_majority_size, size_t(void));
+        MOCK_METHOD1(measure_latency, void(std::function<void(std::chrono::microseconds)>));
     };
 }
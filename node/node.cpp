@@ -20,7 +20,11 @@ using namespace bzapi;
 
 namespace
 {
-    const uint64_t MAX_BACKOFF_TIME{1024};
+    const double INITIAL_WINDOW{16};
+    const double MAX_WINDOW{256};
+
+    // if a full window goes unanswered this long, assume the answers aren't coming
+    const std::chrono::seconds WINDOW_STALL_TIME{3};
 
     // TODO: Once we decide to use ssl between the client and the swarm then this will
     // be included in the ESR data along with peer validation on/off.
@@ -30,9 +34,11 @@ namespace
 node::node(std::shared_ptr<bzn::asio::io_context_base> io_context
     , std::shared_ptr<bzn::beast::websocket_base> ws_factory
     , const std::string& host
-    , uint16_t port)
+    , uint16_t port
+    , std::shared_ptr<bzn::asio::strand_base> strand)
 : io_context(std::move(io_context)), ws_factory(std::move(ws_factory)), endpoint(this->make_tcp_endpoint(host, port))
-    , strand(this->io_context->make_unique_strand()), backoff_timer(this->io_context->make_unique_steady_timer())
+    , strand(strand ? std::move(strand) : this->io_context->make_unique_strand()), window(INITIAL_WINDOW)
+    , window_timer(this->io_context->make_unique_steady_timer())
 {
     this->initialize_ssl_context();
 }
@@ -59,32 +65,45 @@ node::register_message_handler(node_message_handler msg_handler)
 }
 
 void
-node::back_off(bool value)
+node::register_disconnect_handler(node_disconnect_handler handler)
 {
-    if (value)
-    {
-        this->backoff_time = std::min(this->backoff_time ? 2 * this->backoff_time : 1, MAX_BACKOFF_TIME);
-    }
-    else
+    this->disconnect_handler = handler;
+}
+
+void
+node::back_off(bool value, uint32_t answered)
+{
+    this->strand->post([value, answered, weak_this = weak_from_this()]()
     {
-        this->backoff_time = this->backoff_time > 1 ? this->backoff_time / 2 : 0;
-    }
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->in_flight -= std::min<size_t>(strong_this->in_flight, answered);
+
+            if (value)
+            {
+                strong_this->window = std::max(strong_this->window / 2, 1.0);
+            }
+            else
+            {
+                strong_this->window = std::min(strong_this->window + 1 / strong_this->window, MAX_WINDOW);
+            }
+
+            strong_this->schedule_send();
+        }
+    });
 }
 
 void
-node::send_message(const std::string& msg, completion_handler_t callback)
+node::send_message(std::shared_ptr<const std::string> msg, completion_handler_t callback)
 {
-    this->strand->post([msg, callback, weak_this = weak_from_this()]()
+    this->strand->post([msg = std::move(msg), callback, weak_this = weak_from_this()]()
     {
         if (auto strong_this = weak_this.lock())
         {
             strong_this->queue_send(msg, callback);
             if (strong_this->state == connect_state::connected)
             {
-                if (strong_this->send_queue.size() == 1)
-                {
-                    strong_this->schedule_send();
-                }
+                strong_this->schedule_send();
             }
             else
             {
@@ -170,12 +189,14 @@ node::connect()
                                 return;
                             }
 
+                            // anything outstanding on the old connection won't be answered
                             strong_this->state = connect_state::connected;
-                            if (!strong_this->send_queue.empty())
-                            {
-                                strong_this->schedule_send();
-                            }
+                            strong_this->in_flight = 0;
+                            strong_this->websocket->binary(true);
+                            strong_this->schedule_send();
 
+                            // one receive buffer per connection, reused for every message read from it
+                            strong_this->read_buffer = std::make_shared<boost::beast::flat_buffer>();
                             strong_this->receive();
                         }
                     }
@@ -186,37 +207,40 @@ node::connect()
 }
 
 void
-node::queue_send(const std::string& msg, const completion_handler_t& callback)
+node::queue_send(std::shared_ptr<const std::string> msg, const completion_handler_t& callback)
 {
-    this->send_queue.push_back(std::make_shared<queued_message>(std::make_pair(msg, callback)));
+    this->send_queue.push_back(std::make_shared<queued_message>(std::make_pair(std::move(msg), callback)));
 }
 
 void
 node::do_send()
 {
     auto msg = this->send_queue.front();
-    boost::asio::mutable_buffers_1 buffer((void *) msg->first.c_str(), msg->first.length());
-    this->websocket->binary(true);
+    this->writing = true;
+    boost::asio::mutable_buffers_1 buffer((void *) msg->first->data(), msg->first->length());
     this->websocket->async_write(buffer, this->strand->wrap(
         [weak_this = weak_from_this(), callback = msg->second]
             (const boost::system::error_code& ec, unsigned long /*bytes*/)
         {
             if (auto strong_this = weak_this.lock())
             {
+                strong_this->writing = false;
                 if (ec == boost::beast::websocket::error::closed || ec == boost::asio::error::eof
                     || ec == boost::asio::error::operation_aborted)
                 {
                     // try to reconnect
+                    strong_this->connection_lost();
                     strong_this->state = connect_state::disconnected;
                     strong_this->connect();
                     return;
                 }
 
                 strong_this->send_queue.pop_front();
-                if (!strong_this->send_queue.empty())
+                if (!ec)
                 {
-                    strong_this->schedule_send();
+                    strong_this->in_flight++;
                 }
+                strong_this->schedule_send();
             }
 
             callback(ec);
@@ -227,32 +251,54 @@ node::do_send()
 void
 node::schedule_send()
 {
-    if (this->backoff_time)
+    if (this->writing || this->send_queue.empty() || this->state != connect_state::connected)
     {
-        this->backoff_timer->expires_from_now(std::chrono::milliseconds{this->backoff_time});
-        this->backoff_timer->async_wait(this->strand->wrap(
-            [weak_this = weak_from_this()](const auto& ec)
-            {
-                if (auto strong_this = weak_this.lock(); !ec)
-                {
-                    assert(!strong_this->send_queue.empty());
-                    strong_this->do_send();
-                }
-            }));
+        return;
     }
-    else
+
+    if (this->in_flight >= this->window)
     {
-        assert(!this->send_queue.empty());
-        this->do_send();
+        this->wait_for_window();
+        return;
     }
+
+    this->do_send();
+}
+
+void
+node::wait_for_window()
+{
+    if (this->window_timer_armed)
+    {
+        return;
+    }
+
+    this->window_timer_armed = true;
+    this->window_timer->expires_from_now(WINDOW_STALL_TIME);
+    this->window_timer->async_wait(this->strand->wrap(
+        [weak_this = weak_from_this()](const auto& ec)
+        {
+            if (auto strong_this = weak_this.lock(); !ec)
+            {
+                strong_this->window_timer_armed = false;
+                if (strong_this->in_flight >= strong_this->window)
+                {
+                    LOG(debug) << "No responses from node, reopening its window";
+                    strong_this->in_flight = 0;
+                }
+
+                strong_this->schedule_send();
+            }
+        }));
 }
 
 void
 node::receive()
 {
-    auto buffer = std::make_shared<boost::beast::multi_buffer>();
-    this->websocket->async_read(*buffer,
-        this->strand->wrap([weak_this = weak_from_this(), buffer, ws = this->websocket](auto ec, auto /*bytes*/)
+    // drop the previous message, keeping the buffer's storage for the next one
+    this->read_buffer->consume(this->read_buffer->size());
+    this->websocket->async_read(*this->read_buffer,
+        this->strand->wrap([weak_this = weak_from_this(), buffer = this->read_buffer, ws = this->websocket](auto ec, auto /*bytes*/)
     {
         try
         {
@@ -264,11 +310,9 @@ node::receive()
                     return;
                 }
 
-                std::stringstream ss;
-                ss << boost::beast::make_printable(buffer->data());
-                std::string str = ss.str();
-
-                if (strong_this->handler(str))
+                // hand the message up in place rather than copying it out of the buffer
+                auto data = buffer->data();
+                if (strong_this->handler(std::string_view(static_cast<const char*>(data.data()), data.size())))
                 {
                     strong_this->close();
                 }
@@ -285,6 +329,7 @@ node::receive()
 void
 node::close()
 {
+    this->connection_lost();
     if (this->websocket && this->websocket->is_open())
     {
         if (this->state != connect_state::disconnecting)
@@ -308,3 +353,12 @@ node::close()
         this->state = connect_state::disconnected;
     }
 }
+
+void
+node::connection_lost()
+{
+    if (this->state == connect_state::connected && this->disconnect_handler)
+    {
+        this->disconnect_handler();
+    }
+}
@@ -26,18 +26,20 @@ using namespace bzn::asio;
 namespace bzapi
 {
     // establishes and maintains connection with node
-    // sends messages to node
+    // sends messages to node, keeping no more outstanding than its congestion window allows
     // receives incoming messages and forwards them to owner
     class node : public node_base, public std::enable_shared_from_this<node>
     {
     public:
         node(std::shared_ptr<bzn::asio::io_context_base> io_context
             , std::shared_ptr<bzn::beast::websocket_base> ws_factory
-            , const std::string& host, uint16_t port);
+            , const std::string& host, uint16_t port
+            , std::shared_ptr<bzn::asio::strand_base> strand = nullptr);
 
         void register_message_handler(node_message_handler msg_handler) override;
-        void send_message(const std::string& msg, completion_handler_t callback) override;
-        void back_off(bool value) override;
+        void register_disconnect_handler(node_disconnect_handler handler) override;
+        void send_message(std::shared_ptr<const std::string> msg, completion_handler_t callback) override;
+        void back_off(bool value, uint32_t answered) override;
 
     private:
         const std::shared_ptr<bzn::asio::io_context_base> io_context;
@@ -48,23 +50,33 @@ namespace bzapi
         void initialize_ssl_context();
 
         node_message_handler handler;
+        node_disconnect_handler disconnect_handler;
         enum class connect_state{ disconnected, connecting, connected, disconnecting } state{connect_state::disconnected};
         std::shared_ptr<bzn::beast::websocket_stream_base> websocket;
+        std::shared_ptr<boost::beast::flat_buffer> read_buffer;
         std::mutex send_mutex;
-        std::shared_ptr<bzn::asio::steady_timer_base> backoff_timer;
-        uint64_t backoff_time{0};
 
-        using queued_message = std::pair<std::string, completion_handler_t>;
+        // aimd congestion window: requests written but not yet answered are limited to the window,
+        // which grows by one per window of answers and halves when the node says it's too busy
+        double window;
+        size_t in_flight{0};
+        bool writing{false};
+        std::shared_ptr<bzn::asio::steady_timer_base> window_timer;
+        bool window_timer_armed{false};
+
+        using queued_message = std::pair<std::shared_ptr<const std::string>, completion_handler_t>;
         std::deque<std::shared_ptr<queued_message>> send_queue;
 
         boost::asio::ip::tcp::endpoint make_tcp_endpoint(const std::string& host, uint16_t port);
         void connect();
         void receive();
         void close();
+        void connection_lost();
 
-        void queue_send(const std::string& msg, const completion_handler_t& callback);
+        void queue_send(std::shared_ptr<const std::string> msg, const completion_handler_t& callback);
         void schedule_send();
         void do_send();
+        void wait_for_window();
 
         std::unique_ptr<boost::asio::ssl::context> client_ctx;
     };
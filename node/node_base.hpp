@@ -25,7 +25,9 @@
 namespace bzapi
 {
     using websocket = uint64_t;
-    using node_message_handler = std::function<bool(const std::string& data)>;
+    // data refers to the node's receive buffer and is only valid for the duration of the call
+    using node_message_handler = std::function<bool(std::string_view data)>;
+    using node_disconnect_handler = std::function<void()>;
 
     // establishes and maintains connection with node
     // sends messages to node
@@ -37,7 +39,13 @@ namespace bzapi
         virtual ~node_base() = default;
 
         virtual void register_message_handler(node_message_handler handler) = 0;
-        virtual void send_message(const std::string& msg, completion_handler_t callback) = 0;
-        virtual void back_off(bool value) = 0;
+        // called when an established connection drops, losing whatever the node held for it (e.g. subscriptions)
+        virtual void register_disconnect_handler(node_disconnect_handler handler) = 0;
+        // msg is shared, not copied, so one serialized request can be queued on many nodes
+        virtual void send_message(std::shared_ptr<const std::string> msg, completion_handler_t callback) = 0;
+        // report that the node answered a request written to it, and whether it said it was too busy, to adjust
+        // how many requests we keep outstanding with it. only answers make room, so don't report other messages.
+        // answered is how many times the request was written, as a resent request is still only answered once
+        virtual void back_off(bool value, uint32_t answered) = 0;
    };
 }
@@ -22,7 +22,8 @@ using namespace bzapi;
 std::shared_ptr<node_base>
 node_factory::create_node(std::shared_ptr<bzn::asio::io_context_base> io_context
     , std::shared_ptr<bzn::beast::websocket_base> ws_factory
-    , const std::string& host, uint16_t port)
+    , const std::string& host, uint16_t port
+    , std::shared_ptr<bzn::asio::strand_base> strand)
 {
-    return std::make_shared<node>(io_context, ws_factory, host, port);
+    return std::make_shared<node>(io_context, ws_factory, host, port, strand);
 }
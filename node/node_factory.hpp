@@ -25,6 +25,7 @@ namespace bzapi
     public:
         std::shared_ptr<node_base> create_node(std::shared_ptr<bzn::asio::io_context_base> io_context
             , std::shared_ptr<bzn::beast::websocket_base> ws_factory
-            , const std::string& host, uint16_t port) override;
+            , const std::string& host, uint16_t port
+            , std::shared_ptr<bzn::asio::strand_base> strand) override;
     };
 }
@@ -25,7 +25,8 @@ namespace bzapi
     public:
         virtual std::shared_ptr<node_base> create_node(std::shared_ptr<bzn::asio::io_context_base> io_context
             , std::shared_ptr<bzn::beast::websocket_base> ws_factory
-            , const std::string& host, uint16_t port) = 0;
+            , const std::string& host, uint16_t port
+            , std::shared_ptr<bzn::asio::strand_base> strand) = 0;
 
         virtual ~node_factory_base() = default;
     };
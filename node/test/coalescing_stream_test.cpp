@@ -0,0 +1,227 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <gtest/gtest.h>
+#include <include/coalescing_stream.hpp>
+#include <boost/beast/websocket.hpp>
+
+using namespace testing;
+
+namespace
+{
+    // records the writes that reach it and completes them when told
+    class fake_stream
+    {
+    public:
+        using executor_type = boost::asio::io_context::executor_type;
+
+        explicit fake_stream(boost::asio::io_context& ctx)
+            : ctx(ctx)
+        {
+        }
+
+        executor_type get_executor()
+        {
+            return this->ctx.get_executor();
+        }
+
+        template <typename MutableBufferSequence, typename ReadHandler>
+        void async_read_some(const MutableBufferSequence& /*buffers*/, ReadHandler&& /*handler*/)
+        {
+        }
+
+        template <typename ConstBufferSequence, typename WriteHandler>
+        void async_write_some(const ConstBufferSequence& buffers, WriteHandler&& handler)
+        {
+            this->writes.push_back(boost::beast::buffers_to_string(buffers));
+            auto size = boost::asio::buffer_size(buffers);
+            auto shared_handler = std::make_shared<std::decay_t<WriteHandler>>(std::forward<WriteHandler>(handler));
+            this->complete = [this, shared_handler, size](const boost::system::error_code& ec)
+            {
+                boost::asio::post(this->ctx, boost::beast::bind_handler(std::move(*shared_handler), ec, size));
+            };
+        }
+
+        // completes the write in flight
+        void finish(const boost::system::error_code& ec = {})
+        {
+            auto func = std::move(this->complete);
+            this->complete = nullptr;
+            func(ec);
+        }
+
+        boost::asio::io_context& ctx;
+        std::vector<std::string> writes;
+        std::function<void(const boost::system::error_code&)> complete;
+    };
+}
+
+TEST(coalescing_stream_test, writes_behind_a_flush_share_the_next)
+{
+    boost::asio::io_context ctx;
+    bzn::beast::coalescing_stream<fake_stream> stream(ctx);
+    auto& next = stream.next_layer();
+
+    std::vector<std::pair<boost::system::error_code, size_t>> results;
+    auto write = [&](const std::string& data)
+    {
+        stream.async_write_some(boost::asio::buffer(data), [&](auto ec, auto bytes)
+        {
+            results.emplace_back(ec, bytes);
+        });
+        ctx.poll();
+        ctx.restart();
+    };
+
+    // a write to an idle stream goes straight out
+    write("a");
+    EXPECT_EQ(next.writes, std::vector<std::string>{"a"});
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].second, 1u);
+
+    // later ones complete but wait for it, then go out together
+    write("bb");
+    write("ccc");
+    EXPECT_EQ(next.writes.size(), 1u);
+    EXPECT_EQ(results.size(), 3u);
+
+    next.finish();
+    ctx.poll();
+    ctx.restart();
+    EXPECT_EQ(next.writes, std::vector<std::string>({"a", "bbccc"}));
+
+    // nothing more goes out until there's something to send
+    next.finish();
+    ctx.poll();
+    ctx.restart();
+    EXPECT_EQ(next.writes.size(), 2u);
+    EXPECT_EQ(next.complete, nullptr);
+}
+
+TEST(coalescing_stream_test, writes_wait_once_too_much_is_pending)
+{
+    boost::asio::io_context ctx;
+    bzn::beast::coalescing_stream<fake_stream> stream(ctx);
+    stream.set_max_pending(4);
+    auto& next = stream.next_layer();
+
+    size_t completed = 0;
+    boost::system::error_code last_ec;
+    auto write = [&](const std::string& data)
+    {
+        stream.async_write_some(boost::asio::buffer(data), [&](auto ec, auto /*bytes*/)
+        {
+            completed++;
+            last_ec = ec;
+        });
+        ctx.poll();
+        ctx.restart();
+    };
+
+    write("a");
+    write("12345");
+    EXPECT_EQ(completed, 1u);
+
+    // the held write completes once a flush takes it
+    next.finish();
+    ctx.poll();
+    ctx.restart();
+    EXPECT_EQ(completed, 2u);
+    EXPECT_EQ(next.writes, std::vector<std::string>({"a", "12345"}));
+
+    // a failed flush fails the writes after it
+    next.finish(boost::asio::error::broken_pipe);
+    ctx.poll();
+    ctx.restart();
+    write("b");
+    EXPECT_EQ(completed, 3u);
+    EXPECT_EQ(last_ec, boost::asio::error::broken_pipe);
+    EXPECT_EQ(next.writes.size(), 2u);
+}
+
+TEST(coalescing_stream_test, websocket_messages_arrive_intact)
+{
+    boost::asio::io_context ctx;
+    boost::asio::ip::tcp::acceptor acceptor(ctx, {boost::asio::ip::address_v4::loopback(), 0});
+
+    boost::beast::websocket::stream<boost::asio::ip::tcp::socket> server(ctx);
+    boost::beast::websocket::stream<bzn::beast::coalescing_stream<boost::asio::ip::tcp::socket>> client(ctx);
+
+    std::vector<std::string> received;
+    boost::beast::flat_buffer buffer;
+    std::function<void()> read = [&]()
+    {
+        server.async_read(buffer, [&](auto ec, auto /*bytes*/)
+        {
+            if (ec)
+            {
+                return;
+            }
+
+            received.push_back(boost::beast::buffers_to_string(buffer.data()));
+            buffer.consume(buffer.size());
+            if (received.size() < 3)
+            {
+                read();
+                return;
+            }
+
+            server.async_close(boost::beast::websocket::close_code::normal, [](auto) {});
+        });
+    };
+
+    acceptor.async_accept(server.next_layer(), [&](auto ec)
+    {
+        ASSERT_FALSE(ec);
+        server.async_accept([&](auto ec)
+        {
+            ASSERT_FALSE(ec);
+            read();
+        });
+    });
+
+    // written back to back, each as its own message
+    const std::vector<std::string> messages{"first", std::string(10000, 'x'), "third"};
+    boost::beast::flat_buffer client_buffer;
+    std::function<void(size_t)> write = [&](size_t i)
+    {
+        client.async_write(boost::asio::buffer(messages[i]), [&, i](auto ec, auto /*bytes*/)
+        {
+            ASSERT_FALSE(ec);
+            if (i + 1 < messages.size())
+            {
+                write(i + 1);
+                return;
+            }
+
+            client.async_read(client_buffer, [](auto /*ec*/, auto /*bytes*/) {});
+        });
+    };
+
+    boost::beast::get_lowest_layer(client).async_connect(acceptor.local_endpoint(), [&](auto ec)
+    {
+        ASSERT_FALSE(ec);
+        client.async_handshake("localhost", "/", [&](auto ec)
+        {
+            ASSERT_FALSE(ec);
+            client.binary(true);
+            write(0);
+        });
+    });
+
+    ctx.run_for(std::chrono::seconds(5));
+    EXPECT_EQ(received, messages);
+}
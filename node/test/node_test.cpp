@@ -25,11 +25,11 @@ boost::asio::io_context real_io_context;
 class node_test : public Test
 {
 public:
-    void init_test()
+    void init_test(size_t connections = 2)
     {
         EXPECT_CALL(*io_context, get_io_context()).Times(AtLeast(1)).WillRepeatedly(ReturnRef(real_io_context));
 
-        EXPECT_CALL(*io_context, make_unique_tcp_socket()).Times(Exactly(2))
+        EXPECT_CALL(*io_context, make_unique_tcp_socket()).Times(Exactly(connections))
             .WillRepeatedly(Invoke([&]()
         {
             auto tcp_sock = std::make_unique<bzn::asio::mock_tcp_socket_base>();
@@ -76,7 +76,7 @@ TEST_F(node_test, test_send_and_receive_message)
 
         std::string test_str{"hello world"};
         std::string test_resp{"bonjour le monde"};
-        boost::beast::multi_buffer *read_buffer = nullptr;
+        boost::beast::flat_buffer *read_buffer = nullptr;
         bzn::asio::read_handler read_cb;
         std::string request;
 
@@ -165,7 +165,7 @@ TEST_F(node_test, test_send_and_receive_message)
             }));
 
         // send the "request"
-        this->node->send_message(test_str, [&](auto ec)
+        this->node->send_message(std::make_shared<const std::string>(test_str), [&](auto ec)
         {
             EXPECT_EQ(ec, boost::system::errc::success);
         });
@@ -173,7 +173,7 @@ TEST_F(node_test, test_send_and_receive_message)
         EXPECT_EQ(request, test_str);
 
         std::string response;
-        this->node->register_message_handler([&](const std::string& data) -> bool
+        this->node->register_message_handler([&](std::string_view data) -> bool
         {
             response = data;
 
@@ -189,7 +189,7 @@ TEST_F(node_test, test_send_and_receive_message)
         EXPECT_EQ(response, test_resp);
 
         // send another "request" to test re-open of connection
-        this->node->send_message(test_str, [&](auto ec)
+        this->node->send_message(std::make_shared<const std::string>(test_str), [&](auto ec)
         {
             EXPECT_EQ(ec, boost::system::errc::success);
         });
@@ -197,3 +197,88 @@ TEST_F(node_test, test_send_and_receive_message)
         EXPECT_EQ(request, test_str);
     }
 }
+
+TEST_F(node_test, test_congestion_window)
+{
+    EXPECT_CALL(*io_context, make_unique_steady_timer()).WillOnce(Invoke([]()
+    {
+        return std::make_unique<NiceMock<bzn::asio::mock_steady_timer_base>>();
+    }));
+    init_test(1);
+
+    boost::beast::flat_buffer *read_buffer = nullptr;
+    bzn::asio::read_handler read_cb;
+    size_t writes = 0;
+
+    EXPECT_CALL(*ws_factory, make_websocket_stream(_)).WillOnce(Invoke([&](auto& /*sock*/)
+    {
+        auto websocket = std::make_unique<bzn::beast::mock_websocket_stream_base>();
+        EXPECT_CALL(*websocket, binary(_)).Times(AtLeast(1));
+        EXPECT_CALL(*websocket, async_handshake(_, _, _)).WillOnce(Invoke([&](auto, auto, auto lambda)
+        {
+            lambda(boost::system::error_code{});
+        }));
+        EXPECT_CALL(*websocket, async_read(_, _)).WillRepeatedly(Invoke([&](auto& buffer, auto cb)
+        {
+            read_buffer = &buffer;
+            read_cb = cb;
+        }));
+        EXPECT_CALL(*websocket, async_write(_, _)).WillRepeatedly(Invoke([&](const auto& buffer, auto cb)
+        {
+            writes++;
+            cb(boost::system::error_code{}, buffer.size());
+        }));
+        return websocket;
+    }));
+
+    this->node->register_message_handler([](std::string_view) -> bool
+    {
+        return false;
+    });
+
+    // a busy node gets one request at a time
+    for (size_t i = 0; i < 5; i++)
+    {
+        this->node->back_off(true, 1);
+    }
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        this->node->send_message(std::make_shared<const std::string>("request"), [](auto ec)
+        {
+            EXPECT_EQ(ec, boost::system::errc::success);
+        });
+    }
+    EXPECT_EQ(writes, 1u);
+
+    // messages the swarm doesn't report as answers, such as subscription updates, don't make room
+    for (size_t i = 0; i < 3; i++)
+    {
+        std::string update{"update"};
+        size_t n = boost::asio::buffer_copy(read_buffer->prepare(update.size()), boost::asio::buffer(update));
+        read_buffer->commit(n);
+        read_cb(boost::system::error_code{}, n);
+    }
+    EXPECT_EQ(writes, 1u);
+
+    // until it answers, still busy
+    this->node->back_off(true, 1);
+    EXPECT_EQ(writes, 2u);
+
+    // and the window opens up as it recovers
+    this->node->back_off(false, 1);
+    EXPECT_EQ(writes, 3u);
+
+    // an answer to a request written more than once frees every slot it took
+    for (size_t i = 0; i < 4; i++)
+    {
+        this->node->send_message(std::make_shared<const std::string>("request"), [](auto ec)
+        {
+            EXPECT_EQ(ec, boost::system::errc::success);
+        });
+    }
+    EXPECT_EQ(writes, 4u);
+
+    this->node->back_off(false, 2);
+    EXPECT_EQ(writes, 7u);
+}
@@ -0,0 +1,120 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <swarm/esr.hpp>
+#include <utils/esr_peer_info.hpp>
+
+using namespace bzapi;
+
+namespace
+{
+    template <typename T, typename F>
+    std::optional<T>
+    parse_response(const boost::system::error_code& ec, const std::string& response, F parse)
+    {
+        if (ec)
+        {
+            return std::nullopt;
+        }
+
+        try
+        {
+            return parse(response);
+        }
+        CATCHALL();
+
+        return std::nullopt;
+    }
+}
+
+esr::esr(std::shared_ptr<bzn::asio::io_context_base> io_context)
+: io_context(std::move(io_context))
+{
+}
+
+void
+esr::get_swarm_ids(const std::string& esr_address, const std::string& url, ids_handler_t handler)
+{
+    auto client = this->get_client(url);
+    if (!client)
+    {
+        handler({});
+        return;
+    }
+
+    client->async_req(bzn::utils::esr::make_swarm_ids_request(esr_address), [handler](const auto& ec, const auto& response)
+    {
+        auto ids = parse_response<std::vector<std::string>>(ec, response, bzn::utils::esr::parse_ids_response);
+        handler(ids ? *ids : std::vector<std::string>{});
+    });
+}
+
+void
+esr::get_peer_ids(const uuid_t& swarm_id, const std::string& esr_address, const std::string& url, ids_handler_t handler)
+{
+    auto client = this->get_client(url);
+    if (!client)
+    {
+        handler({});
+        return;
+    }
+
+    client->async_req(bzn::utils::esr::make_peer_ids_request(swarm_id, esr_address)
+        , [handler](const auto& ec, const auto& response)
+        {
+            auto ids = parse_response<std::vector<std::string>>(ec, response, bzn::utils::esr::parse_ids_response);
+            handler(ids ? *ids : std::vector<std::string>{});
+        });
+}
+
+void
+esr::get_peer_info(const uuid_t& swarm_id, const std::string& peer_id, const std::string& esr_address
+    , const std::string& url, peer_info_handler_t handler)
+{
+    auto client = this->get_client(url);
+    if (!client)
+    {
+        handler(std::nullopt);
+        return;
+    }
+
+    client->async_req(bzn::utils::esr::make_peer_info_request(swarm_id, peer_id, esr_address)
+        , [handler, peer_id](const auto& ec, const auto& response)
+        {
+            handler(parse_response<bzn::peer_address_t>(ec, response, [&peer_id](const auto& response)
+            {
+                return bzn::utils::esr::parse_peer_info_response(peer_id, response);
+            }));
+        });
+}
+
+std::shared_ptr<bzn::utils::http::client>
+esr::get_client(const std::string& url)
+{
+    std::lock_guard<std::mutex> lock(this->client_mutex);
+    if (!this->client || this->client_url != url)
+    {
+        try
+        {
+            this->client = std::make_shared<bzn::utils::http::client>(this->io_context, url);
+            this->client_url = url;
+        }
+        CATCHALL(return nullptr);
+    }
+
+    return this->client;
+}
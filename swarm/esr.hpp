@@ -18,28 +18,31 @@
 
 
 #include <swarm/esr_base.hpp>
-#include <utils/esr_peer_info.hpp>
+#include <utils/http_req.hpp>
+#include <mutex>
 
 namespace bzapi
 {
+    // makes ESR requests on the library's io_context, sharing one pool of connections to the ESR url
     class esr : public esr_base
     {
     public:
-        std::vector<std::string> get_swarm_ids(const std::string& esr_address, const std::string& url) override
-        {
-            return bzn::utils::esr::get_swarm_ids(esr_address, url);
-        }
-
-        std::vector<std::string> get_peer_ids(const uuid_t& swarm_id, const std::string& esr_address
-            , const std::string& url) override
-        {
-            return bzn::utils::esr::get_peer_ids(swarm_id, esr_address, url);
-        }
-
-        bzn::peer_address_t get_peer_info(const uuid_t& swarm_id, const std::string& peer_id
-            , const std::string& esr_address, const std::string& url) override
-        {
-            return bzn::utils::esr::get_peer_info(swarm_id, peer_id, esr_address, url);
-        }
+        esr(std::shared_ptr<bzn::asio::io_context_base> io_context);
+
+        void get_swarm_ids(const std::string& esr_address, const std::string& url, ids_handler_t handler) override;
+
+        void get_peer_ids(const uuid_t& swarm_id, const std::string& esr_address
+            , const std::string& url, ids_handler_t handler) override;
+
+        void get_peer_info(const uuid_t& swarm_id, const std::string& peer_id
+            , const std::string& esr_address, const std::string& url, peer_info_handler_t handler) override;
+
+    private:
+        const std::shared_ptr<bzn::asio::io_context_base> io_context;
+        std::shared_ptr<bzn::utils::http::client> client;
+        std::string client_url;
+        std::mutex client_mutex;
+
+        std::shared_ptr<bzn::utils::http::client> get_client(const std::string& url);
     };
 }
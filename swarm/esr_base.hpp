@@ -19,18 +19,25 @@
 
 #include <include/bluzelle.hpp>
 #include <utils/peer_address.hpp>
+#include <functional>
+#include <optional>
 
 namespace bzapi
 {
+    // looks up swarms and their nodes in the ESR contract
+    // requests are made asynchronously, and a failed request is reported as an empty result
     class esr_base
     {
     public:
+        using ids_handler_t = std::function<void(const std::vector<std::string>& ids)>;
+        using peer_info_handler_t = std::function<void(const std::optional<bzn::peer_address_t>& peer)>;
+
         virtual ~esr_base() = default;
 
-        virtual std::vector<std::string> get_swarm_ids(const std::string& esr_address, const std::string& url) = 0;
-        virtual std::vector<std::string> get_peer_ids(const uuid_t& swarm_id, const std::string& esr_address
-            , const std::string& url) = 0;
-        virtual bzn::peer_address_t get_peer_info(const uuid_t& swarm_id, const std::string& peer_id
-            , const std::string& esr_address, const std::string& url) = 0;
+        virtual void get_swarm_ids(const std::string& esr_address, const std::string& url, ids_handler_t handler) = 0;
+        virtual void get_peer_ids(const uuid_t& swarm_id, const std::string& esr_address
+            , const std::string& url, ids_handler_t handler) = 0;
+        virtual void get_peer_info(const uuid_t& swarm_id, const std::string& peer_id
+            , const std::string& esr_address, const std::string& url, peer_info_handler_t handler) = 0;
     };
 }
@@ -0,0 +1,128 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace bzapi
+{
+    // tracks a node's response times: a smoothed average that reacts quickly, and a log-bucketed
+    // histogram for percentiles. the histogram decays so it reflects the last few hundred samples
+    class latency_tracker
+    {
+    public:
+        void add_sample(std::chrono::microseconds latency)
+        {
+            if (this->total++ == 0)
+            {
+                this->avg = latency;
+            }
+            else
+            {
+                this->avg = (7 * this->avg + latency) / 8;
+            }
+
+            this->buckets[bucket_index(latency)]++;
+            if (this->total >= DECAY_COUNT)
+            {
+                this->total = 0;
+                for (auto& b : this->buckets)
+                {
+                    b /= 2;
+                    this->total += b;
+                }
+            }
+        }
+
+        bool empty() const
+        {
+            return this->total == 0;
+        }
+
+        void reset()
+        {
+            *this = latency_tracker{};
+        }
+
+        std::chrono::microseconds average() const
+        {
+            return this->avg;
+        }
+
+        // approximate latency below which the fraction q of recent samples fall
+        std::chrono::microseconds percentile(double q) const
+        {
+            if (this->empty())
+            {
+                return std::chrono::microseconds{0};
+            }
+
+            auto target = static_cast<uint64_t>(q * this->total);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                seen += this->buckets[i];
+                if (seen > target)
+                {
+                    return bucket_value(i);
+                }
+            }
+
+            return bucket_value(BUCKET_COUNT - 1);
+        }
+
+    private:
+        // four buckets per power of two, up to about an hour, keeps the error under 12.5%
+        static constexpr size_t SUB_BUCKETS = 4;
+        static constexpr size_t MAX_BITS = 32;
+        static constexpr size_t BUCKET_COUNT = (MAX_BITS - 1) * SUB_BUCKETS;
+        static constexpr uint64_t DECAY_COUNT = 512;
+
+        static size_t bucket_index(std::chrono::microseconds latency)
+        {
+            auto v = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+            v = std::min<uint64_t>(v, (uint64_t{1} << MAX_BITS) - 1);
+            if (v < SUB_BUCKETS)
+            {
+                return v;
+            }
+
+            size_t msb = 63 - __builtin_clzll(v);
+            return (msb - 1) * SUB_BUCKETS + ((v >> (msb - 2)) & (SUB_BUCKETS - 1));
+        }
+
+        // middle of the range of values held by a bucket
+        static std::chrono::microseconds bucket_value(size_t index)
+        {
+            if (index < SUB_BUCKETS)
+            {
+                return std::chrono::microseconds(index);
+            }
+
+            size_t shift = index / SUB_BUCKETS - 1;
+            uint64_t low = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+            return std::chrono::microseconds(low + ((uint64_t{1} << shift) / 2));
+        }
+
+        uint64_t total = 0;
+        std::chrono::microseconds avg{0};
+        std::array<uint32_t, BUCKET_COUNT> buckets{};
+    };
+}
@@ -20,12 +20,63 @@
 #include <utils/peer_address.hpp>
 #include <json/json.h>
 #include <boost/format.hpp>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <algorithm>
+#include <utility>
 
 using namespace bzapi;
 
 namespace
 {
     const uint32_t STATUS_REQUEST_TIME{60};
+
+    // a request that goes unanswered this long counts as a sample of this long
+    const std::chrono::seconds OUTSTANDING_REQUEST_TIME{5};
+    const size_t MAX_OUTSTANDING_REQUESTS{1024};
+
+    // database requests and responses both carry their header as field 1. pick out the nonce
+    // without parsing the rest of the message, which can be large
+    bool
+    read_header_nonce(const std::string& payload, uint64_t& nonce)
+    {
+        using google::protobuf::internal::WireFormatLite;
+
+        google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(payload.data())
+            , static_cast<int>(payload.size()));
+        const auto header_tag = WireFormatLite::MakeTag(1, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+        for (auto tag = input.ReadTag(); tag; tag = input.ReadTag())
+        {
+            if (tag != header_tag)
+            {
+                if (!WireFormatLite::SkipField(&input, tag))
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            uint32_t length;
+            if (!input.ReadVarint32(&length))
+            {
+                return false;
+            }
+
+            auto limit = input.PushLimit(static_cast<int>(length));
+            database_header header;
+            if (!header.ParseFromCodedStream(&input))
+            {
+                return false;
+            }
+            input.PopLimit(limit);
+
+            nonce = header.nonce();
+            return true;
+        }
+
+        return false;
+    }
 }
 
 swarm::swarm(std::shared_ptr<node_factory_base> node_factory
@@ -34,9 +85,12 @@ swarm::swarm(std::shared_ptr<node_factory_base> node_factory
     , std::shared_ptr<crypto_base> crypto
     , swarm_id_t swarm_id
     , uuid_t uuid
-    , const std::vector<std::pair<node_id_t, bzn::peer_address_t>>& node_list)
+    , const std::vector<std::pair<node_id_t, bzn::peer_address_t>>& node_list
+    , std::shared_ptr<verifier> signature_verifier)
 : node_factory(std::move(node_factory)), ws_factory(std::move(ws_factory)), io_context(std::move(io_context))
-    , crypto(std::move(crypto)), swarm_id(std::move(swarm_id)), my_uuid(std::move(uuid)), initial_nodes(node_list)
+    , crypto(std::move(crypto)), swarm_id(std::move(swarm_id)), my_uuid(std::move(uuid))
+    , signature_verifier(std::move(signature_verifier)), strand(this->io_context->make_unique_strand())
+    , initial_nodes(node_list)
 {
 }
 
@@ -45,11 +99,14 @@ swarm::init_nodes()
 {
     // this is done here rather than on construction because during construction we can't create
     // a weak pointer to this yet.
-    if (!this->initial_nodes.empty())
+    std::call_once(this->nodes_initialized, [this]()
     {
-        this->add_nodes(this->initial_nodes);
-        this->initial_nodes.clear();
-    }
+        if (!this->initial_nodes.empty())
+        {
+            this->add_nodes(this->initial_nodes);
+            this->initial_nodes.clear();
+        }
+    });
 }
 
 void
@@ -57,16 +114,40 @@ swarm::initialize(completion_handler_t handler)
 {
     this->init_nodes();
 
-    if (this->init_called)
+    if (this->get_nodes()->empty())
     {
-        handler(boost::system::error_code{boost::system::errc::operation_in_progress, boost::system::system_category()});
-        return;
+        LOG(error) << "Attempt to initialize swarm with no members";
+        throw(std::runtime_error("Attempt to initialize swarm with no members"));
     }
 
-    if (this->nodes->empty())
+    this->strand->post([weak_this = weak_from_this(), handler]()
     {
-        LOG(error) << "Attempt to initialize swarm with no members";
-        throw(std::runtime_error("Attempt to initialize swarm with no members"));
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->start_initialize(handler);
+        }
+    });
+}
+
+void
+swarm::start_initialize(completion_handler_t handler)
+{
+    if (this->init_called)
+    {
+        // later callers (a database opened in a swarm that's already in use) wait on the first
+        if (this->init_handler)
+        {
+            this->init_handler = [first = std::move(this->init_handler), handler](const auto& ec)
+            {
+                first(ec);
+                handler(ec);
+            };
+        }
+        else
+        {
+            handler(boost::system::error_code{});
+        }
+        return;
     }
 
     this->init_called = true;
@@ -85,28 +166,39 @@ swarm::initialize(completion_handler_t handler)
         });
 
     // request status from all nodes
-    auto current_nodes = this->nodes;
+    auto current_nodes = this->get_nodes();
     for (const auto& info : *(current_nodes))
     {
         this->send_status_request(info.first);
     }
+
+    // a remembered primary is good enough to start with, and status will correct it if it has moved
+    if (this->init_handler && current_nodes->count(this->known_primary))
+    {
+        auto init_handler = std::move(this->init_handler);
+        this->init_handler = nullptr;
+        init_handler(boost::system::error_code{});
+    }
 }
 
 void
-swarm::sign_and_date_request(bzn_envelope& request, send_policy policy)
+swarm::set_known_contacts(const uuid_t& primary, const uuid_t& fastest)
 {
-    // TODO: refactor the message so we don't need to break encapsulation like this
-    if (request.payload_case() == bzn_envelope::PayloadCase::kDatabaseMsg)
-    {
-        database_msg db_msg;
-        if (db_msg.ParseFromString(request.database_msg()))
-        {
-            db_msg.mutable_header()->set_point_of_contact(policy == send_policy::fastest ?
-                this->fastest_node : this->primary_node);
-            request.set_database_msg(db_msg.SerializeAsString());
-        }
-    }
+    std::scoped_lock<std::mutex> lock(this->info_mutex);
+    this->known_primary = primary;
+    this->known_fastest = fastest;
+}
 
+uuid_t
+swarm::get_point_of_contact(send_policy policy)
+{
+    std::scoped_lock<std::mutex> lock(this->info_mutex);
+    return policy == send_policy::fastest || policy == send_policy::hedged ? this->fastest_node : this->primary_node;
+}
+
+void
+swarm::sign_and_date_request(bzn_envelope& request)
+{
     request.set_sender(my_uuid);
     request.set_swarm_id(swarm_id);
     request.set_timestamp(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -123,13 +215,28 @@ swarm::send_request(const bzn_envelope& request, send_policy policy)
     std::shared_ptr<node_map> current_nodes;
     std::string primary;
     std::string fastest;
+    std::string next_fastest;
     {
         std::scoped_lock<std::mutex> lock(this->info_mutex);
         current_nodes = this->nodes;
         primary = this->primary_node;
         fastest = this->fastest_node;
+        next_fastest = this->next_fastest_node;
+    }
+
+    // serialize once and share the buffer between every node we send to
+    auto msg = std::make_shared<const std::string>(request.SerializeAsString());
+
+    uint64_t nonce = 0;
+    if (request.payload_case() == bzn_envelope::kDatabaseMsg)
+    {
+        read_header_nonce(request.database_msg(), nonce);
     }
 
+    // requests answered by the one node they're sent to tell us how responsive that node is.
+    // quorum requests are answered only after consensus, so say little about any one node
+    bool timed = policy == send_policy::fastest || policy == send_policy::hedged || policy == send_policy::next_fastest;
+
     switch (policy)
     {
         case send_policy::normal:
@@ -141,11 +248,12 @@ swarm::send_request(const bzn_envelope& request, send_policy policy)
                 it = current_nodes->begin();
             }
 
-            this->send_node_request(it->second.node, request);
+            this->send_node_request(it->second, msg, nonce);
         }
         break;
 
         case send_policy::fastest:
+        case send_policy::hedged:
         {
             auto it = current_nodes->find(fastest);
             if (it == current_nodes->end())
@@ -154,7 +262,26 @@ swarm::send_request(const bzn_envelope& request, send_policy policy)
                 it = current_nodes->begin();
             }
 
-            this->send_node_request(it->second.node, request);
+            this->send_node_request(it->second, msg, nonce, timed);
+        }
+        break;
+
+        case send_policy::next_fastest:
+        {
+            auto it = current_nodes->find(next_fastest);
+            if (it == current_nodes->end() || next_fastest == fastest)
+            {
+                // any node other than the fastest will do
+                it = std::find_if(current_nodes->begin(), current_nodes->end(), [&fastest](const auto& n)
+                {
+                    return n.first != fastest;
+                });
+            }
+
+            if (it != current_nodes->end())
+            {
+                this->send_node_request(it->second, msg, nonce, timed);
+            }
         }
         break;
 
@@ -162,7 +289,7 @@ swarm::send_request(const bzn_envelope& request, send_policy policy)
         {
             for (auto& i : *(current_nodes))
             {
-                this->send_node_request(i.second.node, request);
+                this->send_node_request(i.second, msg, nonce);
             }
         }
     }
@@ -171,20 +298,272 @@ swarm::send_request(const bzn_envelope& request, send_policy policy)
 }
 
 void
-swarm::send_node_request(const std::shared_ptr<node_base>& node, const bzn_envelope& request)
+swarm::send_node_request(const node_info& info, std::shared_ptr<const std::string> msg, uint64_t nonce, bool timed)
 {
-    node->send_message(request.SerializeAsString(), [](auto ec)
+    if (nonce)
+    {
+        std::scoped_lock<std::mutex> lock(info.latency->lock);
+        if (timed)
+        {
+            auto now = std::chrono::steady_clock::now();
+            auto& outstanding = info.latency->outstanding;
+
+            // nonces increase, so the oldest requests come first
+            while (!outstanding.empty() && (outstanding.size() >= MAX_OUTSTANDING_REQUESTS
+                || now - outstanding.begin()->second > OUTSTANDING_REQUEST_TIME))
+            {
+                info.latency->tracker.add_sample(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - outstanding.begin()->second));
+                outstanding.erase(outstanding.begin());
+            }
+
+            outstanding[nonce] = now;
+        }
+
+        // the node reopens its window itself if answers stop coming, so just forget the oldest
+        auto& unanswered = info.latency->unanswered;
+        if (unanswered.size() >= MAX_OUTSTANDING_REQUESTS && !unanswered.count(nonce))
+        {
+            unanswered.erase(unanswered.begin());
+        }
+
+        unanswered[nonce]++;
+    }
+
+    info.node->send_message(std::move(msg), [](auto ec)
     {
         return ec ? true: false;
     });
 }
 
+bool
+swarm::record_node_response(const node_info& info, const bzn_envelope& env)
+{
+    if (env.payload_case() != bzn_envelope::kDatabaseResponse)
+    {
+        return false;
+    }
+
+    {
+        std::scoped_lock<std::mutex> lock(info.latency->lock);
+        if (info.latency->outstanding.empty())
+        {
+            return false;
+        }
+    }
+
+    uint64_t nonce = 0;
+    if (!read_header_nonce(env.database_response(), nonce))
+    {
+        return false;
+    }
+
+    std::scoped_lock<std::mutex> lock(info.latency->lock);
+    auto it = info.latency->outstanding.find(nonce);
+    if (it == info.latency->outstanding.end())
+    {
+        return false;
+    }
+
+    info.latency->tracker.add_sample(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - it->second));
+    info.latency->outstanding.erase(it);
+    return true;
+}
+
+uint32_t
+swarm::take_node_answer(const node_info& info, const bzn_envelope& env, bool& too_busy)
+{
+    too_busy = false;
+    uint64_t nonce = 0;
+    switch (env.payload_case())
+    {
+        case bzn_envelope::kStatusResponse:
+        {
+            std::scoped_lock<std::mutex> lock(info.latency->lock);
+            return std::exchange(info.latency->status_pending, false) ? 1 : 0;
+        }
+
+        case bzn_envelope::kDatabaseResponse:
+        {
+            // subscription updates carry the subscription's nonce, but only its acknowledgement answers it
+            if (!read_header_nonce(env.database_response(), nonce))
+            {
+                return 0;
+            }
+        }
+        break;
+
+        case bzn_envelope::kSwarmError:
+        {
+            swarm_error err;
+            if (!err.ParseFromString(env.swarm_error()))
+            {
+                return 0;
+            }
+
+            too_busy = err.message() == TOO_BUSY_ERROR_MSG;
+            try
+            {
+                nonce = std::stoull(err.data());
+            }
+            catch (const std::exception&)
+            {
+                return 0;
+            }
+        }
+        break;
+
+        default:
+            return 0;
+    }
+
+    // the one answer covers every time the request was written to the node
+    std::scoped_lock<std::mutex> lock(info.latency->lock);
+    auto it = info.latency->unanswered.find(nonce);
+    if (it == info.latency->unanswered.end())
+    {
+        return 0;
+    }
+
+    auto answered = it->second;
+    info.latency->unanswered.erase(it);
+    return answered;
+}
+
+void
+swarm::update_fastest_nodes(const node_map& current_nodes)
+{
+    auto fastest_time = std::chrono::microseconds::max();
+    auto next_fastest_time = std::chrono::microseconds::max();
+    uuid_t fastest;
+    uuid_t next_fastest;
+
+    for (const auto& n : current_nodes)
+    {
+        std::chrono::microseconds latency;
+        {
+            std::scoped_lock<std::mutex> lock(n.second.latency->lock);
+            if (n.second.latency->tracker.empty())
+            {
+                // we haven't heard from this node
+                continue;
+            }
+            latency = n.second.latency->tracker.average();
+        }
+
+        if (latency < fastest_time)
+        {
+            next_fastest_time = fastest_time;
+            next_fastest = fastest;
+            fastest_time = latency;
+            fastest = n.first;
+        }
+        else if (latency < next_fastest_time)
+        {
+            next_fastest_time = latency;
+            next_fastest = n.first;
+        }
+    }
+
+    if (fastest.empty())
+    {
+        return;
+    }
+
+    std::scoped_lock<std::mutex> lock(this->info_mutex);
+    this->fastest_node = fastest;
+    this->next_fastest_node = next_fastest;
+}
+
+void
+swarm::measure_latency(std::function<void(std::chrono::microseconds)> handler)
+{
+    this->init_nodes();
+    this->strand->post([weak_this = weak_from_this(), handler]()
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            if (!strong_this->init_called)
+            {
+                strong_this->start_initialize([](const auto& /*ec*/){});
+            }
+
+            auto latency = strong_this->quorum_latency(*strong_this->get_nodes());
+            if (latency.count())
+            {
+                handler(latency);
+                return;
+            }
+
+            strong_this->latency_handlers.push_back(handler);
+        }
+    });
+}
+
+std::chrono::microseconds
+swarm::quorum_latency(const node_map& current_nodes)
+{
+    // the honest majority's answers are what a request waits for, so it's the slowest of them that counts
+    const size_t quorum = current_nodes.empty() ? 0 : (((current_nodes.size() - 1) / 3) * 2) + 1;
+    std::vector<std::chrono::microseconds> latencies;
+    for (const auto& n : current_nodes)
+    {
+        std::scoped_lock<std::mutex> lock(n.second.latency->lock);
+        if (!n.second.latency->tracker.empty())
+        {
+            latencies.push_back(n.second.latency->tracker.average());
+        }
+    }
+
+    if (!quorum || latencies.size() < quorum)
+    {
+        return std::chrono::microseconds{0};
+    }
+
+    std::nth_element(latencies.begin(), latencies.begin() + (quorum - 1), latencies.end());
+    return std::max(latencies[quorum - 1], std::chrono::microseconds{1});
+}
+
+void
+swarm::notify_latency(const node_map& current_nodes)
+{
+    if (this->latency_handlers.empty())
+    {
+        return;
+    }
+
+    auto latency = this->quorum_latency(current_nodes);
+    if (!latency.count())
+    {
+        return;
+    }
+
+    auto handlers = std::move(this->latency_handlers);
+    this->latency_handlers.clear();
+    for (const auto& handler : handlers)
+    {
+        handler(latency);
+    }
+}
+
 bool
 swarm::register_response_handler(payload_t type, swarm_response_handler_t handler)
 {
+    std::scoped_lock<std::mutex> lock(this->handlers_mutex);
     return this->response_handlers.insert(std::make_pair(type, handler)).second;
 }
 
+void
+swarm::register_disconnect_handler(swarm_disconnect_handler_t handler)
+{
+    std::scoped_lock<std::mutex> lock(this->handlers_mutex);
+    if (!this->disconnect_handler)
+    {
+        this->disconnect_handler = std::move(handler);
+    }
+}
+
 std::string
 swarm::get_status()
 {
@@ -195,6 +574,7 @@ swarm::get_status()
     status["swarm_git_commit"] = this->last_status.swarm_git_commit();
     status["uptime"] = this->last_status.uptime();
     status["fastest_node"] = this->fastest_node;
+    status["next_fastest_node"] = this->next_fastest_node;
     status["primary_node"] = this->primary_node;
 
     Json::Value node_list;
@@ -205,6 +585,13 @@ swarm::get_status()
         info["host"] = i.second.host;
         info["port"] = i.second.port;
         info["latency"] = static_cast<Json::Value::UInt64>(i.second.last_status_duration.count());
+        {
+            std::scoped_lock<std::mutex> latency_lock(i.second.latency->lock);
+            const auto& tracker = i.second.latency->tracker;
+            info["latency_avg"] = static_cast<Json::Value::UInt64>(tracker.average().count());
+            info["latency_p50"] = static_cast<Json::Value::UInt64>(tracker.percentile(0.5).count());
+            info["latency_p99"] = static_cast<Json::Value::UInt64>(tracker.percentile(0.99).count());
+        }
 
         auto last_send = std::chrono::system_clock::to_time_t(i.second.last_message_sent);
         auto last_recv = std::chrono::system_clock::to_time_t(i.second.last_message_received);
@@ -227,8 +614,6 @@ swarm::handle_status_response(const uuid_t& uuid, const bzn_envelope& response)
     // calculate time for retrieving status from this node
     auto this_node_duration = std::chrono::duration_cast<std::chrono::microseconds>(
         std::chrono::steady_clock::now() - (*current_nodes)[uuid].last_status_request_sent);
-    auto fastest_time = this_node_duration;
-    auto fastest_node_so_far = uuid;
 
     status_response status;
     if (!status.ParseFromString(response.status_response()))
@@ -263,17 +648,14 @@ swarm::handle_status_response(const uuid_t& uuid, const bzn_envelope& response)
             {
                 // store its response time
                 info.last_status_duration = this_node_duration;
+                {
+                    std::scoped_lock<std::mutex> lock(info.latency->lock);
+                    info.latency->tracker.add_sample(this_node_duration);
+                }
 
                 this->schedule_status_request(node_uuid, info);
             }
 
-            if (info.last_status_duration > std::chrono::microseconds::zero() &&
-                info.last_status_duration < fastest_time)
-            {
-                fastest_time = info.last_status_duration;
-                fastest_node_so_far = node_uuid;
-            }
-
             (*new_nodes)[node_uuid] = info;
         }
 
@@ -281,9 +663,11 @@ swarm::handle_status_response(const uuid_t& uuid, const bzn_envelope& response)
             std::scoped_lock<std::mutex> lock(this->info_mutex);
             this->nodes = new_nodes;
             this->primary_node = swarm_status["status"]["primary"]["uuid"].asString();
-            this->fastest_node = fastest_node_so_far;
             this->last_status = status;
         }
+        this->update_fastest_nodes(*new_nodes);
+        this->notify_latency(*new_nodes);
+
         // kick off status requests for newly added nodes
         for (const auto& n : new_uuids)
         {
@@ -319,23 +703,40 @@ swarm::send_status_request(const uuid_t& node_uuid)
     status_request req;
     bzn_envelope env;
     env.set_status_request(req.SerializeAsString());
-    this->sign_and_date_request(env, send_policy::normal);
-    auto msg = env.SerializeAsString();
+    this->sign_and_date_request(env);
+    auto msg = std::make_shared<const std::string>(env.SerializeAsString());
 
     info.last_status_request_sent = std::chrono::steady_clock::now();
     info.last_message_sent = std::chrono::system_clock::now();
-    node->send_message(msg, [&info, node_uuid, weak_this = weak_from_this()](auto& ec)
+    {
+        std::scoped_lock<std::mutex> lock(info.latency->lock);
+        info.latency->status_pending = true;
+    }
+
+    node->send_message(msg, [node_uuid, weak_this = weak_from_this()](auto& ec)
     {
         if (ec)
         {
             LOG(error) << "Error sending status request to node: " << ec.message();
 
-            // reset latency so this node won't be fastest
-            info.last_status_duration = std::chrono::microseconds::zero();
-
             if (auto strong_this = weak_this.lock())
             {
-                strong_this->schedule_status_request(node_uuid, info);
+                // the node map may have been replaced since the request was sent
+                auto current_nodes = strong_this->get_nodes();
+                auto it = current_nodes->find(node_uuid);
+                if (it != current_nodes->end())
+                {
+                    // reset latency so this node won't be fastest
+                    it->second.last_status_duration = std::chrono::microseconds::zero();
+                    {
+                        std::scoped_lock<std::mutex> lock(it->second.latency->lock);
+                        it->second.latency->tracker.reset();
+                        it->second.latency->outstanding.clear();
+                        it->second.latency->status_pending = false;
+                    }
+                    strong_this->update_fastest_nodes(*current_nodes);
+                    strong_this->schedule_status_request(node_uuid, it->second);
+                }
             }
         }
     });
@@ -346,7 +747,7 @@ swarm::schedule_status_request(const uuid_t& node_uuid, node_info& info)
 {
     // schedule another status request for this node
     info.status_timer->expires_from_now(this->random_avg_time(STATUS_REQUEST_TIME));
-    info.status_timer->async_wait([weak_this = weak_from_this(), node_uuid](auto ec)
+    info.status_timer->async_wait(this->strand->wrap([weak_this = weak_from_this(), node_uuid](auto ec)
     {
         if (!ec)
         {
@@ -355,11 +756,11 @@ swarm::schedule_status_request(const uuid_t& node_uuid, node_info& info)
                 strong_this->send_status_request(node_uuid);
             }
         }
-    });
+    }));
 
 }
 bool
-swarm::handle_node_message(const std::string& uuid, const std::string& data)
+swarm::handle_node_message(const std::string& uuid, std::string_view data)
 {
     auto current_nodes = this->get_nodes();
     auto it = current_nodes->find(uuid);
@@ -373,12 +774,18 @@ swarm::handle_node_message(const std::string& uuid, const std::string& data)
     info.last_message_received = std::chrono::system_clock::now();
 
     bzn_envelope env;
-    if (!env.ParseFromString(data))
+    if (!env.ParseFromArray(data.data(), static_cast<int>(data.size())))
     {
-        LOG(error) << "Dropping invalid message: " << std::string(data, MAX_MESSAGE_SIZE);
+        LOG(error) << "Dropping invalid message: " << data.substr(0, MAX_MESSAGE_SIZE);
         return true;
     }
 
+    // time the response before it waits on verification
+    if (this->record_node_response(info, env))
+    {
+        this->update_fastest_nodes(*current_nodes);
+    }
+
     // verify sender is on node list
     // note: quickread responses don't have a sender
     if (!env.sender().empty() && current_nodes->find(env.sender()) == current_nodes->end())
@@ -387,6 +794,16 @@ swarm::handle_node_message(const std::string& uuid, const std::string& data)
         return false;
     }
 
+    // hand signed messages to the verifier pool, if we have one. anything arriving behind a message
+    // that is still being verified has to wait its turn
+    auto pending = this->pending_messages.find(uuid);
+    if ((this->signature_verifier && env.signature().length())
+        || (pending != this->pending_messages.end() && !pending->second.empty()))
+    {
+        this->queue_node_message(uuid, std::move(env));
+        return false;
+    }
+
     // only verify signature if it exists. upper layer will check for existance of signature where required
     if (env.signature().length() && !this->crypto->verify(env))
     {
@@ -394,33 +811,115 @@ swarm::handle_node_message(const std::string& uuid, const std::string& data)
         return true;
     }
 
-    // adjust node "speed"
+    return this->dispatch_node_message(uuid, env);
+}
+
+void
+swarm::handle_node_disconnect(const uuid_t& uuid)
+{
+    LOG(debug) << "Lost connection to node: " << uuid;
+
+    swarm_disconnect_handler_t handler;
+    {
+        std::scoped_lock<std::mutex> lock(this->handlers_mutex);
+        handler = this->disconnect_handler;
+    }
+
+    if (handler)
+    {
+        handler(uuid);
+    }
+}
+
+void
+swarm::queue_node_message(const uuid_t& uuid, bzn_envelope&& env)
+{
+    auto pending = std::make_shared<pending_message>();
+    pending->env = std::make_shared<bzn_envelope>(std::move(env));
+    this->pending_messages[uuid].push_back(pending);
+
+    if (!pending->env->signature().length())
+    {
+        pending->verified = true;
+        pending->valid = true;
+        return;
+    }
+
+    this->signature_verifier->verify(pending->env
+        , [weak_this = weak_from_this(), strand = this->strand, uuid, pending](bool valid)
+        {
+            strand->post([weak_this, uuid, pending, valid]()
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    pending->verified = true;
+                    pending->valid = valid;
+                    strong_this->dispatch_pending_messages(uuid);
+                }
+            });
+        });
+}
+
+void
+swarm::dispatch_pending_messages(const uuid_t& uuid)
+{
+    auto& queue = this->pending_messages[uuid];
+    while (!queue.empty() && queue.front()->verified)
+    {
+        auto pending = queue.front();
+        queue.pop_front();
+
+        // the node's handler has already returned, so we can only drop bad messages here, not close the connection
+        if (!pending->valid)
+        {
+            LOG(error) << "Dropping message with invalid signature: " << pending->env->DebugString().substr(0, MAX_MESSAGE_SIZE);
+            continue;
+        }
+
+        this->dispatch_node_message(uuid, *pending->env);
+    }
+}
+
+bool
+swarm::dispatch_node_message(const uuid_t& uuid, const bzn_envelope& env)
+{
+    // adjust the "speed" of the node that relayed this, leaving its peers alone. only answers to what
+    // we wrote to it count, not subscription updates or anything else it sends unasked
+    auto current_nodes = this->get_nodes();
+    auto it = current_nodes->find(uuid);
     bool backoff_val = false;
-    if (env.payload_case() == bzn_envelope::kSwarmError)
+    if (it != current_nodes->end())
     {
-        swarm_error err;
-        backoff_val = (err.ParseFromString(env.swarm_error()) && err.message() == TOO_BUSY_ERROR_MSG);
+        if (auto answered = this->take_node_answer(it->second, env, backoff_val))
+        {
+            it->second.node->back_off(backoff_val, answered);
+        }
     }
-    for (auto& n : *this->nodes)
+
+    swarm_response_handler_t handler;
     {
-        n.second.node->back_off(backoff_val);
+        std::scoped_lock<std::mutex> lock(this->handlers_mutex);
+        auto it = this->response_handlers.find(env.payload_case());
+        if (it != this->response_handlers.end())
+        {
+            handler = it->second;
+        }
     }
 
-    auto it2 = this->response_handlers.find(env.payload_case());
-    if (it2 == this->response_handlers.end())
+    if (!handler)
     {
         LOG(error) << "Dropping message with unregistered type: " << env.DebugString().substr(0, MAX_MESSAGE_SIZE);
         return false;
     }
 
-    return it2->second(uuid, env);
+    return handler(uuid, env);
 }
 
 size_t
 swarm::honest_majority_size()
 {
-    std::scoped_lock<std::mutex> lock(this->info_mutex);
     this->init_nodes();
+    std::scoped_lock<std::mutex> lock(this->info_mutex);
     return (((this->nodes->size() - 1) / 3) * 2) + 1;
 }
 
@@ -432,29 +931,32 @@ swarm::add_nodes(const std::vector<std::pair<node_id_t, bzn::peer_address_t>>& n
         throw(std::runtime_error("Attempt to create swarm with no nodes"));
     }
 
-    this->nodes = std::make_shared<node_map>();
+    auto new_nodes = std::make_shared<node_map>();
     for (auto& node : node_list)
     {
-        (*this->nodes)[node.first] = this->add_node(node.first, node.second);
+        (*new_nodes)[node.first] = this->add_node(node.first, node.second);
     }
 
+    std::scoped_lock<std::mutex> lock(this->info_mutex);
+    this->nodes = new_nodes;
+
     // until we have status...
-    this->primary_node = node_list.front().first;
-    this->fastest_node = this->primary_node;
+    this->primary_node = new_nodes->count(this->known_primary) ? this->known_primary : node_list.front().first;
+    this->fastest_node = new_nodes->count(this->known_fastest) ? this->known_fastest : this->primary_node;
 }
 
 swarm::node_info
 swarm::add_node(const node_id_t& node_id, const bzn::peer_address_t& addr)
 {
     node_info info;
-    info.node = node_factory->create_node(io_context, ws_factory, addr.host, addr.port);
+    info.node = node_factory->create_node(io_context, ws_factory, addr.host, addr.port, this->strand);
     info.host = addr.host;
     info.port = addr.port;
     info.status_timer = this->io_context->make_unique_steady_timer();
 
     LOG(debug) << "adding node: " << info.host << ":" << info.port;
 
-    info.node->register_message_handler([weak_this = weak_from_this(), node_id](const std::string& data)
+    info.node->register_message_handler([weak_this = weak_from_this(), node_id](std::string_view data)
     {
         if (auto strong_this = weak_this.lock())
         {
@@ -464,6 +966,14 @@ swarm::add_node(const node_id_t& node_id, const bzn::peer_address_t& addr)
         return true;
     });
 
+    info.node->register_disconnect_handler([weak_this = weak_from_this(), node_id]()
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->handle_node_disconnect(node_id);
+        }
+    });
+
     return info;
 }
 
@@ -18,7 +18,11 @@
 
 #include <swarm/swarm_base.hpp>
 #include <crypto/crypto_base.hpp>
+#include <crypto/verifier.hpp>
 #include <node/node_base.hpp>
+#include <swarm/latency_tracker.hpp>
+#include <deque>
+#include <map>
 
 namespace bzapi
 {
@@ -27,6 +31,7 @@ namespace bzapi
     // signs and serializes outgoing requests
     // deserializes, validates (signature and sender) incoming messages
     // dispatches incoming messages based on payload type
+    // the swarm and its nodes share one strand, so independent swarms can run on different io threads
     class swarm : public swarm_base, public std::enable_shared_from_this<swarm>
     {
     public:
@@ -36,13 +41,17 @@ namespace bzapi
             , std::shared_ptr<crypto_base> crypto
             , swarm_id_t swarm_id
             , uuid_t uuid
-            , const std::vector<std::pair<node_id_t, bzn::peer_address_t>>& node_list);
+            , const std::vector<std::pair<node_id_t, bzn::peer_address_t>>& node_list
+            , std::shared_ptr<verifier> signature_verifier = nullptr);
 
         void initialize(completion_handler_t handler) override;
 
         bool register_response_handler(payload_t type, swarm_response_handler_t handler) override;
 
-        void sign_and_date_request(bzn_envelope& request, send_policy policy) override;
+        void register_disconnect_handler(swarm_disconnect_handler_t handler) override;
+
+        uuid_t get_point_of_contact(send_policy policy) override;
+        void sign_and_date_request(bzn_envelope& request) override;
 
         int send_request(const bzn_envelope& request, send_policy policy) override;
 
@@ -50,7 +59,28 @@ namespace bzapi
 
         size_t honest_majority_size() override;
 
+        void measure_latency(std::function<void(std::chrono::microseconds)> handler) override;
+
+        // primary and fastest node remembered from an earlier run, used until status says otherwise.
+        // a swarm that knows its primary is ready without waiting for status. call before initialize
+        void set_known_contacts(const uuid_t& primary, const uuid_t& fastest);
+
     private:
+        // response times measured from status requests and from requests sent to a single node, and the
+        // requests the node has yet to answer. shared between copies of a node's info, and touched from the
+        // sending thread as well as the strand
+        struct node_latency
+        {
+            std::mutex lock;
+            latency_tracker tracker;
+            std::map<uint64_t, std::chrono::steady_clock::time_point> outstanding;
+
+            // times each request has been written to the node without an answer. only answers to these
+            // make room in the node's congestion window
+            std::map<uint64_t, uint32_t> unanswered;
+            bool status_pending = false;
+        };
+
         struct node_info
         {
             std::shared_ptr<node_base> node;
@@ -61,34 +91,68 @@ namespace bzapi
             std::chrono::system_clock::time_point last_message_sent = {};
             std::chrono::system_clock::time_point last_message_received = {};
             std::shared_ptr<bzn::asio::steady_timer_base> status_timer = {};
+            std::shared_ptr<node_latency> latency = std::make_shared<node_latency>();
         };
         using node_map = std::unordered_map<uuid_t, node_info>;
 
+        // a message waiting on (or done with) signature verification
+        struct pending_message
+        {
+            std::shared_ptr<bzn_envelope> env;
+            bool verified = false;
+            bool valid = false;
+        };
+        using pending_queue = std::deque<std::shared_ptr<pending_message>>;
+
         const std::shared_ptr<node_factory_base> node_factory;
         const std::shared_ptr<bzn::beast::websocket_base> ws_factory;
         const std::shared_ptr<bzn::asio::io_context_base> io_context;
         const std::shared_ptr<crypto_base> crypto;
         const swarm_id_t swarm_id;
         const uuid_t my_uuid;
+        const std::shared_ptr<verifier> signature_verifier;
+        const std::shared_ptr<bzn::asio::strand_base> strand;
 
         bool init_called = false;
+        std::once_flag nodes_initialized;
         std::vector<std::pair<node_id_t, bzn::peer_address_t>> initial_nodes;
         completion_handler_t init_handler = nullptr;
+        std::vector<std::function<void(std::chrono::microseconds)>> latency_handlers;
         std::unordered_map<payload_t, swarm_response_handler_t> response_handlers;
+        swarm_disconnect_handler_t disconnect_handler;
+        std::mutex handlers_mutex;
 
         std::shared_ptr<node_map> nodes;
         uuid_t fastest_node;
+        uuid_t next_fastest_node;
         uuid_t primary_node;
+        uuid_t known_primary;
+        uuid_t known_fastest;
         status_response last_status;
         std::mutex info_mutex;
 
+        // messages are dispatched in the order each node relayed them, so a message may
+        // wait here for earlier ones still being verified
+        std::unordered_map<uuid_t, pending_queue> pending_messages;
+
         void init_nodes();
+        void start_initialize(completion_handler_t handler);
         void add_nodes(const std::vector<std::pair<node_id_t, bzn::peer_address_t>>& node_list);
         void send_status_request(const uuid_t& node_uuid);
-        void send_node_request(const std::shared_ptr<node_base>& node, const bzn_envelope& request);
+        void send_node_request(const node_info& info, std::shared_ptr<const std::string> msg, uint64_t nonce = 0
+            , bool timed = false);
+        bool record_node_response(const node_info& info, const bzn_envelope& env);
+        uint32_t take_node_answer(const node_info& info, const bzn_envelope& env, bool& too_busy);
+        void update_fastest_nodes(const node_map& current_nodes);
+        std::chrono::microseconds quorum_latency(const node_map& current_nodes);
+        void notify_latency(const node_map& current_nodes);
         bool handle_status_response(const uuid_t& uuid, const bzn_envelope& response);
         void schedule_status_request(const uuid_t& node_uuid, node_info& info);
-        bool handle_node_message(const std::string& uuid, const std::string& data);
+        bool handle_node_message(const std::string& uuid, std::string_view data);
+        void handle_node_disconnect(const uuid_t& uuid);
+        void queue_node_message(const uuid_t& uuid, bzn_envelope&& env);
+        void dispatch_pending_messages(const uuid_t& uuid);
+        bool dispatch_node_message(const uuid_t& uuid, const bzn_envelope& env);
         node_info add_node(const node_id_t& node_id, const bzn::peer_address_t& addr);
         std::shared_ptr<node_map> get_nodes();
         static std::chrono::seconds random_avg_time(uint32_t avg);
@@ -31,12 +31,19 @@ namespace bzapi
     {
         normal,
         fastest,
-        broadcast
+        broadcast,
+
+        // sent to the fastest node, then also to the next fastest if no answer arrives in good time
+        hedged,
+
+        // the fastest node other than the fastest, used for the second leg of a hedged request
+        next_fastest
     };
 
     using payload_t = bzn_envelope::PayloadCase;
     using node = uint64_t;
     using swarm_response_handler_t = std::function<bool(const uuid_t& uuid, const bzn_envelope&)>;
+    using swarm_disconnect_handler_t = std::function<void(const uuid_t& uuid)>;
 
     class swarm_base
     {
@@ -45,14 +52,24 @@ namespace bzapi
 
         virtual void initialize(completion_handler_t handler) = 0;
 
-        virtual void sign_and_date_request(bzn_envelope& request, send_policy policy) = 0;
+        // node a request sent with the given policy should be addressed to
+        virtual uuid_t get_point_of_contact(send_policy policy) = 0;
+
+        virtual void sign_and_date_request(bzn_envelope& request) = 0;
 
         virtual int send_request(const bzn_envelope& request, send_policy policy) = 0;
 
         virtual bool register_response_handler(payload_t type, swarm_response_handler_t handler) = 0;
 
+        // called with the uuid of a node whose connection has dropped, so anything it held for us is gone
+        virtual void register_disconnect_handler(swarm_disconnect_handler_t handler) = 0;
+
         virtual std::string get_status() = 0;
 
         virtual size_t honest_majority_size() = 0;
+
+        // starts the swarm if need be, and calls handler with the time a quorum of its nodes takes to answer
+        // once enough of them have. the handler isn't called if they never do
+        virtual void measure_latency(std::function<void(std::chrono::microseconds)> handler) = 0;
     };
 }
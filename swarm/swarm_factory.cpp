@@ -19,6 +19,9 @@
 #include <swarm/esr.hpp>
 #include <node/node_factory.hpp>
 #include <utils/esr_peer_info.hpp>
+#include <json/json.h>
+#include <cstdio>
+#include <fstream>
 #include <random>
 
 namespace bzapi
@@ -29,6 +32,14 @@ namespace bzapi
 namespace
 {
     uint64_t MAX_RETRY{5};
+
+    // swarms probed at once when choosing where to create a database, and how long to wait for them
+    const size_t MAX_SWARM_PROBES{8};
+    const std::chrono::milliseconds SWARM_PROBE_TIMEOUT{2000};
+
+    // swarms asked about a database at once, and how long a database none of them has is taken to be missing
+    const size_t MAX_DB_LOOKUPS{4};
+    const std::chrono::seconds MISSING_DB_TTL{30};
 }
 
 using namespace bzapi;
@@ -37,10 +48,19 @@ swarm_factory::swarm_factory(std::shared_ptr<bzn::asio::io_context_base> io_cont
     , std::shared_ptr<bzn::beast::websocket_base> ws_factory
     , std::shared_ptr<crypto_base> crypto
     , std::shared_ptr<esr_base> esr
-    , const uuid_t& uuid)
+    , const uuid_t& uuid
+    , std::shared_ptr<verifier> signature_verifier
+    , std::string topology_cache)
 : io_context(std::move(io_context)), ws_factory(std::move(ws_factory)), crypto(std::move(crypto)), esr(std::move(esr))
-    , my_uuid(uuid), node_factory(std::make_shared<::node_factory>())
+    , my_uuid(uuid), signature_verifier(std::move(signature_verifier)), node_factory(std::make_shared<::node_factory>())
+    , strand(this->io_context->make_unique_strand()), topology_cache(std::move(topology_cache))
+{
+}
+
+swarm_factory::~swarm_factory()
 {
+    // keep what's been learned about each swarm's primary since the last save
+    this->save_topology();
 }
 
 void
@@ -49,6 +69,7 @@ swarm_factory::initialize(const std::string& esr_addr, const std::string& url)
     this->esr_address = esr_addr;
     this->esr_url = url;
     this->swarm_reg = std::make_shared<swarm_registry>();
+    this->load_topology();
     this->update_swarm_registry();
     this->initialized = true;
 }
@@ -71,42 +92,237 @@ swarm_factory::has_db(const uuid_t& uuid, std::function<void(db_error, std::shar
 {
     assert(this->initialized);
 
+    // the swarm registry and database map are only touched on our strand
+    this->strand->post([weak_this = weak_from_this(), uuid, callback]()
+    {
+        if (auto strong_this = weak_this.lock())
+        {
+            strong_this->after_discovery([weak_this, uuid, callback]()
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    strong_this->do_has_db(uuid, callback);
+                }
+            });
+        }
+    });
+}
+
+void
+swarm_factory::after_discovery(std::function<void()> func)
+{
+    if (this->discovering)
+    {
+        this->waiting_for_discovery.push_back(std::move(func));
+        return;
+    }
+
+    func();
+}
+
+void
+swarm_factory::do_has_db(const uuid_t& uuid, std::function<void(db_error, std::shared_ptr<swarm_base>)> callback)
+{
     auto it = this->swarm_dbs.find(uuid);
     if (it != this->swarm_dbs.end())
     {
-        auto sw = this->get_or_create_swarm(it->second);
-        callback(sw ? db_error::success : db_error::database_error, sw);
+        this->check_cached_db(uuid, it->second, std::move(callback));
         return;
     }
 
-    auto swarms = this->swarm_reg->get_swarms();
-    auto count = std::make_shared<size_t>(swarms.size());
-    for (const auto& elem : swarms)
+    this->lookup_db(uuid, std::move(callback));
+}
+
+void
+swarm_factory::check_cached_db(const uuid_t& uuid, const swarm_id_t& swarm_id
+    , std::function<void(db_error, std::shared_ptr<swarm_base>)> callback)
+{
+    auto sw = this->get_or_create_swarm(swarm_id);
+    if (!sw)
+    {
+        callback(db_error::database_error, nullptr);
+        return;
+    }
+
+    // the database may have been deleted or moved since it was cached, so the swarm is asked to confirm it
+    get_db_dispatcher()->has_uuid(sw, uuid, [weak_this = weak_from_this(), uuid, swarm_id, sw, callback](auto err)
     {
-        auto sw = this->get_or_create_swarm(elem);
-        get_db_dispatcher()->has_uuid(sw, uuid
-            , [weak_this = weak_from_this(), uuid, sw_id = elem, count, callback, sw](auto err)
+        if (auto strong_this = weak_this.lock())
         {
-            (*count)--;
-            if (err == db_error::success)
+            strong_this->strand->post([weak_this, uuid, swarm_id, sw, callback, err]()
             {
                 if (auto strong_this = weak_this.lock())
                 {
-                    strong_this->swarm_dbs[uuid] = sw_id;
+                    strong_this->handle_cached_db_result(uuid, swarm_id, sw, err, callback);
                 }
-                callback(db_error::success, sw);
-            }
-            else
+            });
+        }
+    });
+}
+
+void
+swarm_factory::handle_cached_db_result(const uuid_t& uuid, const swarm_id_t& swarm_id, std::shared_ptr<swarm_base> swarm
+    , db_error err, std::function<void(db_error, std::shared_ptr<swarm_base>)> callback)
+{
+    if (err == db_error::success)
+    {
+        callback(db_error::success, swarm);
+        return;
+    }
+
+    // a swarm that no longer has the database is forgotten. one that couldn't answer keeps it, but the other
+    // swarms are asked as well
+    if (err == db_error::no_database)
+    {
+        auto it = this->swarm_dbs.find(uuid);
+        if (it != this->swarm_dbs.end() && it->second == swarm_id)
+        {
+            this->swarm_dbs.erase(it);
+            this->save_topology();
+        }
+    }
+
+    this->lookup_db(uuid, std::move(callback));
+}
+
+void
+swarm_factory::lookup_db(const uuid_t& uuid, std::function<void(db_error, std::shared_ptr<swarm_base>)> callback)
+{
+    auto missing = this->missing_dbs.find(uuid);
+    if (missing != this->missing_dbs.end())
+    {
+        if (std::chrono::steady_clock::now() - missing->second < MISSING_DB_TTL)
+        {
+            callback(db_error::no_database, nullptr);
+            return;
+        }
+
+        this->missing_dbs.erase(missing);
+    }
+
+    auto swarms = this->swarm_reg->get_swarms();
+    if (swarms.empty())
+    {
+        callback(db_error::no_database, nullptr);
+        return;
+    }
+
+    // swarms we're already connected to are asked first, and the rest only as needed
+    auto lookup = std::make_shared<db_lookup>();
+    lookup->uuid = uuid;
+    lookup->callback = std::move(callback);
+    for (const auto& sw_id : swarms)
+    {
+        if (this->swarm_reg->get_swarm(sw_id).lock())
+        {
+            lookup->pending.push_front(sw_id);
+        }
+        else
+        {
+            lookup->pending.push_back(sw_id);
+        }
+    }
+
+    this->continue_lookup(lookup);
+}
+
+void
+swarm_factory::continue_lookup(const std::shared_ptr<db_lookup>& lookup)
+{
+    while (lookup->callback && !lookup->pending.empty() && lookup->outstanding.size() < MAX_DB_LOOKUPS)
+    {
+        auto sw_id = lookup->pending.front();
+        lookup->pending.pop_front();
+        auto sw = this->get_or_create_swarm(sw_id);
+        lookup->outstanding[sw_id] = get_db_dispatcher()->has_uuid(sw, lookup->uuid
+            , [weak_this = weak_from_this(), lookup, sw_id, sw](auto err)
             {
-                if (!(*count))
+                if (auto strong_this = weak_this.lock())
                 {
-                    callback(db_error::no_database, nullptr);
+                    strong_this->strand->post([weak_this, lookup, sw_id, sw, err]()
+                    {
+                        if (auto strong_this = weak_this.lock())
+                        {
+                            strong_this->handle_lookup_result(lookup, sw_id, sw, err);
+                        }
+                    });
                 }
-            }
-        });
+            });
     }
 }
 
+void
+swarm_factory::handle_lookup_result(const std::shared_ptr<db_lookup>& lookup, const swarm_id_t& swarm_id
+    , std::shared_ptr<swarm_base> swarm, db_error err)
+{
+    if (!lookup->callback)
+    {
+        return;
+    }
+
+    lookup->outstanding.erase(swarm_id);
+    if (err == db_error::success)
+    {
+        // no need to hear from the others, or to stay connected to them
+        for (const auto& request : lookup->outstanding)
+        {
+            get_db_dispatcher()->cancel_request(request.second);
+        }
+        lookup->outstanding.clear();
+        lookup->pending.clear();
+
+        this->set_db_swarm(lookup->uuid, swarm_id);
+
+        auto callback = std::move(lookup->callback);
+        lookup->callback = nullptr;
+        callback(db_error::success, swarm);
+        return;
+    }
+
+    // only a definite answer from every swarm says the database doesn't exist
+    lookup->failed |= (err != db_error::no_database);
+    if (lookup->outstanding.empty() && lookup->pending.empty())
+    {
+        if (!lookup->failed)
+        {
+            this->add_missing_db(lookup->uuid);
+        }
+
+        auto callback = std::move(lookup->callback);
+        lookup->callback = nullptr;
+        callback(db_error::no_database, nullptr);
+        return;
+    }
+
+    this->continue_lookup(lookup);
+}
+
+void
+swarm_factory::set_db_swarm(const uuid_t& uuid, const swarm_id_t& swarm_id)
+{
+    // the cache file is rewritten whole, so only when the mapping actually changes
+    auto it = this->swarm_dbs.find(uuid);
+    if (it != this->swarm_dbs.end() && it->second == swarm_id)
+    {
+        return;
+    }
+
+    this->swarm_dbs[uuid] = swarm_id;
+    this->save_topology();
+}
+
+void
+swarm_factory::add_missing_db(const uuid_t& uuid)
+{
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = this->missing_dbs.begin(); it != this->missing_dbs.end();)
+    {
+        it = (now - it->second >= MISSING_DB_TTL) ? this->missing_dbs.erase(it) : std::next(it);
+    }
+
+    this->missing_dbs[uuid] = now;
+}
+
 void
 swarm_factory::create_db(const uuid_t& db_uuid, uint64_t max_size, bool random_evict
     , std::function<void(db_error, std::shared_ptr<swarm_base>)> callback)
@@ -133,7 +349,7 @@ void
 swarm_factory::do_create_db(const uuid_t& db_uuid, uint64_t max_size, bool random_evict, uint64_t retry
     , std::function<void(db_error, std::shared_ptr<swarm_base>)> callback)
 {
-    this->select_swarm_for_size(max_size, retry, [weak_this = weak_from_this(), db_uuid, max_size
+    this->select_swarm_for_size(max_size, [weak_this = weak_from_this(), db_uuid, max_size
         , random_evict, retry, callback](auto sw_id)
     {
         if (sw_id.empty())
@@ -148,61 +364,339 @@ swarm_factory::do_create_db(const uuid_t& db_uuid, uint64_t max_size, bool rando
             get_db_dispatcher()->create_uuid(sw, db_uuid, max_size, random_evict
                 , [callback, sw, sw_id, weak_this, db_uuid, max_size, random_evict, retry](auto err)
                 {
-                    if (err == db_error::success)
+                    if (auto strong_this = weak_this.lock())
                     {
-                        if (auto strong_this = weak_this.lock())
-                        {
-                            try
-                            {
-                                strong_this->swarm_dbs[db_uuid] = sw_id;
-                            }
-                            CATCHALL();
-                        }
-                        callback(err, sw);
-                    }
-                    else
-                    {
-                        if (retry > 0)
+                        strong_this->strand->post([callback, sw, sw_id, weak_this, db_uuid, max_size, random_evict
+                            , retry, err]()
                         {
                             if (auto strong_this = weak_this.lock())
                             {
-                                strong_this->do_create_db(db_uuid, max_size, random_evict, retry - 1, callback);
+                                strong_this->handle_create_db_result(err, sw, sw_id, db_uuid, max_size, random_evict
+                                    , retry, callback);
                             }
-                        }
-                        else
-                        {
-                            callback(err, nullptr);
-                        }
+                        });
                     }
                 });
         }
     });
 }
 
+void
+swarm_factory::handle_create_db_result(db_error err, std::shared_ptr<swarm_base> sw, const swarm_id_t& sw_id
+    , const uuid_t& db_uuid, uint64_t max_size, bool random_evict, uint64_t retry
+    , std::function<void(db_error, std::shared_ptr<swarm_base>)> callback)
+{
+    if (err == db_error::success)
+    {
+        try
+        {
+            this->missing_dbs.erase(db_uuid);
+            this->set_db_swarm(db_uuid, sw_id);
+        }
+        CATCHALL();
+
+        callback(err, sw);
+    }
+    else
+    {
+        // most likely the swarm is out of room, so don't pick it again for a database this size while there
+        // are others to try
+        if (this->swarm_reg->get_swarms().size() > 1)
+        {
+            this->placement.record_failure(sw_id, max_size, std::chrono::steady_clock::now());
+        }
+
+        if (retry > 0)
+        {
+            this->do_create_db(db_uuid, max_size, random_evict, retry - 1, callback);
+        }
+        else
+        {
+            callback(err, nullptr);
+        }
+    }
+}
+
 void
 swarm_factory::update_swarm_registry()
 {
-    if (!this->esr_address.empty() && !this->esr_url.empty())
+    if (this->esr_address.empty() || this->esr_url.empty())
     {
-        auto sw_reg = std::make_shared<swarm_registry>();
-        auto swarm_list = this->esr->get_swarm_ids(esr_address, esr_url);
-        for (const auto& sw_id : swarm_list)
+        return;
+    }
+
+    // every swarm's peers, and every peer's address, are looked up at once; the new registry fills in
+    // as the answers arrive. a registry read from the cache is used in the meantime
+    this->discovering = this->swarm_reg->get_swarms().empty();
+    this->discovered_reg = std::make_shared<swarm_registry>();
+    this->esr->get_swarm_ids(this->esr_address, this->esr_url, [weak_this = weak_from_this()](const auto& swarm_ids)
+    {
+        if (auto strong_this = weak_this.lock())
         {
-            auto node_list = this->esr->get_peer_ids(sw_id, esr_address, esr_url);
-            for (const auto& node : node_list)
+            strong_this->strand->post([weak_this, swarm_ids]()
             {
-                auto ep = this->esr->get_peer_info(sw_id, node, esr_address, esr_url);
-                sw_reg->add_node(sw_id, node, ep);
-                auto strong_sw = this->swarm_reg->get_swarm(sw_id).lock();
-                if (strong_sw)
+                if (auto strong_this = weak_this.lock())
                 {
-                    sw_reg->set_swarm(sw_id, strong_sw);
+                    strong_this->discover_swarms(swarm_ids);
                 }
+            });
+        }
+    });
+}
+
+void
+swarm_factory::discover_swarms(const std::vector<swarm_id_t>& swarm_ids)
+{
+    if (swarm_ids.empty())
+    {
+        LOG(error) << "No swarms found in ESR at " << this->esr_address;
+        this->finish_discovery();
+        return;
+    }
+
+    this->esr_requests = swarm_ids.size();
+    for (const auto& sw_id : swarm_ids)
+    {
+        this->esr->get_peer_ids(sw_id, this->esr_address, this->esr_url
+            , [weak_this = weak_from_this(), sw_id](const auto& peer_ids)
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    strong_this->strand->post([weak_this, sw_id, peer_ids]()
+                    {
+                        if (auto strong_this = weak_this.lock())
+                        {
+                            strong_this->discover_peers(sw_id, peer_ids);
+                        }
+                    });
+                }
+            });
+    }
+}
+
+void
+swarm_factory::discover_peers(const swarm_id_t& swarm_id, const std::vector<node_id_t>& peer_ids)
+{
+    if (peer_ids.empty())
+    {
+        LOG(warning) << "No nodes found for swarm " << swarm_id;
+    }
+
+    this->esr_requests += peer_ids.size();
+    for (const auto& peer_id : peer_ids)
+    {
+        this->esr->get_peer_info(swarm_id, peer_id, this->esr_address, this->esr_url
+            , [weak_this = weak_from_this(), swarm_id, peer_id](const auto& peer)
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    strong_this->strand->post([weak_this, swarm_id, peer_id, peer]()
+                    {
+                        if (auto strong_this = weak_this.lock())
+                        {
+                            strong_this->add_discovered_peer(swarm_id, peer_id, peer);
+                        }
+                    });
+                }
+            });
+    }
+
+    if (!--this->esr_requests)
+    {
+        this->finish_discovery();
+    }
+}
+
+void
+swarm_factory::add_discovered_peer(const swarm_id_t& swarm_id, const node_id_t& peer_id
+    , const std::optional<bzn::peer_address_t>& peer)
+{
+    if (peer && !peer->host.empty())
+    {
+        this->discovered_reg->add_node(swarm_id, peer_id, *peer);
+    }
+    else
+    {
+        LOG(warning) << "No address found for node " << peer_id << " in swarm " << swarm_id;
+    }
+
+    if (!--this->esr_requests)
+    {
+        this->finish_discovery();
+    }
+}
+
+void
+swarm_factory::finish_discovery()
+{
+    auto swarm_ids = this->discovered_reg->get_swarms();
+    LOG(info) << "Found " << swarm_ids.size() << " swarms in ESR";
+
+    // if the ESR couldn't be read, carry on with what we have
+    if (!swarm_ids.empty())
+    {
+        // keep the swarms already in use, and what we know of them
+        for (const auto& sw_id : swarm_ids)
+        {
+            if (auto sw = this->swarm_reg->get_swarm(sw_id).lock())
+            {
+                this->discovered_reg->set_swarm(sw_id, sw);
             }
+
+            auto contacts = this->swarm_reg->get_contacts(sw_id);
+            this->discovered_reg->set_contacts(sw_id, contacts.first, contacts.second);
         }
 
+        this->swarm_reg = this->discovered_reg;
+
+        // forget databases in swarms that are gone
+        for (auto it = this->swarm_dbs.begin(); it != this->swarm_dbs.end();)
+        {
+            it = this->swarm_reg->get_nodes(it->second).empty() ? this->swarm_dbs.erase(it) : std::next(it);
+        }
+
+        this->save_topology();
+    }
+
+    this->discovered_reg = nullptr;
+    this->discovering = false;
+
+    auto waiting = std::move(this->waiting_for_discovery);
+    this->waiting_for_discovery.clear();
+    for (const auto& func : waiting)
+    {
+        func();
+    }
+}
+
+bool
+swarm_factory::load_topology()
+{
+    if (this->topology_cache.empty())
+    {
+        return false;
+    }
+
+    try
+    {
+        std::ifstream in(this->topology_cache);
+        if (!in)
+        {
+            return false;
+        }
+
+        Json::Value root;
+        in >> root;
+        if (root["esr_address"].asString() != this->esr_address || root["esr_url"].asString() != this->esr_url)
+        {
+            LOG(info) << "Ignoring topology cache for a different ESR";
+            return false;
+        }
+
+        auto sw_reg = std::make_shared<swarm_registry>();
+        const auto& swarms = root["swarms"];
+        for (const auto& sw_id : swarms.getMemberNames())
+        {
+            const auto& nodes = swarms[sw_id]["nodes"];
+            for (const auto& node_id : nodes.getMemberNames())
+            {
+                const auto& node = nodes[node_id];
+                sw_reg->add_node(sw_id, node_id, bzn::peer_address_t{node["host"].asString()
+                    , static_cast<uint16_t>(node["port"].asUInt()), static_cast<uint16_t>(node["http_port"].asUInt())
+                    , node["name"].asString(), node_id});
+            }
+
+            sw_reg->set_contacts(sw_id, swarms[sw_id]["primary"].asString(), swarms[sw_id]["fastest"].asString());
+        }
+
+        if (sw_reg->get_swarms().empty())
+        {
+            return false;
+        }
+
+        std::map<uuid_t, swarm_id_t> dbs;
+        const auto& databases = root["databases"];
+        for (const auto& db_uuid : databases.getMemberNames())
+        {
+            auto sw_id = databases[db_uuid].asString();
+            if (!sw_reg->get_nodes(sw_id).empty())
+            {
+                dbs[db_uuid] = sw_id;
+            }
+        }
+
+        LOG(info) << "Read " << sw_reg->get_swarms().size() << " swarms from " << this->topology_cache;
         this->swarm_reg = sw_reg;
+        this->swarm_dbs = std::move(dbs);
+        return true;
+    }
+    CATCHALL();
+
+    return false;
+}
+
+void
+swarm_factory::save_topology()
+{
+    // only the ESR's topology is worth keeping
+    if (this->topology_cache.empty() || this->esr_address.empty() || !this->swarm_reg)
+    {
+        return;
     }
+
+    try
+    {
+        Json::Value root;
+        root["esr_address"] = this->esr_address;
+        root["esr_url"] = this->esr_url;
+
+        for (const auto& sw_id : this->swarm_reg->get_swarms())
+        {
+            auto contacts = this->swarm_reg->get_contacts(sw_id);
+            if (auto sw = this->swarm_reg->get_swarm(sw_id).lock())
+            {
+                auto primary = sw->get_point_of_contact(send_policy::normal);
+                if (!primary.empty())
+                {
+                    contacts = std::make_pair(primary, sw->get_point_of_contact(send_policy::fastest));
+                }
+            }
+
+            auto& swarm = root["swarms"][sw_id];
+            swarm["primary"] = contacts.first;
+            swarm["fastest"] = contacts.second;
+            for (const auto& node : this->swarm_reg->get_nodes(sw_id))
+            {
+                auto& info = swarm["nodes"][node.first];
+                info["host"] = node.second.host;
+                info["port"] = node.second.port;
+                info["http_port"] = node.second.http_port;
+                info["name"] = node.second.name;
+            }
+        }
+
+        for (const auto& db : this->swarm_dbs)
+        {
+            root["databases"][db.first] = db.second;
+        }
+
+        // write a new file and move it into place, so the cache is never left half written
+        const std::string tmp_file = this->topology_cache + ".tmp";
+        {
+            std::ofstream out(tmp_file, std::ios::trunc);
+            out << root;
+            if (!out)
+            {
+                throw std::runtime_error("unable to write " + tmp_file);
+            }
+        }
+
+        if (std::rename(tmp_file.c_str(), this->topology_cache.c_str()))
+        {
+            throw std::runtime_error("unable to replace " + this->topology_cache);
+        }
+    }
+    CATCHALL();
 }
 
 std::shared_ptr<swarm_base>
@@ -214,7 +708,9 @@ swarm_factory::get_or_create_swarm(const swarm_id_t& swarm_id)
         auto nodes = this->swarm_reg->get_nodes(swarm_id);
         assert(!nodes.empty());
         auto swm = std::make_shared<swarm>(this->node_factory, this->ws_factory, this->io_context, this->crypto
-            , swarm_id, this->my_uuid, nodes);
+            , swarm_id, this->my_uuid, nodes, this->signature_verifier);
+        auto contacts = this->swarm_reg->get_contacts(swarm_id);
+        swm->set_known_contacts(contacts.first, contacts.second);
         this->swarm_reg->set_swarm(swarm_id, swm);
         return swm;
     }
@@ -273,13 +769,130 @@ swarm_factory::swarm_registry::set_swarm(const swarm_id_t& swarm_id, std::shared
     it->second.swarm = swarm;
 }
 
+std::pair<uuid_t, uuid_t>
+swarm_factory::swarm_registry::get_contacts(const swarm_id_t& swarm_id)
+{
+    auto it = this->swarms.find(swarm_id);
+    return it != this->swarms.end() ? std::make_pair(it->second.primary, it->second.fastest) : std::pair<uuid_t, uuid_t>{};
+}
+
+void
+swarm_factory::swarm_registry::set_contacts(const swarm_id_t& swarm_id, const uuid_t& primary, const uuid_t& fastest)
+{
+    auto it = this->swarms.find(swarm_id);
+    if (it != this->swarms.end())
+    {
+        it->second.primary = primary;
+        it->second.fastest = fastest;
+    }
+}
+
 void
-swarm_factory::select_swarm_for_size(uint64_t /*size*/, uint64_t hint
-    , std::function<void(const std::string& swarm_id)> callback)
-{
-    // for now, we will pick the next swarm from our list. Later we may check each swarm's status and look
-    // for the one with the most uncommitted space, which would be an async operation (hence the callback)
-    auto sw_list = this->swarm_reg->get_swarms();
-    assert(hint < sw_list.size());
-    callback(sw_list[hint]);
+swarm_factory::select_swarm_for_size(uint64_t size, std::function<void(const std::string& swarm_id)> callback)
+{
+    // the candidates are the swarms with room for the database as far as we know, and the one a quorum of
+    // whose nodes answers soonest is picked. swarms not timed lately are probed together first
+    auto now = std::chrono::steady_clock::now();
+    auto selection = std::make_shared<swarm_selection>();
+    for (const auto& sw_id : this->swarm_reg->get_swarms())
+    {
+        if (this->placement.has_room(sw_id, size, now))
+        {
+            selection->candidates.push_back(sw_id);
+        }
+    }
+
+    if (selection->candidates.empty())
+    {
+        callback({});
+        return;
+    }
+
+    // there's no choosing between one
+    std::vector<swarm_id_t> to_probe;
+    for (const auto& sw_id : selection->candidates)
+    {
+        if (selection->candidates.size() > 1 && to_probe.size() < MAX_SWARM_PROBES
+            && this->placement.needs_probe(sw_id, now))
+        {
+            this->placement.probe_started(sw_id, now);
+            to_probe.push_back(sw_id);
+        }
+    }
+
+    selection->callback = std::move(callback);
+    if (to_probe.empty())
+    {
+        this->finish_selection(selection);
+        return;
+    }
+
+    this->probe_swarms(to_probe, selection);
+}
+
+void
+swarm_factory::probe_swarms(const std::vector<swarm_id_t>& swarm_ids, std::shared_ptr<swarm_selection> selection)
+{
+    // swarms that never answer are given up on after a while
+    selection->remaining = swarm_ids.size();
+    selection->timer = this->io_context->make_unique_steady_timer();
+    selection->timer->expires_from_now(SWARM_PROBE_TIMEOUT);
+    selection->timer->async_wait(this->strand->wrap([weak_this = weak_from_this(), selection](auto ec)
+    {
+        if (ec != boost::asio::error::operation_aborted)
+        {
+            if (auto strong_this = weak_this.lock())
+            {
+                strong_this->finish_selection(selection);
+            }
+        }
+    }));
+
+    for (const auto& sw_id : swarm_ids)
+    {
+        auto sw = this->get_or_create_swarm(sw_id);
+        selection->probes.push_back(sw);
+
+        // the swarm keeps this handler if its nodes don't answer, so it mustn't keep the selection alive
+        sw->measure_latency([weak_this = weak_from_this(), weak_selection = std::weak_ptr<swarm_selection>(selection)
+            , sw_id](auto latency)
+        {
+            if (auto strong_this = weak_this.lock())
+            {
+                strong_this->strand->post([weak_this, weak_selection, sw_id, latency]()
+                {
+                    auto strong_this = weak_this.lock();
+                    auto selection = weak_selection.lock();
+                    if (strong_this && selection)
+                    {
+                        strong_this->placement.record_latency(sw_id, latency);
+                        if (!--selection->remaining)
+                        {
+                            strong_this->finish_selection(selection);
+                        }
+                    }
+                });
+            }
+        });
+    }
+}
+
+void
+swarm_factory::finish_selection(const std::shared_ptr<swarm_selection>& selection)
+{
+    if (!selection->callback)
+    {
+        return;
+    }
+
+    auto callback = std::move(selection->callback);
+    selection->callback = nullptr;
+    if (selection->timer)
+    {
+        selection->timer->cancel();
+    }
+
+    auto sw_id = this->placement.select(selection->candidates);
+    LOG(debug) << "Selected swarm " << sw_id << " from " << selection->candidates.size() << " candidates";
+    callback(sw_id);
 }
@@ -19,10 +19,13 @@
 #include <include/bluzelle.hpp>
 #include <include/boost_asio_beast.hpp>
 #include <crypto/crypto_base.hpp>
+#include <crypto/verifier.hpp>
 #include <database/async_database_impl.hpp>
 #include <swarm/swarm_base.hpp>
 #include <swarm/esr_base.hpp>
+#include <swarm/swarm_placement.hpp>
 #include <utils/peer_address.hpp>
+#include <deque>
 
 namespace bzapi
 {
@@ -34,7 +37,11 @@ namespace bzapi
             , std::shared_ptr<bzn::beast::websocket_base> ws_factory
             , std::shared_ptr<crypto_base> crypto
             , std::shared_ptr<esr_base> esr
-            , const uuid_t& uuid);
+            , const uuid_t& uuid
+            , std::shared_ptr<verifier> signature_verifier = nullptr
+            , std::string topology_cache = {});
+
+        ~swarm_factory();
 
         void initialize(const std::string& esr_address, const std::string& url);
         void initialize(const swarm_id_t& default_swarm, const std::vector<std::pair<node_id_t, bzn::peer_address_t>>& nodes);
@@ -52,11 +59,17 @@ namespace bzapi
             {
                 node_map nodes;
                 std::weak_ptr<swarm_base> swarm;
+
+                // last known primary and fastest node
+                uuid_t primary;
+                uuid_t fastest;
             };
 
             void add_node(const swarm_id_t& swarm_id, const node_id_t& node_id, const bzn::peer_address_t& endpoint);
             std::weak_ptr<swarm_base> get_swarm(const swarm_id_t& swarm_id);
             void set_swarm(const swarm_id_t& swarm_id, std::shared_ptr<swarm_base> swarm);
+            std::pair<uuid_t, uuid_t> get_contacts(const swarm_id_t& swarm_id);
+            void set_contacts(const swarm_id_t& swarm_id, const uuid_t& primary, const uuid_t& fastest);
             std::vector<swarm_id_t> get_swarms();
             std::vector<std::pair<node_id_t, bzn::peer_address_t>> get_nodes(const swarm_id_t& swarm_id);
 
@@ -69,7 +82,12 @@ namespace bzapi
         const std::shared_ptr<crypto_base> crypto;
         const std::shared_ptr<esr_base> esr;
         const uuid_t my_uuid;
+        const std::shared_ptr<verifier> signature_verifier;
         const std::shared_ptr<node_factory_base> node_factory;
+        const std::shared_ptr<bzn::asio::strand_base> strand;
+
+        // file the registry is kept in between runs, if any
+        const std::string topology_cache;
 
         std::string esr_address;
         std::string esr_url;
@@ -77,9 +95,67 @@ namespace bzapi
         std::shared_ptr<swarm_registry> swarm_reg;
         std::map<uuid_t, swarm_id_t> swarm_dbs;
 
+        // databases no swarm had a moment ago, so asking again straight away is pointless
+        std::map<uuid_t, std::chrono::steady_clock::time_point> missing_dbs;
+
+        // a has_db asking the swarms in turn, a few at once, until one has the database
+        struct db_lookup
+        {
+            uuid_t uuid;
+            std::function<void(db_error, std::shared_ptr<swarm_base>)> callback;
+            std::deque<swarm_id_t> pending;
+            std::map<swarm_id_t, uint64_t> outstanding;
+            bool failed = false;
+        };
+
+        // ESR discovery runs in the background, filling in a new registry that replaces the current one when
+        // it's done. requests needing the full swarm list wait for it unless the registry was read from the cache
+        bool discovering = false;
+        size_t esr_requests = 0;
+        std::shared_ptr<swarm_registry> discovered_reg;
+        std::vector<std::function<void()>> waiting_for_discovery;
+
+        // where new databases go, learned from probing swarms and from failed creates
+        swarm_placement placement;
+
+        // a swarm selection waiting on probes. the probed swarms are held until it's made, so the one picked
+        // is still connected when the database is created
+        struct swarm_selection
+        {
+            std::vector<swarm_id_t> candidates;
+            std::vector<std::shared_ptr<swarm_base>> probes;
+            size_t remaining = 0;
+            std::unique_ptr<bzn::asio::steady_timer_base> timer;
+            std::function<void(const std::string& swarm_id)> callback;
+        };
+
+        void after_discovery(std::function<void()> func);
+        void discover_swarms(const std::vector<swarm_id_t>& swarm_ids);
+        void discover_peers(const swarm_id_t& swarm_id, const std::vector<node_id_t>& peer_ids);
+        void add_discovered_peer(const swarm_id_t& swarm_id, const node_id_t& peer_id
+            , const std::optional<bzn::peer_address_t>& peer);
+        void finish_discovery();
+        bool load_topology();
+        void save_topology();
+        void do_has_db(const uuid_t& uuid, std::function<void(db_error, std::shared_ptr<swarm_base>)> callback);
+        void check_cached_db(const uuid_t& uuid, const swarm_id_t& swarm_id
+            , std::function<void(db_error, std::shared_ptr<swarm_base>)> callback);
+        void handle_cached_db_result(const uuid_t& uuid, const swarm_id_t& swarm_id, std::shared_ptr<swarm_base> swarm
+            , db_error err, std::function<void(db_error, std::shared_ptr<swarm_base>)> callback);
+        void lookup_db(const uuid_t& uuid, std::function<void(db_error, std::shared_ptr<swarm_base>)> callback);
+        void continue_lookup(const std::shared_ptr<db_lookup>& lookup);
+        void handle_lookup_result(const std::shared_ptr<db_lookup>& lookup, const swarm_id_t& swarm_id
+            , std::shared_ptr<swarm_base> swarm, db_error err);
+        void set_db_swarm(const uuid_t& uuid, const swarm_id_t& swarm_id);
+        void add_missing_db(const uuid_t& uuid);
         std::shared_ptr<swarm_base> get_or_create_swarm(const swarm_id_t& swarm_id);
         void update_swarm_registry();
-        void select_swarm_for_size(uint64_t size, uint64_t hint, std::function<void(const std::string& swarm_id)> callback);
+        void select_swarm_for_size(uint64_t size, std::function<void(const std::string& swarm_id)> callback);
+        void probe_swarms(const std::vector<swarm_id_t>& swarm_ids, std::shared_ptr<swarm_selection> selection);
+        void finish_selection(const std::shared_ptr<swarm_selection>& selection);
         void do_create_db(const uuid_t& uuid, uint64_t max_size, bool random_evict, uint64_t retry, std::function<void(db_error, std::shared_ptr<swarm_base>)>);
+        void handle_create_db_result(db_error err, std::shared_ptr<swarm_base> sw, const swarm_id_t& sw_id
+            , const uuid_t& db_uuid, uint64_t max_size, bool random_evict, uint64_t retry
+            , std::function<void(db_error, std::shared_ptr<swarm_base>)> callback);
     };
 }
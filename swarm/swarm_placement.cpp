@@ -0,0 +1,100 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <swarm/swarm_placement.hpp>
+
+using namespace bzapi;
+
+namespace
+{
+    // other clients come and go, so what we learn about a swarm doesn't hold for long
+    const std::chrono::minutes LATENCY_TTL{10};
+    const std::chrono::minutes FAILURE_TTL{5};
+
+    uint64_t
+    effective_size(uint64_t size)
+    {
+        // an unlimited database needs more room than any other
+        return size ? size : std::numeric_limits<uint64_t>::max();
+    }
+}
+
+bool
+swarm_placement::has_room(const swarm_id_t& swarm_id, uint64_t size, clock::time_point now) const
+{
+    auto it = this->swarms.find(swarm_id);
+    if (it == this->swarms.end() || it->second.failed == clock::time_point{} || now - it->second.failed >= FAILURE_TTL)
+    {
+        return true;
+    }
+
+    return effective_size(size) < it->second.failed_size;
+}
+
+void
+swarm_placement::record_failure(const swarm_id_t& swarm_id, uint64_t size, clock::time_point now)
+{
+    auto& stats = this->swarms[swarm_id];
+    if (now - stats.failed >= FAILURE_TTL)
+    {
+        stats.failed_size = std::numeric_limits<uint64_t>::max();
+    }
+
+    stats.failed_size = std::min(stats.failed_size, effective_size(size));
+    stats.failed = now;
+}
+
+bool
+swarm_placement::needs_probe(const swarm_id_t& swarm_id, clock::time_point now) const
+{
+    auto it = this->swarms.find(swarm_id);
+    return it == this->swarms.end() || it->second.probed == clock::time_point{} || now - it->second.probed >= LATENCY_TTL;
+}
+
+void
+swarm_placement::probe_started(const swarm_id_t& swarm_id, clock::time_point now)
+{
+    this->swarms[swarm_id].probed = now;
+}
+
+void
+swarm_placement::record_latency(const swarm_id_t& swarm_id, std::chrono::microseconds latency)
+{
+    this->swarms[swarm_id].latency = latency;
+}
+
+swarm_placement::swarm_id_t
+swarm_placement::select(const std::vector<swarm_id_t>& candidates) const
+{
+    if (candidates.empty())
+    {
+        return {};
+    }
+
+    auto best = candidates.front();
+    auto best_latency = std::chrono::microseconds::max();
+    for (const auto& sw_id : candidates)
+    {
+        auto it = this->swarms.find(sw_id);
+        if (it != this->swarms.end() && it->second.latency.count() && it->second.latency < best_latency)
+        {
+            best = sw_id;
+            best_latency = it->second.latency;
+        }
+    }
+
+    return best;
+}
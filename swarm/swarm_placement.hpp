@@ -0,0 +1,64 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <include/bluzelle.hpp>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace bzapi
+{
+    // what's been learned about where new databases fit: each swarm's measured response time, and the
+    // smallest database it recently failed to create. swarms don't report their free space, so a failed
+    // create is taken to mean the swarm has no room for a database that size or larger, for a while
+    class swarm_placement
+    {
+    public:
+        using swarm_id_t = std::string;
+        using clock = std::chrono::steady_clock;
+
+        // may a database of this size (0 for unlimited) be created in the swarm
+        bool has_room(const swarm_id_t& swarm_id, uint64_t size, clock::time_point now) const;
+
+        // creating a database of this size in the swarm failed
+        void record_failure(const swarm_id_t& swarm_id, uint64_t size, clock::time_point now);
+
+        // is the swarm's response time unknown or out of date
+        bool needs_probe(const swarm_id_t& swarm_id, clock::time_point now) const;
+
+        // a probe went out; the swarm isn't probed again for a while, whether or not it answers
+        void probe_started(const swarm_id_t& swarm_id, clock::time_point now);
+
+        void record_latency(const swarm_id_t& swarm_id, std::chrono::microseconds latency);
+
+        // the swarm to try first: the fastest one measured, else the first of the candidates
+        swarm_id_t select(const std::vector<swarm_id_t>& candidates) const;
+
+    private:
+        struct swarm_stats
+        {
+            std::chrono::microseconds latency{0};
+            clock::time_point probed{};
+            uint64_t failed_size = std::numeric_limits<uint64_t>::max();
+            clock::time_point failed{};
+        };
+
+        std::map<swarm_id_t, swarm_stats> swarms;
+    };
+}
@@ -0,0 +1,80 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <swarm/latency_tracker.hpp>
+#include <gtest/gtest.h>
+
+using namespace bzapi;
+using namespace std::chrono_literals;
+
+
+TEST(latency_tracker_test, average)
+{
+    latency_tracker tracker;
+    EXPECT_TRUE(tracker.empty());
+    EXPECT_EQ(tracker.percentile(0.5), 0us);
+
+    tracker.add_sample(80ms);
+    EXPECT_FALSE(tracker.empty());
+    EXPECT_EQ(tracker.average(), 80ms);
+
+    tracker.add_sample(160ms);
+    EXPECT_EQ(tracker.average(), 90ms);
+
+    tracker.reset();
+    EXPECT_TRUE(tracker.empty());
+}
+
+TEST(latency_tracker_test, percentiles)
+{
+    latency_tracker tracker;
+    for (size_t i = 0; i < 99; i++)
+    {
+        tracker.add_sample(10ms);
+    }
+    tracker.add_sample(1s);
+
+    // buckets are within 12.5% of the values they hold
+    EXPECT_NEAR(tracker.percentile(0.5).count(), 10000, 1250);
+    EXPECT_NEAR(tracker.percentile(0.98).count(), 10000, 1250);
+    EXPECT_NEAR(tracker.percentile(0.995).count(), 1000000, 125000);
+
+    // small and huge values still land somewhere sensible
+    latency_tracker edges;
+    edges.add_sample(0us);
+    EXPECT_EQ(edges.percentile(0.5), 0us);
+    edges.reset();
+    edges.add_sample(std::chrono::hours(10));
+    EXPECT_GT(edges.percentile(0.5), std::chrono::minutes(30));
+}
+
+TEST(latency_tracker_test, decays)
+{
+    latency_tracker tracker;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        tracker.add_sample(500ms);
+    }
+
+    // recent samples soon dominate the percentiles as well as the average
+    for (size_t i = 0; i < 1000; i++)
+    {
+        tracker.add_sample(5ms);
+    }
+
+    EXPECT_NEAR(tracker.percentile(0.9).count(), 5000, 625);
+    EXPECT_LT(tracker.average(), 6ms);
+}
@@ -18,16 +18,25 @@
 #include <mocks/mock_boost_asio_beast.hpp>
 #include <mocks/mock_node_factory.hpp>
 #include <mocks/mock_esr.hpp>
+#include <mocks/mock_db_dispatch.hpp>
 #include <crypto/null_crypto.hpp>
 #include <swarm/swarm_factory.hpp>
 #include <json/json.h>
+#include <cstdio>
+#include <fstream>
 
 using namespace testing;
 using namespace bzapi;
 
+namespace bzapi
+{
+    extern std::shared_ptr<db_dispatch_base> db_dispatcher;
+}
+
 namespace
 {
     const std::string SWARM_ID{"my_swarm"};
+    const std::string TOPOLOGY_CACHE{"swarm_factory_test_topology.json"};
 }
 
 class swarm_factory_test : public Test
@@ -39,6 +48,16 @@ public:
         mock_ws_factory = std::make_shared<bzn::beast::mock_websocket_base>();
         mock_io_context = std::make_shared<bzn::asio::mock_io_context_base>();
         the_crypto = std::make_shared<null_crypto>();
+
+        EXPECT_CALL(*mock_io_context, make_unique_strand()).WillRepeatedly(Invoke([]()
+        {
+            auto strand = std::make_unique<bzn::asio::mock_strand_base>();
+            EXPECT_CALL(*strand, post(_)).WillRepeatedly(Invoke([](auto func)
+            {
+                func();
+            }));
+            return strand;
+        }));
     }
 
 protected:
@@ -52,24 +71,347 @@ TEST_F(swarm_factory_test, test_init_esr)
 {
     auto swf = std::make_shared<swarm_factory>(mock_io_context, mock_ws_factory, the_crypto, the_esr, "my_uuid");
 
-    EXPECT_CALL(*the_esr, get_swarm_ids(_, _)).WillOnce(Invoke([](auto, auto)
+    std::vector<std::pair<std::string, esr_base::ids_handler_t>> peer_ids_requests;
+    std::vector<esr_base::peer_info_handler_t> peer_info_requests;
+
+    EXPECT_CALL(*the_esr, get_swarm_ids(_, _, _)).WillOnce(Invoke([](auto, auto, auto handler)
+    {
+        handler(std::vector<std::string>{"swarm_1", "swarm_2"});
+    }));
+    EXPECT_CALL(*the_esr, get_peer_ids(_, _, _, _)).Times(Exactly(2))
+        .WillRepeatedly(Invoke([&](auto swarm_id, auto, auto, auto handler)
+        {
+            peer_ids_requests.emplace_back(swarm_id, handler);
+        }));
+    EXPECT_CALL(*the_esr, get_peer_info(_, _, _, _, _)).Times(Exactly(4))
+        .WillRepeatedly(Invoke([&](auto, auto, auto, auto, auto handler)
+        {
+            peer_info_requests.push_back(handler);
+        }));
+
+    swf->initialize("address", "url");
+
+    // each swarm's nodes are requested without waiting on the others
+    ASSERT_EQ(peer_ids_requests.size(), 2u);
+    EXPECT_EQ(peer_ids_requests[0].first, "swarm_1");
+    EXPECT_EQ(peer_ids_requests[1].first, "swarm_2");
+
+    for (const auto& request : peer_ids_requests)
+    {
+        request.second(std::vector<std::string>{"node_1", "node_2"});
+    }
+
+    // and every node's address is requested at once
+    ASSERT_EQ(peer_info_requests.size(), 4u);
+
+    bool called = false;
+    swf->has_db("my_uuid", [&](auto err, auto sw)
+    {
+        called = true;
+        EXPECT_EQ(err, db_error::no_database);
+        EXPECT_EQ(sw, nullptr);
+    });
+
+    // database lookups wait for discovery to finish
+    EXPECT_FALSE(called);
+    for (const auto& request : peer_info_requests)
+    {
+        request(std::nullopt);
+    }
+    EXPECT_TRUE(called);
+}
+
+TEST_F(swarm_factory_test, test_init_esr_failure)
+{
+    auto swf = std::make_shared<swarm_factory>(mock_io_context, mock_ws_factory, the_crypto, the_esr, "my_uuid");
+
+    esr_base::ids_handler_t swarm_ids_handler;
+    EXPECT_CALL(*the_esr, get_swarm_ids(_, _, _)).WillOnce(Invoke([&](auto, auto, auto handler)
+    {
+        swarm_ids_handler = handler;
+    }));
+    EXPECT_CALL(*the_esr, get_peer_ids(_, _, _, _)).Times(Exactly(0));
+
+    swf->initialize("address", "url");
+
+    bool called = false;
+    swf->has_db("my_uuid", [&](auto err, auto sw)
+    {
+        called = true;
+        EXPECT_EQ(err, db_error::no_database);
+        EXPECT_EQ(sw, nullptr);
+    });
+    EXPECT_FALSE(called);
+
+    ASSERT_NE(swarm_ids_handler, nullptr);
+    swarm_ids_handler({});
+    EXPECT_TRUE(called);
+
+    // there's no swarm to create a database in either
+    swf->create_db("my_uuid", 0, false, [&](auto err, auto sw)
+    {
+        EXPECT_EQ(err, db_error::no_space);
+        EXPECT_EQ(sw, nullptr);
+    });
+}
+
+TEST_F(swarm_factory_test, test_topology_cache)
+{
+    std::remove(TOPOLOGY_CACHE.c_str());
+    auto dispatcher = std::make_shared<mock_db_dispatch>();
+    bzapi::db_dispatcher = dispatcher;
+
+    // the first run learns the topology from the ESR
+    auto swf = std::make_shared<swarm_factory>(mock_io_context, mock_ws_factory, the_crypto, the_esr, "my_uuid"
+        , nullptr, TOPOLOGY_CACHE);
+
+    EXPECT_CALL(*the_esr, get_swarm_ids(_, _, _)).WillOnce(Invoke([](auto, auto, auto handler)
+    {
+        handler(std::vector<std::string>{"swarm_1", "swarm_2"});
+    }));
+    EXPECT_CALL(*the_esr, get_peer_ids(_, _, _, _)).Times(Exactly(2))
+        .WillRepeatedly(Invoke([](auto, auto, auto, auto handler)
+        {
+            handler(std::vector<std::string>{"node_1", "node_2"});
+        }));
+    EXPECT_CALL(*the_esr, get_peer_info(_, _, _, _, _)).Times(Exactly(4))
+        .WillRepeatedly(Invoke([](auto, auto peer_id, auto, auto, auto handler)
+        {
+            handler(bzn::peer_address_t{"127.0.0.1", 50000, 8080, "name", peer_id});
+        }));
+
+    swf->initialize("address", "url");
+
+    // and that the database is in the second swarm
+    size_t has_uuid_calls = 0;
+    EXPECT_CALL(*dispatcher, has_uuid(_, _, _)).Times(Exactly(2))
+        .WillRepeatedly(Invoke([&has_uuid_calls](auto, auto, auto callback)
+        {
+            callback(++has_uuid_calls == 1 ? db_error::no_database : db_error::success);
+            return has_uuid_calls;
+        }));
+
+    bool found = false;
+    swf->has_db("my_db", [&found](auto err, auto sw)
+    {
+        found = (err == db_error::success && sw);
+    });
+    EXPECT_TRUE(found);
+    swf = nullptr;
+
+    Json::Value cache;
+    std::ifstream(TOPOLOGY_CACHE) >> cache;
+    EXPECT_EQ(cache["esr_address"].asString(), "address");
+    EXPECT_EQ(cache["swarms"].getMemberNames(), std::vector<std::string>({"swarm_1", "swarm_2"}));
+    EXPECT_EQ(cache["swarms"]["swarm_1"]["nodes"]["node_2"]["port"].asUInt(), 50000u);
+    EXPECT_EQ(cache["databases"]["my_db"].asString(), "swarm_2");
+
+    // the next run starts from the cache without waiting for the ESR, which is checked in the background
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(the_esr.get()));
+    esr_base::ids_handler_t swarm_ids_handler;
+    EXPECT_CALL(*the_esr, get_swarm_ids(_, _, _)).WillOnce(Invoke([&](auto, auto, auto handler)
+    {
+        swarm_ids_handler = handler;
+    }));
+
+    swf = std::make_shared<swarm_factory>(mock_io_context, mock_ws_factory, the_crypto, the_esr, "my_uuid"
+        , nullptr, TOPOLOGY_CACHE);
+    swf->initialize("address", "url");
+
+    // the next run asks that swarm to confirm it. if it can't say, the others are asked too, and finding the
+    // database where the cache already says it is doesn't rewrite the cache
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(dispatcher.get()));
+    std::shared_ptr<swarm_base> cached_swarm;
+    EXPECT_CALL(*dispatcher, has_uuid(_, _, _)).Times(Between(2, 3))
+        .WillRepeatedly(Invoke([&](auto sw, auto, auto callback)
+        {
+            if (!cached_swarm)
+            {
+                cached_swarm = sw;
+                callback(db_error::timeout_error);
+            }
+            else
+            {
+                callback(sw == cached_swarm ? db_error::success : db_error::no_database);
+            }
+            return 0;
+        }));
+    EXPECT_CALL(*dispatcher, cancel_request(_)).Times(AnyNumber());
+
+    std::remove(TOPOLOGY_CACHE.c_str());
+    found = false;
+    swf->has_db("my_db", [&found](auto err, auto sw)
+    {
+        found = (err == db_error::success && sw);
+    });
+    EXPECT_TRUE(found);
+    EXPECT_FALSE(std::ifstream(TOPOLOGY_CACHE).good());
+    cached_swarm = nullptr;
+
+    // an unreachable ESR leaves the cached topology in place
+    ASSERT_NE(swarm_ids_handler, nullptr);
+    swarm_ids_handler({});
+    swf = nullptr;
+
+    cache = Json::Value{};
+    std::ifstream(TOPOLOGY_CACHE) >> cache;
+    EXPECT_EQ(cache["databases"]["my_db"].asString(), "swarm_2");
+
+    bzapi::db_dispatcher = nullptr;
+    std::remove(TOPOLOGY_CACHE.c_str());
+}
+
+TEST_F(swarm_factory_test, test_has_db_lookup)
+{
+    auto dispatcher = std::make_shared<mock_db_dispatch>();
+    bzapi::db_dispatcher = dispatcher;
+    auto swf = std::make_shared<swarm_factory>(mock_io_context, mock_ws_factory, the_crypto, the_esr, "my_uuid");
+
+    EXPECT_CALL(*the_esr, get_swarm_ids(_, _, _)).WillOnce(Invoke([](auto, auto, auto handler)
     {
-        return std::vector<std::string>{"swarm_1", "swarm_2"};
+        handler(std::vector<std::string>{"swarm_1", "swarm_2", "swarm_3", "swarm_4", "swarm_5", "swarm_6"});
     }));
-    EXPECT_CALL(*the_esr, get_peer_ids(_, _, _)).Times(Exactly(2))
-        .WillRepeatedly(Invoke([](auto, auto, auto)
+    EXPECT_CALL(*the_esr, get_peer_ids(_, _, _, _)).Times(Exactly(6))
+        .WillRepeatedly(Invoke([](auto, auto, auto, auto handler)
         {
-            return std::vector<std::string>{"node_1", "node_2"};
+            handler(std::vector<std::string>{"node_1"});
         }));
-    EXPECT_CALL(*the_esr, get_peer_info(_, _, _, _)).Times(Exactly(4))
-        .WillRepeatedly(Invoke([](auto, auto, auto, auto)
+    EXPECT_CALL(*the_esr, get_peer_info(_, _, _, _, _)).Times(Exactly(6))
+        .WillRepeatedly(Invoke([](auto, auto peer_id, auto, auto, auto handler)
         {
-            static uint16_t id = 1;
-            return bzn::peer_address_t{"127.0.0.1", id, 0, "", std::string{"node_"} + std::to_string(id)};
-            id++;
+            handler(bzn::peer_address_t{"127.0.0.1", 50000, 8080, "name", peer_id});
         }));
 
     swf->initialize("address", "url");
+
+    std::vector<std::function<void(db_error)>> requests;
+    EXPECT_CALL(*dispatcher, has_uuid(_, "my_db", _)).Times(Exactly(5))
+        .WillRepeatedly(Invoke([&requests](auto, auto, auto callback)
+        {
+            requests.push_back(callback);
+            return requests.size();
+        }));
+
+    size_t called = 0;
+    swf->has_db("my_db", [&called](auto err, auto sw)
+    {
+        called++;
+        EXPECT_EQ(err, db_error::success);
+        EXPECT_NE(sw, nullptr);
+    });
+
+    // only a few swarms are asked at once, and another is asked as each says no
+    EXPECT_EQ(requests.size(), 4u);
+    requests[0](db_error::no_database);
+    EXPECT_EQ(requests.size(), 5u);
+
+    // the first to say yes settles it, and the rest are called off
+    EXPECT_CALL(*dispatcher, cancel_request(AnyOf(3u, 4u, 5u))).Times(Exactly(3));
+    requests[1](db_error::success);
+    EXPECT_EQ(called, 1u);
+
+    // late answers are ignored
+    requests[2](db_error::no_database);
+    requests[3](db_error::success);
+    EXPECT_EQ(called, 1u);
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(dispatcher.get()));
+
+    // a database no swarm has is taken to be missing for a while, unless a swarm couldn't say
+    size_t lookups = 0;
+    EXPECT_CALL(*dispatcher, has_uuid(_, "other_db", _)).Times(Exactly(12))
+        .WillRepeatedly(Invoke([&lookups](auto, auto, auto callback)
+        {
+            callback(++lookups == 1 ? db_error::timeout_error : db_error::no_database);
+            return lookups;
+        }));
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        called = 0;
+        swf->has_db("other_db", [&called](auto err, auto sw)
+        {
+            called++;
+            EXPECT_EQ(err, db_error::no_database);
+            EXPECT_EQ(sw, nullptr);
+        });
+        EXPECT_EQ(called, 1u);
+    }
+
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(dispatcher.get()));
+    swf = nullptr;
+    bzapi::db_dispatcher = nullptr;
+}
+
+TEST_F(swarm_factory_test, test_has_db_cached)
+{
+    auto dispatcher = std::make_shared<mock_db_dispatch>();
+    bzapi::db_dispatcher = dispatcher;
+    auto swf = std::make_shared<swarm_factory>(mock_io_context, mock_ws_factory, the_crypto, the_esr, "my_uuid");
+
+    EXPECT_CALL(*the_esr, get_swarm_ids(_, _, _)).WillOnce(Invoke([](auto, auto, auto handler)
+    {
+        handler(std::vector<std::string>{"swarm_1", "swarm_2"});
+    }));
+    EXPECT_CALL(*the_esr, get_peer_ids(_, _, _, _)).Times(Exactly(2))
+        .WillRepeatedly(Invoke([](auto, auto, auto, auto handler)
+        {
+            handler(std::vector<std::string>{"node_1"});
+        }));
+    EXPECT_CALL(*the_esr, get_peer_info(_, _, _, _, _)).Times(Exactly(2))
+        .WillRepeatedly(Invoke([](auto, auto peer_id, auto, auto, auto handler)
+        {
+            handler(bzn::peer_address_t{"127.0.0.1", 50000, 8080, "name", peer_id});
+        }));
+
+    swf->initialize("address", "url");
+
+    std::vector<std::function<void(db_error)>> requests;
+    EXPECT_CALL(*dispatcher, has_uuid(_, "my_db", _)).WillRepeatedly(Invoke([&requests](auto, auto, auto callback)
+    {
+        requests.push_back(callback);
+        return requests.size();
+    }));
+    EXPECT_CALL(*dispatcher, cancel_request(_)).Times(AnyNumber());
+
+    std::vector<db_error> results;
+    auto has_db = [&]()
+    {
+        swf->has_db("my_db", [&results](auto err, auto /*sw*/)
+        {
+            results.push_back(err);
+        });
+    };
+
+    // found by asking both swarms
+    has_db();
+    ASSERT_EQ(requests.size(), 2u);
+    requests[0](db_error::no_database);
+    requests[1](db_error::success);
+    EXPECT_EQ(results, std::vector<db_error>{db_error::success});
+
+    // after which only the swarm that has it is asked
+    has_db();
+    ASSERT_EQ(requests.size(), 3u);
+    requests[2](db_error::success);
+    EXPECT_EQ(results, std::vector<db_error>({db_error::success, db_error::success}));
+
+    // until it says it no longer does, when it's looked for everywhere again
+    has_db();
+    ASSERT_EQ(requests.size(), 4u);
+    requests[3](db_error::no_database);
+    ASSERT_EQ(requests.size(), 6u);
+    EXPECT_EQ(results.size(), 2u);
+    requests[4](db_error::no_database);
+    requests[5](db_error::no_database);
+    EXPECT_EQ(results, std::vector<db_error>({db_error::success, db_error::success, db_error::no_database}));
+
+    // and, now missing, isn't looked for again straight away
+    has_db();
+    EXPECT_EQ(requests.size(), 6u);
+    EXPECT_EQ(results.back(), db_error::no_database);
+
+    swf = nullptr;
+    bzapi::db_dispatcher = nullptr;
 }
 
 #if 0
@@ -77,8 +419,8 @@ TEST_F(swarm_factory_test, test_init_esr)
 TEST_F(swarm_factory_test, test_create_uuid)
 {
     this->add_node(0, 10);
-    EXPECT_CALL(*node_factory, create_node(_, _, _, _)).Times(Exactly(1))
-        .WillOnce(Invoke([self = this](auto, auto, auto, auto)
+    EXPECT_CALL(*node_factory, create_node(_, _, _, _, _)).Times(Exactly(1))
+        .WillOnce(Invoke([self = this](auto, auto, auto, auto, auto)
         {
             return self->nodes[0].node;
         }));
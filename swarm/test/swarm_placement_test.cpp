@@ -0,0 +1,80 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <swarm/swarm_placement.hpp>
+#include <gtest/gtest.h>
+
+using namespace bzapi;
+using namespace std::chrono_literals;
+
+
+TEST(swarm_placement_test, select_fastest)
+{
+    swarm_placement placement;
+    auto now = swarm_placement::clock::now();
+
+    // nothing measured, so the first candidate
+    EXPECT_EQ(placement.select({"swarm_1", "swarm_2", "swarm_3"}), "swarm_1");
+    EXPECT_EQ(placement.select({}), "");
+
+    EXPECT_TRUE(placement.needs_probe("swarm_2", now));
+    placement.probe_started("swarm_2", now);
+    placement.probe_started("swarm_3", now);
+    EXPECT_FALSE(placement.needs_probe("swarm_2", now + 1min));
+    placement.record_latency("swarm_2", 80ms);
+    placement.record_latency("swarm_3", 20ms);
+
+    // measured swarms beat unmeasured ones
+    EXPECT_EQ(placement.select({"swarm_1", "swarm_2", "swarm_3"}), "swarm_3");
+    EXPECT_EQ(placement.select({"swarm_1", "swarm_2"}), "swarm_2");
+
+    // and are measured again once the measurement is old
+    EXPECT_TRUE(placement.needs_probe("swarm_2", now + 11min));
+    EXPECT_TRUE(placement.needs_probe("swarm_1", now));
+}
+
+TEST(swarm_placement_test, failures)
+{
+    swarm_placement placement;
+    auto now = swarm_placement::clock::now();
+
+    EXPECT_TRUE(placement.has_room("swarm_1", 0, now));
+    EXPECT_TRUE(placement.has_room("swarm_1", 1000, now));
+
+    // a failure rules out that size and larger, but not smaller
+    placement.record_failure("swarm_1", 1000, now);
+    EXPECT_FALSE(placement.has_room("swarm_1", 1000, now));
+    EXPECT_FALSE(placement.has_room("swarm_1", 2000, now));
+    EXPECT_TRUE(placement.has_room("swarm_1", 999, now));
+    EXPECT_TRUE(placement.has_room("swarm_2", 2000, now));
+
+    // unlimited databases need the most room
+    EXPECT_FALSE(placement.has_room("swarm_1", 0, now));
+    placement.record_failure("swarm_2", 0, now);
+    EXPECT_FALSE(placement.has_room("swarm_2", 0, now));
+    EXPECT_TRUE(placement.has_room("swarm_2", 1000000, now));
+
+    // smaller failures lower the limit
+    placement.record_failure("swarm_1", 500, now + 1min);
+    EXPECT_FALSE(placement.has_room("swarm_1", 500, now + 1min));
+    EXPECT_TRUE(placement.has_room("swarm_1", 499, now + 1min));
+
+    // and they're forgotten after a while, as databases come and go
+    EXPECT_TRUE(placement.has_room("swarm_1", 2000, now + 7min));
+    placement.record_failure("swarm_1", 4000, now + 7min);
+    EXPECT_TRUE(placement.has_room("swarm_1", 2000, now + 7min));
+    EXPECT_FALSE(placement.has_room("swarm_1", 4000, now + 7min));
+}
@@ -35,6 +35,26 @@ namespace
     const std::string SWARM_GIT_COMMIT{".."};
     const std::string UPTIME{"1:03:01"};
     const std::string SWARM_ID{"my_swarm"};
+
+    // verification takes a while for "slow" signatures, and fails for "bad" ones
+    class slow_crypto : public crypto_base
+    {
+    public:
+        bool sign(bzn_envelope& /*msg*/) override
+        {
+            return true;
+        }
+
+        bool verify(const bzn_envelope& msg) override
+        {
+            if (msg.signature() == "slow")
+            {
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+            }
+
+            return msg.signature() != "bad";
+        }
+    };
 }
 
 class swarm_test : public Test
@@ -66,10 +86,26 @@ protected:
     std::map<uint16_t, node_meta> nodes;
     bzapi::uuid_t primary_node;
 
+    void expect_strand()
+    {
+        EXPECT_CALL(*mock_io_context, make_unique_strand()).WillRepeatedly(Invoke([]()
+        {
+            auto strand = std::make_unique<bzn::asio::mock_strand_base>();
+            EXPECT_CALL(*strand, wrap(A<bzn::asio::close_handler>())).WillRepeatedly(ReturnArg<0>());
+            EXPECT_CALL(*strand, post(_)).WillRepeatedly(Invoke([](auto func)
+            {
+                func();
+            }));
+            return strand;
+        }));
+    }
+
     void init(uint64_t time, uint64_t node_count)
     {
-        EXPECT_CALL(*node_factory, create_node(_, _, _, _)).Times(Exactly(node_count))
-            .WillRepeatedly(Invoke([self = this, node_count](auto, auto, auto, auto)
+        this->expect_strand();
+
+        EXPECT_CALL(*node_factory, create_node(_, _, _, _, _)).Times(Exactly(node_count))
+            .WillRepeatedly(Invoke([self = this, node_count](auto, auto, auto, auto, auto)
             {
                 static size_t count = 0;
                 size_t n = count;
@@ -181,6 +217,8 @@ protected:
                 this->nodes[meta.id].handler = handler;
             }));
 
+        EXPECT_CALL(*meta.node, register_disconnect_handler(_)).Times(AtLeast(0));
+
         EXPECT_CALL(*meta.node, send_message(ResultOf(is_status, Eq(true)), _)).Times(AtLeast(0))
             .WillRepeatedly(Invoke([this, meta](auto /*msg*/, auto callback)
             {
@@ -208,10 +246,10 @@ protected:
     }
 
     static bool
-    is_status(const std::string& msg)
+    is_status(const std::shared_ptr<const std::string>& msg)
     {
         bzn_envelope env;
-        return (env.ParseFromString(msg) && env.payload_case() == bzn_envelope::kStatusRequest);
+        return (env.ParseFromString(*msg) && env.payload_case() == bzn_envelope::kStatusRequest);
     }
 };
 
@@ -236,6 +274,7 @@ TEST_F(swarm_test, test_swarm_node_management)
     Json::Value status;
     std::stringstream(status_str) >> status;
     EXPECT_EQ(status["fastest_node"].asString(), "node_2");
+    EXPECT_EQ(status["next_fastest_node"].asString(), "node_1");
     EXPECT_EQ(status["primary_node"].asString(), this->primary_node);
     EXPECT_EQ(status["nodes"].size(), this->nodes.size());
 
@@ -252,6 +291,7 @@ TEST_F(swarm_test, test_swarm_node_management)
     Json::Value status2;
     std::stringstream(status_str) >> status2;
     EXPECT_EQ(status2["fastest_node"].asString(), "node_1");
+    EXPECT_EQ(status2["next_fastest_node"].asString(), "node_3");
     EXPECT_EQ(status2["primary_node"].asString(), this->primary_node);
     EXPECT_EQ(status2["nodes"].size(), this->nodes.size());
 
@@ -344,24 +384,294 @@ TEST_F(swarm_test, test_send_policy)
     the_swarm->send_request(*env, send_policy::fastest);
     EXPECT_EQ(called, 2u);
 
-    // broadcast - should go to both
+    // next fastest policy - should go through the other node
+    auto& meta4 = this->nodes[1];
+    EXPECT_CALL(*meta4.node, send_message(ResultOf(is_status, Eq(false)), _)).Times(Exactly(1))
+        .WillRepeatedly(Invoke([&meta4, respond](auto /*msg*/, auto callback)
+        {
+            callback(boost::system::error_code{});
+            respond(meta4);
+        })).RetiresOnSaturation();
+    the_swarm->send_request(*env, send_policy::next_fastest);
+    EXPECT_EQ(called, 3u);
+
+    // broadcast - should go to both, sharing a single serialized buffer
+    std::vector<const std::string*> broadcast_buffers;
     auto meta2 = this->nodes[0];
     EXPECT_CALL(*meta2.node, send_message(ResultOf(is_status, Eq(false)), _)).Times(Exactly(1))
-        .WillRepeatedly(Invoke([&meta2, respond](auto /*msg*/, auto callback)
+        .WillRepeatedly(Invoke([&meta2, &broadcast_buffers, respond](auto msg, auto callback)
         {
+            broadcast_buffers.push_back(msg.get());
             callback(boost::system::error_code{});
             respond(meta2);
         }));
     auto meta3 = this->nodes[1];
     EXPECT_CALL(*meta3.node, send_message(ResultOf(is_status, Eq(false)), _)).Times(Exactly(1))
-        .WillRepeatedly(Invoke([&meta3, respond](auto /*msg*/, auto callback)
+        .WillRepeatedly(Invoke([&meta3, &broadcast_buffers, respond](auto msg, auto callback)
         {
+            broadcast_buffers.push_back(msg.get());
             callback(boost::system::error_code{});
             respond(meta3);
         }));
     the_swarm->send_request(*env, send_policy::broadcast);
-    EXPECT_EQ(called, 4u);
+    EXPECT_EQ(called, 5u);
+    ASSERT_EQ(broadcast_buffers.size(), 2u);
+    EXPECT_EQ(broadcast_buffers[0], broadcast_buffers[1]);
+
+    for (auto& n : this->nodes)
+    {
+        EXPECT_TRUE(Mock::VerifyAndClearExpectations(n.second.node.get()));
+    }
+
+    this->teardown();
+}
+
+#ifdef __APPLE__
+TEST_F(swarm_test, DISABLED_test_traffic_latency)
+#else
+TEST_F(swarm_test, test_traffic_latency)
+#endif
+{
+    this->init(20, 2);
+
+    this->add_node(1, 40);
+    this->primary_node = "node_1";
+
+    std::promise<int> prom;
+    this->the_swarm->initialize([&prom](auto& /*ec*/){prom.set_value(1);});
+    prom.get_future().get();
+    boost::this_thread::sleep_for(boost::chrono::seconds(1));
+
+    Json::Value status;
+    std::stringstream(this->the_swarm->get_status()) >> status;
+    EXPECT_EQ(status["fastest_node"].asString(), "node_0");
+    EXPECT_EQ(status["next_fastest_node"].asString(), "node_1");
+
+    the_swarm->register_response_handler(bzn_envelope::PayloadCase::kDatabaseResponse, [](auto&, const auto&)
+    {
+        return false;
+    });
+
+    // node_0 answers status requests quickly, but is slow with real requests
+    auto& meta = this->nodes[0];
+    EXPECT_CALL(*meta.node, send_message(ResultOf(is_status, Eq(false)), _)).Times(Exactly(1))
+        .WillOnce(Invoke([](auto /*msg*/, auto callback)
+        {
+            callback(boost::system::error_code{});
+        }));
+
+    database_header header;
+    header.set_db_uuid("my_uuid");
+    header.set_nonce(1);
+    database_msg request;
+    *request.mutable_header() = header;
+    request.mutable_quick_read()->set_key("key");
+    bzn_envelope env;
+    env.set_database_msg(request.SerializeAsString());
+    the_swarm->send_request(env, send_policy::fastest);
+
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(400));
+
+    database_response response;
+    *response.mutable_header() = header;
+    bzn_envelope response_env;
+    response_env.set_database_response(response.SerializeAsString());
+    response_env.set_sender("node_0");
+    response_env.set_swarm_id(SWARM_ID);
+    EXPECT_EQ(meta.handler(response_env.SerializeAsString()), false);
+
+    // so node_1 takes over without waiting for the next status request
+    Json::Value status2;
+    std::stringstream(this->the_swarm->get_status()) >> status2;
+    EXPECT_EQ(status2["fastest_node"].asString(), "node_1");
+    EXPECT_EQ(status2["next_fastest_node"].asString(), "node_0");
+    for (const auto& n : status2["nodes"])
+    {
+        if (n["uuid"].asString() == "node_0")
+        {
+            EXPECT_GT(n["latency_avg"].asUInt64(), 50000u);
+            EXPECT_GE(n["latency_p99"].asUInt64(), 350000u);
+        }
+    }
+
+    for (auto& n : this->nodes)
+    {
+        EXPECT_TRUE(Mock::VerifyAndClearExpectations(n.second.node.get()));
+    }
+
+    this->teardown();
+}
+
+#ifdef __APPLE__
+TEST_F(swarm_test, DISABLED_test_back_off_per_node)
+#else
+TEST_F(swarm_test, test_back_off_per_node)
+#endif
+{
+    this->init(20, 2);
+
+    this->add_node(1, 40);
+    this->primary_node = "node_1";
+
+    std::promise<int> prom;
+    this->the_swarm->initialize([&prom](auto& /*ec*/){prom.set_value(1);});
+    prom.get_future().get();
+    boost::this_thread::sleep_for(boost::chrono::seconds(1));
+
+    // a request written to both nodes
+    for (auto& n : this->nodes)
+    {
+        EXPECT_CALL(*n.second.node, send_message(ResultOf(is_status, Eq(false)), _)).Times(Exactly(1));
+    }
+
+    database_msg request;
+    request.mutable_header()->set_nonce(7);
+    bzn_envelope request_env;
+    request_env.set_database_msg(request.SerializeAsString());
+    this->the_swarm->send_request(request_env, send_policy::broadcast);
+
+    // only the busy node backs off
+    EXPECT_CALL(*this->nodes[0].node, back_off(_, _)).Times(Exactly(0));
+    EXPECT_CALL(*this->nodes[1].node, back_off(true, 1)).Times(Exactly(1));
+
+    swarm_error err;
+    err.set_message(TOO_BUSY_ERROR_MSG);
+    err.set_data("7");
+    bzn_envelope busy_env;
+    busy_env.set_swarm_error(err.SerializeAsString());
+    busy_env.set_sender("node_1");
+    busy_env.set_swarm_id(SWARM_ID);
+    EXPECT_EQ(this->nodes[1].handler(busy_env.SerializeAsString()), false);
+
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(this->nodes[0].node.get()));
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(this->nodes[1].node.get()));
+
+    // and an answer from a healthy node doesn't speed up the busy one
+    EXPECT_CALL(*this->nodes[0].node, back_off(false, 1)).Times(Exactly(1));
+    EXPECT_CALL(*this->nodes[1].node, back_off(_, _)).Times(Exactly(0));
+
+    database_response response;
+    response.mutable_header()->set_nonce(7);
+    bzn_envelope env;
+    env.set_database_response(response.SerializeAsString());
+    env.set_sender("node_0");
+    env.set_swarm_id(SWARM_ID);
+    EXPECT_EQ(this->nodes[0].handler(env.SerializeAsString()), false);
+
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(this->nodes[0].node.get()));
+
+    // messages that don't answer anything written to the node, such as subscription updates, count for nothing
+    EXPECT_CALL(*this->nodes[0].node, back_off(_, _)).Times(Exactly(0));
+
+    response.mutable_subscription_update()->set_key("key");
+    env.set_database_response(response.SerializeAsString());
+    EXPECT_EQ(this->nodes[0].handler(env.SerializeAsString()), false);
+
+    response.mutable_header()->set_nonce(8);
+    env.set_database_response(response.SerializeAsString());
+    EXPECT_EQ(this->nodes[0].handler(env.SerializeAsString()), false);
+
+    for (auto& n : this->nodes)
+    {
+        EXPECT_TRUE(Mock::VerifyAndClearExpectations(n.second.node.get()));
+    }
+
+    // a request resent to a node is answered once, and that answer frees everything it took
+    for (auto& n : this->nodes)
+    {
+        EXPECT_CALL(*n.second.node, send_message(ResultOf(is_status, Eq(false)), _)).Times(Exactly(2));
+    }
+
+    request.mutable_header()->set_nonce(9);
+    request_env.set_database_msg(request.SerializeAsString());
+    this->the_swarm->send_request(request_env, send_policy::broadcast);
+    this->the_swarm->send_request(request_env, send_policy::broadcast);
+
+    EXPECT_CALL(*this->nodes[0].node, back_off(false, 2)).Times(Exactly(1));
+    response.clear_subscription_update();
+    response.mutable_header()->set_nonce(9);
+    env.set_database_response(response.SerializeAsString());
+    EXPECT_EQ(this->nodes[0].handler(env.SerializeAsString()), false);
+    EXPECT_EQ(this->nodes[0].handler(env.SerializeAsString()), false);
+
+    for (auto& n : this->nodes)
+    {
+        EXPECT_TRUE(Mock::VerifyAndClearExpectations(n.second.node.get()));
+    }
+
+    this->teardown();
+}
+
+TEST_F(swarm_test, test_known_contacts)
+{
+    // the node takes a while to send status
+    this->init(200, 1);
+    this->primary_node = "node_0";
+    std::static_pointer_cast<swarm>(this->the_swarm)->set_known_contacts("node_0", "node_0");
+
+    // but a swarm that remembers its primary doesn't need to wait for it
+    bool initialized = false;
+    this->the_swarm->initialize([&initialized](auto& ec)
+    {
+        EXPECT_FALSE(ec);
+        initialized = true;
+    });
+
+    EXPECT_TRUE(initialized);
+    EXPECT_EQ(this->the_swarm->get_point_of_contact(send_policy::normal), "node_0");
+    EXPECT_EQ(this->the_swarm->get_point_of_contact(send_policy::fastest), "node_0");
+
+    // let the status response arrive before tearing down
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+    for (auto& n : this->nodes)
+    {
+        EXPECT_TRUE(Mock::VerifyAndClearExpectations(n.second.node.get()));
+    }
+
+    this->teardown();
+}
+
+TEST_F(swarm_test, test_measure_latency)
+{
+    this->init(100, 4);
+    this->add_node(1, 50);
+    this->add_node(2, 150);
+    this->add_node(3, 300);
+    this->primary_node = "node_1";
+
+    // measuring starts the swarm, and waits for a quorum (three of four nodes) to answer
+    std::promise<std::chrono::microseconds> latency;
+    this->the_swarm->measure_latency([&latency](auto measured)
+    {
+        latency.set_value(measured);
+    });
+
+    auto measured = latency.get_future().get();
+    EXPECT_GE(measured, std::chrono::milliseconds(150));
+    EXPECT_LT(measured, std::chrono::milliseconds(300));
 
+    // the swarm has been started, so opening a database in it needn't wait, and can be done more than once
+    size_t initialized = 0;
+    for (size_t i = 0; i < 2; i++)
+    {
+        this->the_swarm->initialize([&initialized](auto& ec)
+        {
+            EXPECT_FALSE(ec);
+            initialized++;
+        });
+    }
+    EXPECT_EQ(initialized, 2u);
+
+    // a later measurement is answered at once
+    bool answered = false;
+    this->the_swarm->measure_latency([&answered](auto measured)
+    {
+        EXPECT_GT(measured.count(), 0);
+        answered = true;
+    });
+    EXPECT_TRUE(answered);
+
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
     for (auto& n : this->nodes)
     {
         EXPECT_TRUE(Mock::VerifyAndClearExpectations(n.second.node.get()));
@@ -397,3 +707,85 @@ TEST_F(swarm_test, test_bad_status)
 
     this->teardown();
 }
+
+TEST_F(swarm_test, test_verifier_preserves_node_order)
+{
+    auto node = std::make_shared<mock_node>();
+    node_message_handler handler;
+    EXPECT_CALL(*node, register_message_handler(_)).WillOnce(SaveArg<0>(&handler));
+    EXPECT_CALL(*node, register_disconnect_handler(_));
+    EXPECT_CALL(*node, back_off(_, _)).Times(AtLeast(0));
+    EXPECT_CALL(*node_factory, create_node(_, _, _, _, _)).WillOnce(Return(node));
+    EXPECT_CALL(*mock_io_context, make_unique_steady_timer()).WillOnce(Invoke([]()
+    {
+        return std::make_unique<bzn::asio::mock_steady_timer_base>();
+    }));
+
+    // hold on to verified results so we can deliver them out of order
+    std::mutex posted_mutex;
+    std::vector<bzn::asio::task> posted;
+    EXPECT_CALL(*mock_io_context, make_unique_strand()).WillOnce(Invoke([&]()
+    {
+        auto strand = std::make_unique<bzn::asio::mock_strand_base>();
+        EXPECT_CALL(*strand, post(_)).WillRepeatedly(Invoke([&](auto task)
+        {
+            std::lock_guard<std::mutex> lock(posted_mutex);
+            posted.push_back(task);
+        }));
+        return strand;
+    }));
+
+    auto pool = std::make_shared<verifier>(std::make_shared<slow_crypto>(), 2);
+    std::vector<std::pair<node_id_t, bzn::peer_address_t>> node_list{std::make_pair<node_id_t, bzn::peer_address_t>
+        ("node_0", {"127.0.0.1", 0, 0, "", ""})};
+    the_swarm = std::make_shared<swarm>(node_factory, ws_factory, mock_io_context, crypto
+        , SWARM_ID, "my_uuid", node_list, pool);
+    the_swarm->honest_majority_size();
+    ASSERT_NE(handler, nullptr);
+
+    std::vector<std::string> received;
+    the_swarm->register_response_handler(bzn_envelope::PayloadCase::kDatabaseResponse,
+        [&received](auto&, const bzn_envelope& env)
+        {
+            received.push_back(env.database_response());
+            return false;
+        });
+
+    auto send = [&handler](const std::string& payload, const std::string& signature)
+    {
+        bzn_envelope env;
+        env.set_database_response(payload);
+        env.set_signature(signature);
+        EXPECT_FALSE(handler(env.SerializeAsString()));
+    };
+
+    send("first", "slow");
+    send("second", "");
+    send("third", "bad");
+    send("fourth", "good");
+
+    // wait for the three signed messages to be verified
+    for (int i = 0; i < 100; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lock(posted_mutex);
+            if (posted.size() == 3)
+            {
+                break;
+            }
+        }
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+    }
+    pool->stop();
+    ASSERT_EQ(posted.size(), 3u);
+    EXPECT_TRUE(received.empty());
+
+    for (auto it = posted.rbegin(); it != posted.rend(); it++)
+    {
+        (*it)();
+    }
+
+    EXPECT_EQ(received, (std::vector<std::string>{"first", "second", "fourth"}));
+
+    this->teardown();
+}
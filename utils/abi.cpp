@@ -0,0 +1,252 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <utils/abi.hpp>
+#include <array>
+#include <stdexcept>
+
+
+namespace
+{
+    const size_t WORD_SIZE{32};
+    const size_t WORD_DIGITS{WORD_SIZE * 2};
+
+    const char HEX_DIGITS[] = "0123456789abcdef";
+
+    // value of each character as a hex digit, or -1
+    constexpr std::array<int8_t, 256>
+    make_hex_values()
+    {
+        std::array<int8_t, 256> values{};
+        for (size_t c = 0; c < values.size(); c++)
+        {
+            values[c] = -1;
+        }
+
+        for (int8_t v = 0; v < 10; v++)
+        {
+            values['0' + v] = v;
+        }
+
+        for (int8_t v = 0; v < 6; v++)
+        {
+            values['a' + v] = static_cast<int8_t>(10 + v);
+            values['A' + v] = static_cast<int8_t>(10 + v);
+        }
+
+        return values;
+    }
+
+    constexpr std::array<int8_t, 256> HEX_VALUES = make_hex_values();
+
+    int
+    hex_value(char c)
+    {
+        auto value = HEX_VALUES[static_cast<unsigned char>(c)];
+        if (value < 0)
+        {
+            throw std::runtime_error("invalid hex digit in ABI data");
+        }
+
+        return value;
+    }
+
+    size_t
+    padded_size(size_t size)
+    {
+        return (size + WORD_SIZE - 1) / WORD_SIZE * WORD_SIZE;
+    }
+}
+
+
+namespace bzn::utils::abi
+{
+    void
+    append_hex(std::string& out, std::string_view bytes)
+    {
+        auto pos = out.size();
+        out.resize(pos + bytes.size() * 2);
+        for (unsigned char c : bytes)
+        {
+            out[pos++] = HEX_DIGITS[c >> 4];
+            out[pos++] = HEX_DIGITS[c & 0xf];
+        }
+    }
+
+
+    std::string
+    from_hex(std::string_view hex)
+    {
+        if (hex.size() % 2)
+        {
+            throw std::runtime_error("odd number of hex digits in ABI data");
+        }
+
+        std::string bytes(hex.size() / 2, '\0');
+        for (size_t i = 0; i < bytes.size(); i++)
+        {
+            bytes[i] = static_cast<char>(hex_value(hex[2 * i]) << 4 | hex_value(hex[2 * i + 1]));
+        }
+
+        return bytes;
+    }
+
+
+    std::string
+    encode_uint(uint64_t value)
+    {
+        std::string word(WORD_DIGITS, '0');
+        for (auto it = word.rbegin(); value; ++it, value >>= 4)
+        {
+            *it = HEX_DIGITS[value & 0xf];
+        }
+
+        return word;
+    }
+
+
+    std::string
+    encode_call(std::string_view selector, const std::vector<std::string_view>& args)
+    {
+        std::string head{"0x"};
+        head.append(selector);
+
+        std::string tail;
+        size_t offset = args.size() * WORD_SIZE;
+        for (const auto& arg : args)
+        {
+            head.append(encode_uint(offset));
+            tail.append(encode_uint(arg.size()));
+            append_hex(tail, arg);
+            tail.append((padded_size(arg.size()) - arg.size()) * 2, '0');
+            offset += WORD_SIZE + padded_size(arg.size());
+        }
+
+        return head + tail;
+    }
+
+
+    decoder::decoder(std::string_view hex)
+        : data(hex.substr(0, 2) == "0x" ? hex.substr(2) : hex)
+    {
+        if (this->data.size() % WORD_DIGITS)
+        {
+            throw std::runtime_error("ABI data is not a whole number of words");
+        }
+    }
+
+
+    size_t
+    decoder::size() const
+    {
+        return this->data.size() / WORD_DIGITS;
+    }
+
+
+    std::string_view
+    decoder::get_word(size_t word) const
+    {
+        if (word >= this->size())
+        {
+            throw std::out_of_range("ABI data too short");
+        }
+
+        return this->data.substr(word * WORD_DIGITS, WORD_DIGITS);
+    }
+
+
+    uint64_t
+    decoder::get_uint(size_t word) const
+    {
+        auto digits = this->get_word(word);
+
+        // only the low 64 bits may be set
+        const size_t high_digits = WORD_DIGITS - sizeof(uint64_t) * 2;
+        if (digits.substr(0, high_digits).find_first_not_of('0') != std::string_view::npos)
+        {
+            throw std::out_of_range("ABI value too large");
+        }
+
+        uint64_t value = 0;
+        for (auto c : digits.substr(high_digits))
+        {
+            value = value << 4 | hex_value(c);
+        }
+
+        return value;
+    }
+
+
+    size_t
+    decoder::get_offset(size_t word) const
+    {
+        // offsets are in bytes, and always to the start of a word
+        auto offset = this->get_uint(word);
+        if (offset % WORD_SIZE || offset / WORD_SIZE >= this->size())
+        {
+            throw std::out_of_range("ABI offset outside the data");
+        }
+
+        return offset;
+    }
+
+
+    std::string
+    decoder::get_string(size_t offset) const
+    {
+        if (offset % WORD_SIZE)
+        {
+            throw std::out_of_range("ABI offset outside the data");
+        }
+
+        const size_t word = offset / WORD_SIZE;
+        const auto length = this->get_uint(word);
+        if (length > (this->size() - word - 1) * WORD_SIZE)
+        {
+            throw std::out_of_range("ABI string runs past the end of the data");
+        }
+
+        return from_hex(this->data.substr((word + 1) * WORD_DIGITS, length * 2));
+    }
+
+
+    std::vector<std::string>
+    decoder::get_string_array(size_t offset) const
+    {
+        if (offset % WORD_SIZE)
+        {
+            throw std::out_of_range("ABI offset outside the data");
+        }
+
+        // the length is followed by the offset of each string, counted from just after the length
+        const size_t word = offset / WORD_SIZE;
+        const auto count = this->get_uint(word);
+        if (count >= this->size() - word)
+        {
+            throw std::out_of_range("ABI array runs past the end of the data");
+        }
+
+        std::vector<std::string> strings;
+        strings.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            strings.push_back(this->get_string(offset + WORD_SIZE + this->get_offset(word + 1 + i)));
+        }
+
+        return strings;
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace bzn::utils::abi
+{
+    // hex digits of bytes, appended to out
+    void append_hex(std::string& out, std::string_view bytes);
+
+    // bytes from hex digits; throws on an odd length or a character that isn't a hex digit
+    std::string from_hex(std::string_view hex);
+
+    // a 32 byte word holding the value, as 64 hex digits
+    std::string encode_uint(uint64_t value);
+
+    // call data for a function taking only string arguments: the selector, an offset for each
+    // argument, then each argument's length and padded bytes
+    std::string encode_call(std::string_view selector, const std::vector<std::string_view>& args);
+
+    // reads values out of the hex form of a contract call's result. throws if a value lies outside
+    // the data or doesn't fit in the type asked for
+    class decoder
+    {
+    public:
+        // the leading 0x is optional
+        explicit decoder(std::string_view hex);
+
+        // number of 32 byte words in the data
+        size_t size() const;
+
+        uint64_t get_uint(size_t word) const;
+
+        // a string whose length is in the word at the given byte offset
+        std::string get_string(size_t offset) const;
+
+        // an array of strings whose length is in the word at the given byte offset
+        std::vector<std::string> get_string_array(size_t offset) const;
+
+    private:
+        std::string_view data;
+
+        std::string_view get_word(size_t word) const;
+        size_t get_offset(size_t word) const;
+    };
+}
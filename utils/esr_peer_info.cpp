@@ -16,13 +16,10 @@
 
 #include <utils/http_req.hpp>
 #include <utils/esr_peer_info.hpp>
-#include <boost/algorithm/hex.hpp>
-#include <boost/algorithm/string.hpp>
+#include <utils/abi.hpp>
 #include <json/json.h>
-#include <iostream>
-#include <sstream>
-#include <cassert>
-#include <sstream>
+#include <algorithm>
+#include <limits>
 
 using json_message = Json::Value;
 
@@ -114,19 +111,14 @@ namespace
         }
     )"};
 
-    const size_t ESR_RESPONSE_LINE_LENGTH{64};
-    const size_t REQUIRED_SIZE_MULTIPLE{64};
-    const off_t PARAMETER_OFFSET{64};
-    const std::string GET_SWARMS_ADDRESS{"0043d7e7"};
-    const std::string GET_PEERS_ADDRESS{"46e76d8b"}; // TODO: refactor to put the 0x back
-    const std::string GET_PEER_INFO_SIGNATURE{"0xcc8575cb"};
+    const std::string GET_SWARMS_SELECTOR{"0043d7e7"};
+    const std::string GET_PEERS_SELECTOR{"46e76d8b"};
+    const std::string GET_PEER_INFO_SELECTOR{"cc8575cb"};
 
-    void
-    trim_right_nulls(std::string& s)
-    {
-        boost::algorithm::trim_right_if(s, [](auto& c)
-        { return c == '\0'; });
-    }
+    // getNodeInfo's result is laid out as (nodeCount, nodeHost, nodeName, nodePort)
+    const size_t PEER_INFO_HOST_OFFSET_WORD{1};
+    const size_t PEER_INFO_NAME_OFFSET_WORD{2};
+    const size_t PEER_INFO_PORT_WORD{3};
 
 
     json_message
@@ -134,7 +126,7 @@ namespace
     {
         json_message json_msg;
         Json::CharReaderBuilder builder;
-        Json::CharReader* reader = builder.newCharReader();
+        std::unique_ptr<Json::CharReader> reader{builder.newCharReader()};
         std::string errors;
         if (!reader->parse(
             json_str.c_str()
@@ -175,335 +167,112 @@ namespace
     }
 
 
-    std::string
-    hex_to_char_string(const std::string& hex)
+    // the result of an eth_call, as hex
+    std::string_view
+    get_result(const json_message& json_response)
     {
-        std::stringstream strm;
-        boost::algorithm::unhex(hex, std::ostream_iterator<char>{strm, ""});
-        return strm.str();
+        const auto& result = json_response["result"];
+        if (!result.isString())
+        {
+            throw std::runtime_error("ESR response has no result");
+        }
+
+        return result.asCString();
     }
+}
 
 
-    // TODO: replace this with a function that uses the ABI to parse the response
+namespace bzn::utils::esr
+{
     std::vector<std::string>
-    parse_get_peers_result_to_vector(const std::string_view& result)
+    get_swarm_ids(const std::string& esr_address, const std::string& url)
     {
-        std::vector<std::string> results;
-        std::vector<std::string> lines;
-        size_t node_count{0};
-        enum states
-        {
-            HEADER, HEADER_SWARM_SIZE, HEADER_INFO, PEER_ID_SIZE, PEER_ID
-        } state{HEADER};
-
-        // NOTE: I needed to add the extra null character to "line" so that any 64 length buffer read from the result
-        // will be correctly null terminated for the boost::algorithm::unhex function
-        char line[ESR_RESPONSE_LINE_LENGTH + 1]{0};
-        size_t index{0};
-        std::string peer_id;
-
-        std::istringstream stm(result.begin());
-
-        size_t peer_id_length{0};
-        while (stm.read(line, ESR_RESPONSE_LINE_LENGTH))
-        {
-            switch (state)
-            {
-            case HEADER:
-            {
-                state = HEADER_SWARM_SIZE;
-            }
-                break;
-            case HEADER_SWARM_SIZE:
-            {
-                state = HEADER_INFO;
-                node_count = std::strtoul(line, nullptr, 16);
-                if (node_count == 0)
-                {
-                    LOG(error) << "Requested swarm may not exist or has no nodes";
-                    return results;
-                }
-            }
-                break;
-            case HEADER_INFO:
-            {
-                state = (index == node_count + 1 ? PEER_ID_SIZE : state);
-            }
-            break;
-            case PEER_ID_SIZE:
-            {
-                // the first line of data is the size of the string
-                peer_id_length = std::strtoul(line, nullptr, 16);
-                if (peer_id_length)
-                {
-                    state = PEER_ID;
-                }
-                else
-                {
-                    --node_count;
-                    state = PEER_ID_SIZE;
-                }
-            }
-            break;
-            case PEER_ID:
-            {
-                peer_id.append(hex_to_char_string(std::string{line}));
-                if (peer_id.size() >= peer_id_length)
-                {
-                    trim_right_nulls(peer_id);
-                    results.emplace_back(peer_id);
-                    peer_id = "";
-                    state = PEER_ID_SIZE;
-                }
-            }
-                break;
-            default:
-            {
-                LOG(warning) << "Failed to correctly parse peer peers from esr";
-                return results;
-            }
-                break;
-            }
-            ++index;
-        }
-
-        // TODO: rhn - reconsider if we need to keep node_count and this check.
-        if (results.size() != node_count)
-        {
-            LOG(warning) << "Actual size of the peers list [" << results.size() << "] does not agree with the expected size [" << node_count << "]";
-        }
+        return parse_ids_response(bzn::utils::http::sync_req(url, make_swarm_ids_request(esr_address)));
+    }
 
-        return results;
+    std::vector<std::string>
+    get_peer_ids(const bzapi::uuid_t& swarm_id, const std::string& esr_address, const std::string& url)
+    {
+        return parse_ids_response(bzn::utils::http::sync_req(url, make_peer_ids_request(swarm_id, esr_address)));
     }
 
 
-    // TODO: replace this with a function that uses the ABI to parse the response
     bzn::peer_address_t
-    parse_get_peer_info_result_to_peer_address(const std::string& peer_id, const std::string_view& result)
+    get_peer_info(const bzapi::uuid_t& swarm_id, const std::string& peer_id, const std::string& esr_address, const std::string& url)
     {
-        size_t      text_size{0};
-        uint16_t    port{0};
-        std::string host;
-        std::string name;
-        enum {NODE_COUNT, NA_0, NA_1, NODE_PORT, NODE_HOST_SIZE, NODE_HOST, NODE_NAME_SIZE, NODE_NAME, FINISHED} state {NODE_COUNT};
-
-        // NOTE: I needed to add the extra null character to "line" so that any 64 length buffer read from the result
-        // will be correctly null terminated for the boost::algorithm::unhex function
-        char line[ESR_RESPONSE_LINE_LENGTH + 1]{0};
-        std::istringstream stream{result.begin()};
-        while (stream.read(line, ESR_RESPONSE_LINE_LENGTH))
-        {
-            switch (state)
-            {
-                case NODE_COUNT:
-                {
-                    state = NA_0;
-                }
-                break;
-
-                case NA_0:
-                {
-                    state = NA_1;
-                }
-                break;
-
-                case NA_1:
-                {
-                    state = NODE_PORT;
-                }
-                break;
-
-                case NODE_PORT:
-                {
-                    port = std::strtoul(line, nullptr, 16);
-                    if (!port)
-                    {
-                        LOG(warning) << "Invalid value for port:[" << port << "], node may not exist";
-                    }
-                    state = NODE_HOST_SIZE;
-                }
-                break;
-
-                case NODE_HOST_SIZE:
-                {
-                    text_size = std::strtoul(line, nullptr, 16);
-                    if (!text_size)
-                    {
-                        LOG(warning) << "Invalid value for host string length:[" << text_size << "]";
-                    }
-                    state = NODE_HOST;
-                }
-                break;
-
-                case NODE_HOST:
-                {
-                    host = hex_to_char_string(line);
-                    trim_right_nulls(host);
-                    if (text_size != host.size())
-                    {
-                        LOG(warning) << "Parsed host string size does not match expected size";
-                    }
-                    state = NODE_NAME_SIZE;
-                }
-                break;
-
-                case NODE_NAME_SIZE:
-                {
-                    text_size = std::strtoul(line, nullptr, 16);
-                    if (!text_size)
-                    {
-                        LOG(warning) << "Invalid value for node name string length:[" << text_size << "]";
-                    }
-                    state = NODE_NAME;
-                    name.clear();
-                }
-                break;
-
-                case NODE_NAME:
-                {
-                    name.append(hex_to_char_string(line));
-                    trim_right_nulls(name);
-                    if (text_size == name.size())
-                    {
-                        state = FINISHED;
-                    }
-                }
-                break;
-
-                case FINISHED:
-                {
-                    LOG(warning) << "Peer Info result contains too many lines";
-                }
-                break;
-
-                default:
-                {
-                    LOG(error) << "Failed to correctly parse peer info from esr";
-                    return bzn::peer_address_t(host, port, 0, name, peer_id);
-                }
-                break;
-            }
-        }
-        return bzn::peer_address_t(host, port, 0, name, peer_id);
+        return parse_peer_info_response(peer_id
+            , bzn::utils::http::sync_req(url, make_peer_info_request(swarm_id, peer_id, esr_address)));
     }
 
 
     std::string
-    pad_str_to_mod_64(std::string parameter)
+    make_swarm_ids_request(const std::string& esr_address)
     {
-        const size_t REMAINDER{parameter.size() % REQUIRED_SIZE_MULTIPLE};
-        if (REMAINDER)
-        {
-            const size_t padding_required = REQUIRED_SIZE_MULTIPLE - REMAINDER;
-            parameter.insert(parameter.size(), padding_required, '0');
-        }
-        return parameter;
+        return make_request(esr_address, bzn::utils::abi::encode_call(GET_SWARMS_SELECTOR, {}));
     }
 
 
     std::string
-    size_type_to_hex(size_t i, size_t width = 8)
+    make_peer_ids_request(const bzapi::uuid_t& swarm_id, const std::string& esr_address)
     {
-        std::stringbuf buf;
-        std::ostream os(&buf);
-        os << std::setfill('0') << std::setw(width) << std::hex << (int) i;
-        return buf.str().c_str();
+        return make_request(esr_address, bzn::utils::abi::encode_call(GET_PEERS_SELECTOR, {swarm_id}));
     }
 
 
     std::string
-    string_to_hex(const std::string& value)
+    make_peer_info_request(const bzapi::uuid_t& swarm_id, const std::string& peer_id, const std::string& esr_address)
     {
-        std::stringstream hexstream;
-        boost::algorithm::hex(value, std::ostream_iterator<char>{hexstream, ""});
-        return hexstream.str();
+        return make_request(esr_address, bzn::utils::abi::encode_call(GET_PEER_INFO_SELECTOR, {swarm_id, peer_id}));
     }
 
 
-    // TODO: replace this with a function that uses the ABI to create the request data
-    const std::string
-    data_string_for_get_swarms()
-    {
-        return std::string{"0x"
-            + pad_str_to_mod_64(GET_SWARMS_ADDRESS)};
-    }
-
-    // TODO: replace this with a function that uses the ABI to create the request data
-    const std::string
-    data_string_for_get_peers(const std::string& swarm_id)
+    std::vector<std::string>
+    parse_ids_response(const std::string& response)
     {
-        return std::string{"0x"
-            + pad_str_to_mod_64(GET_PEERS_ADDRESS)
-            + pad_str_to_mod_64("00000020")             // input parameter type? (no)
-            + size_type_to_hex(swarm_id.size())         // size of the swarm id (pre hexification)
-            + pad_str_to_mod_64(string_to_hex(swarm_id))// hexified swarm id
-        };
+        return parse_ids_result(get_result(str_to_json(response)));
     }
-}
 
 
-namespace bzn::utils::esr
-{
-    // TODO: replace this with a function that uses the ABI to create the request data
-    const std::string
-    data_string_for_get_peer_info(const std::string& swarm_id, const std::string& peer_id)
+    bzn::peer_address_t
+    parse_peer_info_response(const std::string& peer_id, const std::string& response)
     {
-
-        const std::string SWARM_ID_PARAMETER {
-            size_type_to_hex(swarm_id.size(), 64)           // size of variable parameter
-            + pad_str_to_mod_64(string_to_hex(swarm_id))    // swarm id parameter
-        };
-
-        const std::string PEER_ID_PARAMETER {
-            size_type_to_hex(peer_id.size(), 64)
-            + pad_str_to_mod_64(string_to_hex(peer_id))
-        };
-
-        const std::string PREAMBLE {
-            GET_PEER_INFO_SIGNATURE
-            + size_type_to_hex( PARAMETER_OFFSET, 64)
-            + size_type_to_hex( PARAMETER_OFFSET + SWARM_ID_PARAMETER.size() / 2, 64)
-        };
-
-        return std::string{
-                PREAMBLE
-                + SWARM_ID_PARAMETER
-                + PEER_ID_PARAMETER
-        };
+        return parse_peer_info_result(peer_id, get_result(str_to_json(response)));
     }
 
 
     std::vector<std::string>
-    get_swarm_ids(const std::string& esr_address, const std::string& url)
+    parse_ids_result(std::string_view result)
     {
-        const auto DATA{data_string_for_get_swarms()};
-        const auto REQUEST{make_request( esr_address, DATA)};
-        const auto response{bzn::utils::http::sync_req(url, REQUEST)};
-        const auto json_response{str_to_json(response)};
-        const auto result{json_response["result"].asCString() + 2}; // + 2 skips the '0x'
-        return parse_get_peers_result_to_vector(result);
-    }
+        bzn::utils::abi::decoder decoder(result);
+        if (!decoder.size())
+        {
+            LOG(error) << "Requested swarm may not exist or has no nodes";
+            return {};
+        }
 
-    std::vector<std::string>
-    get_peer_ids(const bzapi::uuid_t& swarm_id, const std::string& esr_address, const std::string& url)
-    {
-        const auto DATA{data_string_for_get_peers(swarm_id)};
-        const auto REQUEST{make_request( esr_address, DATA)};
-        const auto response{bzn::utils::http::sync_req(url, REQUEST)};
-        const auto json_response{str_to_json(response)};
-        const auto result{json_response["result"].asCString() + 2}; // + 2 skips the '0x'
-        return parse_get_peers_result_to_vector(result);
+        auto ids = decoder.get_string_array(decoder.get_uint(0));
+        if (ids.empty())
+        {
+            LOG(error) << "Requested swarm may not exist or has no nodes";
+        }
+
+        // removed entries are left as empty strings
+        ids.erase(std::remove(ids.begin(), ids.end(), std::string{}), ids.end());
+        return ids;
     }
 
 
     bzn::peer_address_t
-    get_peer_info(const bzapi::uuid_t& swarm_id, const std::string& peer_id, const std::string& esr_address, const std::string& url)
+    parse_peer_info_result(const std::string& peer_id, std::string_view result)
     {
-        const auto DATA{data_string_for_get_peer_info(swarm_id, peer_id)};
-        const auto REQUEST{make_request( esr_address, DATA)};
-        const auto response{bzn::utils::http::sync_req(url, REQUEST)};
-        const auto json_response{str_to_json(response)};
-        const auto result{json_response["result"].asCString() + 2};
-        return parse_get_peer_info_result_to_peer_address(peer_id, result);
+        bzn::utils::abi::decoder decoder(result);
+        const auto port = decoder.get_uint(PEER_INFO_PORT_WORD);
+        if (!port || port > std::numeric_limits<uint16_t>::max())
+        {
+            LOG(warning) << "Invalid value for port:[" << port << "], node may not exist";
+        }
+
+        return bzn::peer_address_t(decoder.get_string(decoder.get_uint(PEER_INFO_HOST_OFFSET_WORD))
+            , static_cast<uint16_t>(port), 0, decoder.get_string(decoder.get_uint(PEER_INFO_NAME_OFFSET_WORD)), peer_id);
     }
 }
@@ -26,4 +26,15 @@ namespace bzn::utils::esr
     std::vector<std::string> get_swarm_ids(const std::string& esr_address, const std::string& url);
     std::vector<std::string> get_peer_ids(const bzapi::uuid_t& swarm_id, const std::string& esr_address, const std::string& url);
     bzn::peer_address_t get_peer_info(const bzapi::uuid_t& swarm_id, const std::string& peer_id, const std::string& esr_address, const std::string& url);
+
+    // request bodies and response parsers for the calls above, for callers making the http requests themselves
+    std::string make_swarm_ids_request(const std::string& esr_address);
+    std::string make_peer_ids_request(const bzapi::uuid_t& swarm_id, const std::string& esr_address);
+    std::string make_peer_info_request(const bzapi::uuid_t& swarm_id, const std::string& peer_id, const std::string& esr_address);
+    std::vector<std::string> parse_ids_response(const std::string& response);
+    bzn::peer_address_t parse_peer_info_response(const std::string& peer_id, const std::string& response);
+
+    // decode the hex result of each call, taken from its response
+    std::vector<std::string> parse_ids_result(std::string_view result);
+    bzn::peer_address_t parse_peer_info_result(const std::string& peer_id, std::string_view result);
 }
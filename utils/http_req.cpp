@@ -15,6 +15,7 @@
 //
 
 #include <include/bluzelle.hpp>
+#include <utils/http_req.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/ssl.hpp>
@@ -40,21 +41,21 @@ namespace
         "/etc/openssl/certs",           // NetBSD
         "/var/ssl/certs",               // AIX
     };
-}
 
+    // covers connecting as well as each request made on the connection
+    const std::chrono::seconds HTTP_TIMEOUT{30};
 
-namespace bzn::utils::http
-{
-    // Performs an HTTP GET or POST and returns the body of the HTTP response...
-    std::string sync_req(const std::string& url, const std::string& post)
+    struct url_parts
     {
-        using tcp = boost::asio::ip::tcp;
-        namespace ssl = boost::asio::ssl;
-        namespace http = boost::beast::http;
-
-        boost::asio::io_context ioc;
-        tcp::resolver resolver{ioc};
+        std::string host;
+        std::string port;
+        std::string path;
+        bool secure;
+    };
 
+    url_parts
+    parse_url(const std::string& url)
+    {
         std::smatch what;
         if (!std::regex_match(url, what, URL_REGEX))
         {
@@ -63,19 +64,52 @@ namespace bzn::utils::http
         }
 
         const std::string protocol{what[1]};
-        const std::string host{what[2]};
-        const std::string path{what[4]};
         std::string port{what[3]};
 
-        // secure connection?
-        const bool secure = (protocol == "https");
-
         // if no port is specified then default to 80 or 443...
         if (port.empty())
         {
             port = protocol;
         }
 
+        return url_parts{what[2], port, what[4], protocol == "https"};
+    }
+
+    void
+    set_verify_paths(boost::asio::ssl::context& ctx)
+    {
+        // set default paths for finding CA certificates...
+        ctx.set_default_verify_paths();
+
+        // other possible locations...
+        for(const auto& cert_path : CERT_DIRS)
+        {
+            ctx.add_verify_path(cert_path);
+        }
+    }
+}
+
+
+namespace bzn::utils::http
+{
+    // Performs an HTTP GET or POST and returns the body of the HTTP response...
+    std::string sync_req(const std::string& url, const std::string& post)
+    {
+        using tcp = boost::asio::ip::tcp;
+        namespace ssl = boost::asio::ssl;
+        namespace http = boost::beast::http;
+
+        boost::asio::io_context ioc;
+        tcp::resolver resolver{ioc};
+
+        const auto parts = parse_url(url);
+        const std::string& host = parts.host;
+        const std::string& path = parts.path;
+        const std::string& port = parts.port;
+
+        // secure connection?
+        const bool secure = parts.secure;
+
         auto const endpoint_iterator = resolver.resolve(host, port);
 
         LOG(info) << "Connecting to: " << host << "...";
@@ -98,14 +132,7 @@ namespace bzn::utils::http
 
         if (secure)
         {
-            // set default paths for finding CA certificates...
-            ctx.set_default_verify_paths();
-
-            // other possible locations...
-            for(const auto& cert_path : CERT_DIRS)
-            {
-                ctx.add_verify_path(cert_path);
-            }
+            set_verify_paths(ctx);
 
             // Set SNI Hostname (many hosts need this to handshake successfully)
             if (!SSL_set_tlsext_host_name(ssl_stream.native_handle(), host.c_str()))
@@ -146,4 +173,317 @@ namespace bzn::utils::http
         return res.body();
     }
 
+
+    struct client::connection
+    {
+        connection(boost::asio::io_context& ioc, boost::asio::ssl::context& ctx, bool secure)
+            : resolver(ioc)
+        {
+            if (secure)
+            {
+                this->tls = std::make_unique<boost::beast::ssl_stream<boost::beast::tcp_stream>>(ioc, ctx);
+            }
+            else
+            {
+                this->tcp = std::make_unique<boost::beast::tcp_stream>(ioc);
+            }
+        }
+
+        boost::beast::tcp_stream&
+        lowest_layer()
+        {
+            return this->tls ? boost::beast::get_lowest_layer(*this->tls) : *this->tcp;
+        }
+
+        template <typename F>
+        void
+        with_stream(F&& f)
+        {
+            if (this->tls)
+            {
+                f(*this->tls);
+            }
+            else
+            {
+                f(*this->tcp);
+            }
+        }
+
+        boost::asio::ip::tcp::resolver resolver;
+        std::unique_ptr<boost::beast::tcp_stream> tcp;
+        std::unique_ptr<boost::beast::ssl_stream<boost::beast::tcp_stream>> tls;
+        boost::beast::flat_buffer buffer;
+        boost::beast::http::request<boost::beast::http::string_body> req;
+        boost::beast::http::response<boost::beast::http::string_body> res;
+        bool open = false;
+        size_t uses = 0;
+    };
+
+
+    client::client(std::shared_ptr<bzn::asio::io_context_base> io_context, const std::string& url, size_t max_connections)
+        : io_context(std::move(io_context)), ctx(boost::asio::ssl::context::sslv23_client)
+        , max_connections(std::max<size_t>(max_connections, 1))
+    {
+        auto parts = parse_url(url);
+        this->host = parts.host;
+        this->port = parts.port;
+        this->path = parts.path.empty() ? "/" : parts.path;
+        this->secure = parts.secure;
+
+        if (this->secure)
+        {
+            set_verify_paths(this->ctx);
+        }
+    }
+
+
+    void
+    client::async_req(const std::string& post, response_handler handler)
+    {
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->requests.push_back(request{post, std::move(handler)});
+        }
+
+        this->dispatch();
+    }
+
+
+    void
+    client::dispatch()
+    {
+        // hand queued requests to idle connections, opening new ones up to the limit
+        std::vector<std::pair<std::shared_ptr<connection>, std::shared_ptr<request>>> ready;
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            while (!this->requests.empty())
+            {
+                std::shared_ptr<connection> conn;
+                if (!this->idle.empty())
+                {
+                    conn = this->idle.back();
+                    this->idle.pop_back();
+                }
+                else if (this->connections < this->max_connections)
+                {
+                    conn = std::make_shared<connection>(this->io_context->get_io_context(), this->ctx, this->secure);
+                    this->connections++;
+                }
+                else
+                {
+                    break;
+                }
+
+                ready.emplace_back(conn, std::make_shared<request>(std::move(this->requests.front())));
+                this->requests.pop_front();
+            }
+        }
+
+        for (auto& elem : ready)
+        {
+            this->start(elem.first, elem.second);
+        }
+    }
+
+
+    void
+    client::start(std::shared_ptr<connection> conn, std::shared_ptr<request> req)
+    {
+        if (conn->open)
+        {
+            this->send(conn, req);
+            return;
+        }
+
+        conn->resolver.async_resolve(this->host, this->port
+            , [weak_this = weak_from_this(), conn, req](const auto& ec, const auto& results)
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    if (ec)
+                    {
+                        strong_this->fail(conn, req, ec);
+                        return;
+                    }
+
+                    conn->lowest_layer().expires_after(HTTP_TIMEOUT);
+                    conn->lowest_layer().async_connect(results, [weak_this, conn, req](const auto& ec, const auto& /*endpoint*/)
+                    {
+                        if (auto strong_this = weak_this.lock())
+                        {
+                            if (ec)
+                            {
+                                strong_this->fail(conn, req, ec);
+                                return;
+                            }
+
+                            strong_this->connected(conn, req);
+                        }
+                    });
+                }
+            });
+    }
+
+
+    void
+    client::connected(std::shared_ptr<connection> conn, std::shared_ptr<request> req)
+    {
+        if (!conn->tls)
+        {
+            conn->open = true;
+            this->send(conn, req);
+            return;
+        }
+
+        // Set SNI Hostname (many hosts need this to handshake successfully)
+        if (!SSL_set_tlsext_host_name(conn->tls->native_handle(), this->host.c_str()))
+        {
+            this->fail(conn, req, boost::system::error_code{static_cast<int>(::ERR_get_error())
+                , boost::beast::net::error::get_ssl_category()});
+            return;
+        }
+
+        conn->tls->set_verify_mode(boost::asio::ssl::verify_peer);
+        conn->tls->set_verify_callback(boost::asio::ssl::rfc2818_verification(this->host));
+        conn->tls->async_handshake(boost::asio::ssl::stream_base::client
+            , [weak_this = weak_from_this(), conn, req](const auto& ec)
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    if (ec)
+                    {
+                        strong_this->fail(conn, req, ec);
+                        return;
+                    }
+
+                    conn->open = true;
+                    strong_this->send(conn, req);
+                }
+            });
+    }
+
+
+    void
+    client::send(std::shared_ptr<connection> conn, std::shared_ptr<request> req)
+    {
+        namespace http = boost::beast::http;
+
+        conn->req = http::request<http::string_body>{http::verb::get, this->path, 11};
+        conn->req.set(http::field::host, this->host);
+        conn->req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+        conn->req.keep_alive(true);
+
+        // post or get?
+        if (!req->post.empty())
+        {
+            conn->req.method(http::verb::post);
+            conn->req.body() = req->post;
+        }
+        conn->req.prepare_payload();
+
+        conn->lowest_layer().expires_after(HTTP_TIMEOUT);
+        conn->with_stream([&](auto& stream)
+        {
+            http::async_write(stream, conn->req, [weak_this = weak_from_this(), conn, req](const auto& ec, size_t /*bytes*/)
+            {
+                if (auto strong_this = weak_this.lock())
+                {
+                    if (ec)
+                    {
+                        strong_this->fail(conn, req, ec);
+                        return;
+                    }
+
+                    strong_this->receive(conn, req);
+                }
+            });
+        });
+    }
+
+
+    void
+    client::receive(std::shared_ptr<connection> conn, std::shared_ptr<request> req)
+    {
+        conn->res = {};
+        conn->with_stream([&](auto& stream)
+        {
+            boost::beast::http::async_read(stream, conn->buffer, conn->res
+                , [weak_this = weak_from_this(), conn, req](const auto& ec, size_t /*bytes*/)
+                {
+                    if (auto strong_this = weak_this.lock())
+                    {
+                        if (ec)
+                        {
+                            strong_this->fail(conn, req, ec);
+                            return;
+                        }
+
+                        strong_this->finish(conn, req);
+                    }
+                });
+        });
+    }
+
+
+    void
+    client::finish(std::shared_ptr<connection> conn, std::shared_ptr<request> req)
+    {
+        conn->uses++;
+        const bool keep_alive = conn->res.keep_alive();
+        const std::string body = std::move(conn->res.body());
+
+        if (keep_alive)
+        {
+            conn->lowest_layer().expires_never();
+        }
+        else
+        {
+            boost::system::error_code ec;
+            conn->lowest_layer().socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+            conn->lowest_layer().close();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            if (keep_alive)
+            {
+                this->idle.push_back(conn);
+            }
+            else
+            {
+                this->connections--;
+            }
+        }
+
+        req->handler(boost::system::error_code{}, body);
+        this->dispatch();
+    }
+
+
+    void
+    client::fail(std::shared_ptr<connection> conn, std::shared_ptr<request> req, const boost::system::error_code& ec)
+    {
+        // the server may have dropped a connection we kept alive, so give the request one more try on a new one
+        const bool retry = conn->uses && !req->retried;
+        conn->lowest_layer().close();
+
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->connections--;
+            if (retry)
+            {
+                req->retried = true;
+                this->requests.push_front(std::move(*req));
+            }
+        }
+
+        if (!retry)
+        {
+            LOG(warning) << "http request to " << this->host << " failed: " << ec.message();
+            req->handler(ec, {});
+        }
+
+        this->dispatch();
+    }
+
 } // namespace bzn::utils::http
@@ -16,6 +16,12 @@
 
 #pragma once
 
+#include <include/boost_asio_beast.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 
 
@@ -24,4 +30,48 @@ namespace bzn::utils::http
     // Performs an HTTP GET or POST and returns the body of the HTTP response
     std::string sync_req(const std::string& url, const std::string& post = "");
 
+    // Performs HTTP GETs and POSTs against one server on an io_context, with several requests in flight
+    // at once. Connections are kept alive and reused for later requests.
+    class client : public std::enable_shared_from_this<client>
+    {
+    public:
+        using response_handler = std::function<void(const boost::system::error_code& ec, const std::string& body)>;
+
+        client(std::shared_ptr<bzn::asio::io_context_base> io_context, const std::string& url, size_t max_connections = 8);
+
+        // handler receives the body of the response, or an error if the request couldn't be made
+        void async_req(const std::string& post, response_handler handler);
+
+    private:
+        struct connection;
+
+        struct request
+        {
+            std::string post;
+            response_handler handler;
+            bool retried = false;
+        };
+
+        const std::shared_ptr<bzn::asio::io_context_base> io_context;
+        boost::asio::ssl::context ctx;
+        std::string host;
+        std::string port;
+        std::string path;
+        bool secure = false;
+        const size_t max_connections;
+
+        std::mutex lock;
+        std::deque<request> requests;
+        std::vector<std::shared_ptr<connection>> idle;
+        size_t connections = 0;
+
+        void dispatch();
+        void start(std::shared_ptr<connection> conn, std::shared_ptr<request> req);
+        void connected(std::shared_ptr<connection> conn, std::shared_ptr<request> req);
+        void send(std::shared_ptr<connection> conn, std::shared_ptr<request> req);
+        void receive(std::shared_ptr<connection> conn, std::shared_ptr<request> req);
+        void finish(std::shared_ptr<connection> conn, std::shared_ptr<request> req);
+        void fail(std::shared_ptr<connection> conn, std::shared_ptr<request> req, const boost::system::error_code& ec);
+    };
+
 } // namespace bzn::http
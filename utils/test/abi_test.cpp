@@ -0,0 +1,213 @@
+//
+// Copyright (C) 2019 Bluzelle
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <utils/abi.hpp>
+#include <utils/esr_peer_info.hpp>
+#include <boost/algorithm/hex.hpp>
+#include <boost/algorithm/string.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+    // the line by line parser the decoder replaced, kept to compare against
+    std::vector<std::string>
+    legacy_parse_ids(const std::string& result)
+    {
+        std::vector<std::string> results;
+        size_t node_count{0};
+        enum { HEADER, HEADER_SWARM_SIZE, HEADER_INFO, PEER_ID_SIZE, PEER_ID } state{HEADER};
+        char line[65]{0};
+        size_t index{0};
+        std::string peer_id;
+        size_t peer_id_length{0};
+        std::istringstream stm(result);
+        while (stm.read(line, 64))
+        {
+            switch (state)
+            {
+            case HEADER:
+                state = HEADER_SWARM_SIZE;
+                break;
+            case HEADER_SWARM_SIZE:
+                state = HEADER_INFO;
+                node_count = std::strtoul(line, nullptr, 16);
+                if (!node_count)
+                {
+                    return results;
+                }
+                break;
+            case HEADER_INFO:
+                state = (index == node_count + 1 ? PEER_ID_SIZE : state);
+                break;
+            case PEER_ID_SIZE:
+                peer_id_length = std::strtoul(line, nullptr, 16);
+                state = peer_id_length ? PEER_ID : PEER_ID_SIZE;
+                break;
+            case PEER_ID:
+            {
+                std::stringstream strm;
+                boost::algorithm::unhex(std::string{line}, std::ostream_iterator<char>{strm, ""});
+                peer_id.append(strm.str());
+                if (peer_id.size() >= peer_id_length)
+                {
+                    boost::algorithm::trim_right_if(peer_id, [](auto& c) { return c == '\0'; });
+                    results.emplace_back(peer_id);
+                    peer_id = "";
+                    state = PEER_ID_SIZE;
+                }
+            }
+                break;
+            }
+            ++index;
+        }
+
+        return results;
+    }
+
+    // a string of the given length and padded bytes
+    std::string
+    encode_string(const std::string& value)
+    {
+        std::string hex = bzn::utils::abi::encode_uint(value.size());
+        bzn::utils::abi::append_hex(hex, value);
+        hex.append((64 - (value.size() * 2) % 64) % 64, '0');
+        return hex;
+    }
+
+    // the result of a call returning string[]
+    std::string
+    encode_ids(const std::vector<std::string>& ids)
+    {
+        std::string offsets;
+        std::string strings;
+        for (const auto& id : ids)
+        {
+            offsets.append(bzn::utils::abi::encode_uint(ids.size() * 32 + strings.size() / 2));
+            strings.append(encode_string(id));
+        }
+
+        return bzn::utils::abi::encode_uint(32) + bzn::utils::abi::encode_uint(ids.size()) + offsets + strings;
+    }
+
+    std::vector<std::string>
+    make_ids(size_t count)
+    {
+        std::vector<std::string> ids;
+        for (size_t i = 0; i < count; i++)
+        {
+            // some long enough to take more than one word
+            ids.push_back((i % 3 ? "node_" : "MFYwEAYHKoZIzj0CAQYFK4EEAAoDQgAE_") + std::to_string(i));
+        }
+
+        return ids;
+    }
+}
+
+
+TEST(abi_test, hex)
+{
+    std::string hex{"0x"};
+    bzn::utils::abi::append_hex(hex, std::string{"Hi\0\xff", 4});
+    EXPECT_EQ(hex, "0x486900ff");
+
+    EXPECT_EQ(bzn::utils::abi::from_hex("486900fF"), std::string("Hi\0\xff", 4));
+    EXPECT_THROW(bzn::utils::abi::from_hex("486"), std::runtime_error);
+    EXPECT_THROW(bzn::utils::abi::from_hex("48x9"), std::runtime_error);
+
+    EXPECT_EQ(bzn::utils::abi::encode_uint(0), std::string(64, '0'));
+    EXPECT_EQ(bzn::utils::abi::encode_uint(0x1f40), std::string(60, '0') + "1f40");
+}
+
+TEST(abi_test, encode_call)
+{
+    EXPECT_EQ(bzn::utils::abi::encode_call("0043d7e7", {}), "0x0043d7e7");
+    EXPECT_EQ(bzn::utils::abi::encode_call("cc8575cb", {"swarm", "node"}), "0xcc8575cb"
+        + bzn::utils::abi::encode_uint(0x40) + bzn::utils::abi::encode_uint(0x80)
+        + bzn::utils::abi::encode_uint(5) + "737761726d" + std::string(54, '0')
+        + bzn::utils::abi::encode_uint(4) + "6e6f6465" + std::string(56, '0'));
+}
+
+TEST(abi_test, decode_ids)
+{
+    auto ids = make_ids(50);
+    EXPECT_EQ(bzn::utils::esr::parse_ids_result("0x" + encode_ids(ids)), ids);
+    EXPECT_EQ(bzn::utils::esr::parse_ids_result(encode_ids(ids)), legacy_parse_ids(encode_ids(ids)));
+
+    // removed entries are skipped
+    EXPECT_EQ(bzn::utils::esr::parse_ids_result(encode_ids({"node_1", "", "node_3"})), std::vector<std::string>({"node_1", "node_3"}));
+    EXPECT_TRUE(bzn::utils::esr::parse_ids_result(encode_ids({})).empty());
+    EXPECT_TRUE(bzn::utils::esr::parse_ids_result("0x").empty());
+}
+
+TEST(abi_test, decode_peer_info)
+{
+    auto host = std::string{"a-rather-long-host-name.bluzelle.com"};
+    auto result = bzn::utils::abi::encode_uint(7) + bzn::utils::abi::encode_uint(4 * 32) + bzn::utils::abi::encode_uint(4 * 32 + 96)
+        + bzn::utils::abi::encode_uint(51010) + encode_string(host) + encode_string("node name");
+
+    auto peer = bzn::utils::esr::parse_peer_info_result("node_1", "0x" + result);
+    EXPECT_EQ(peer.host, host);
+    EXPECT_EQ(peer.port, 51010);
+    EXPECT_EQ(peer.name, "node name");
+    EXPECT_EQ(peer.uuid, "node_1");
+}
+
+TEST(abi_test, malformed)
+{
+    auto result = encode_ids(make_ids(3));
+
+    // not whole words
+    EXPECT_THROW(bzn::utils::abi::decoder(result.substr(1)), std::runtime_error);
+
+    // cut short
+    EXPECT_THROW(bzn::utils::esr::parse_ids_result(result.substr(0, result.size() - 64)), std::out_of_range);
+
+    // offsets that point outside the data
+    EXPECT_THROW(bzn::utils::abi::decoder(bzn::utils::abi::encode_uint(32 * 10) + bzn::utils::abi::encode_uint(1)).get_string_array(32 * 10)
+        , std::out_of_range);
+    EXPECT_THROW(bzn::utils::abi::decoder(bzn::utils::abi::encode_uint(1000) + bzn::utils::abi::encode_uint(0)).get_string(0), std::out_of_range);
+
+    // values too large for their type
+    EXPECT_THROW(bzn::utils::abi::decoder(std::string(64, 'f')).get_uint(0), std::out_of_range);
+}
+
+TEST(abi_test, DISABLED_benchmark)
+{
+    const auto result = encode_ids(make_ids(20000));
+    const size_t runs = 20;
+
+    auto time = [&](auto parse)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < runs; i++)
+        {
+            EXPECT_EQ(parse(result).size(), 20000u);
+        }
+
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start) / runs;
+    };
+
+    auto legacy = time(legacy_parse_ids);
+    auto decoder = time([](const std::string& result)
+    {
+        return bzn::utils::esr::parse_ids_result(result);
+    });
+
+    std::cout << "20000 ids: line parser " << legacy.count() << "us, decoder " << decoder.count() << "us" << std::endl;
+}